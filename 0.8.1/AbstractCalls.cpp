@@ -13,6 +13,11 @@
     namespace HUD = UI;
 #endif
 
+#ifdef TARGET_GAME_GTAV
+// ScriptHookV export (normally from the SDK main.h, which our own main.h shadows)
+__declspec(dllimport) int worldGetAllPeds(int* arr, int arrSize);
+#endif
+
 namespace AbstractGame {
 
     // =============================================================
@@ -108,6 +113,17 @@ namespace AbstractGame {
         return { 0.0f, 0.0f, 0.0f };
     }
 
+    AVec3 GetEntityForwardVector(AHandle entity) {
+#ifdef TARGET_GAME_GTAV
+        int id = ToGtaID(entity);
+        if (ENTITY::DOES_ENTITY_EXIST(id)) {
+            Vector3 v = ENTITY::GET_ENTITY_FORWARD_VECTOR(id);
+            return ToAVec(v);
+        }
+#endif
+        return { 0.0f, 0.0f, 0.0f };
+    }
+
     float GetDistance(AVec3 a, AVec3 b) {
         float dx = a.x - b.x;
         float dy = a.y - b.y;
@@ -207,6 +223,20 @@ namespace AbstractGame {
         return AbstractTypes::INVALID_HANDLE;
     }
 
+    std::vector<AHandle> GetNearbyPeds(AVec3 center, float radius, int maxCount) {
+        std::vector<AHandle> result;
+#ifdef TARGET_GAME_GTAV
+        static int peds[256];
+        int count = worldGetAllPeds(peds, 256);
+        for (int i = 0; i < count && (int)result.size() < maxCount; ++i) {
+            if (!ENTITY::DOES_ENTITY_EXIST(peds[i])) continue;
+            Vector3 v = ENTITY::GET_ENTITY_COORDS(peds[i], true);
+            if (GetDistance(center, ToAVec(v)) <= radius) result.push_back((AHandle)peds[i]);
+        }
+#endif
+        return result;
+    }
+
     void ClearTasks(AHandle entity) {
 #ifdef TARGET_GAME_GTAV
         int id = ToGtaID(entity);
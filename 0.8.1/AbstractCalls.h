@@ -21,6 +21,7 @@ namespace AbstractGame {
     bool IsEntityValid(AHandle entity);
     bool IsEntityDead(AHandle entity);
     AVec3 GetEntityPosition(AHandle entity);
+    AVec3 GetEntityForwardVector(AHandle entity);
     float GetDistanceBetweenEntities(AHandle e1, AHandle e2);
 
     // Logic
@@ -40,6 +41,7 @@ namespace AbstractGame {
 
     // World
     AHandle GetClosestPed(AVec3 center, float radius, AHandle ignoreEntity);
+    std::vector<AHandle> GetNearbyPeds(AVec3 center, float radius, int maxCount);
     AbstractTypes::ModelID GetEntityModel(AHandle entity);
     bool IsPedHuman(AHandle entity);
     bool IsPedMale(AHandle entity);
@@ -0,0 +1,292 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <algorithm>
+#include <map>
+#include "main.h"
+#include "SharedData.h"
+#include "AmbientDialogue.h"
+
+// ------------------------------------------------------------
+// AMBIENT DIALOGUE
+// Picks two idle NPCs standing next to each other near the player and lets them
+// talk for a few lines. Every line is one AMBIENT request in the BatchScheduler,
+// which preempts it as soon as the player needs the model. A token bucket keeps
+// the whole subsystem under Ambient_Tokens_Per_Minute.
+// ------------------------------------------------------------
+
+// --- STATE ---
+enum class AmbientPhase { IDLE, GENERATING, SPEAKING };
+
+struct AmbientExchange {
+    AHandle peds[2] = { 0, 0 };
+    std::string names[2];
+    NpcPersona personas[2];
+    ChatID chatID = 0;
+    std::vector<std::string> lines; // "Name: text"
+    int speaker = 0;                // index of the NPC talking next
+    int linesLeft = 0;
+    bool wantsToEnd = false;
+    uint64_t ticket = 0;            // REPLY_READY of the line being generated
+    bool replied = false;
+    std::string reply;
+    TimeMillis phaseSince = 0;
+    TimeMillis nextLineAt = 0;
+};
+
+static AmbientPhase g_phase = AmbientPhase::IDLE;
+static AmbientExchange g_exchange;
+static float g_tokenBucket = 0.0f;
+static TimeMillis g_lastRefill = 0;
+static TimeMillis g_lastScan = 0;
+static TimeMillis g_nextExchangeAt = 0;
+static std::map<AHandle, TimeMillis> g_recentPeds; // ped -> time it last talked
+
+static const TimeMillis SCAN_INTERVAL_MS = 2000;
+static const TimeMillis GENERATION_TIMEOUT_MS = 20000;
+static const TimeMillis WAIT_FOR_BUDGET_MS = 10000;
+
+// --- HELPERS ---
+static void RefillBudget(TimeMillis now) {
+    const float capacity = (float)ConfigReader::g_Settings.Ambient_Tokens_Per_Minute;
+    if (g_lastRefill == 0) { g_lastRefill = now; g_tokenBucket = capacity; return; }
+    float perMs = capacity / 60000.0f;
+    g_tokenBucket = std::min(capacity, g_tokenBucket + perMs * (float)(now - g_lastRefill));
+    g_lastRefill = now;
+}
+
+// Budget for one more line, with one slot always left free for the player (and frame time to spare)
+static bool HasHeadroom() {
+    return g_tokenBucket >= (float)ConfigReader::g_Settings.Ambient_Max_Tokens &&
+        BatchScheduler::GetFreeSlots() >= 2 && !CpuGovernor::ThrottleBackground();
+}
+
+static bool IsInteractiveIdle() {
+    return g_convo_state == ConvoState::IDLE && g_input_state == InputState::IDLE && g_llm_state == InferenceState::IDLE;
+}
+
+static bool IsFailedResult(const std::string& s) {
+    return s.empty() || s == "LLM_NOT_INITIALIZED" || s == "LLM_ERROR" || s == "TOKENIZATION_FAILED" || s == "CTX_FAIL";
+}
+
+static bool IsPedAvailable(AHandle ped, AHandle playerPed) {
+    return ped != playerPed && ped != g_target_ped && IsEntityValid(ped) && IsPedHuman(ped) &&
+        !IsEntityDead(ped) && !IsEntityInCombat(ped) && !IsEntityInVehicle(ped) && !IsEntityFleeing(ped);
+}
+
+static bool PairStillValid(AHandle playerPed) {
+    const auto& s = ConfigReader::g_Settings;
+    for (AHandle ped : g_exchange.peds) {
+        if (!IsPedAvailable(ped, playerPed)) return false;
+        if (GetDistanceBetweenEntities(ped, playerPed) > s.Ambient_Radius * 1.5f) return false;
+    }
+    return GetDistanceBetweenEntities(g_exchange.peds[0], g_exchange.peds[1]) <= s.Ambient_Pair_Distance * 1.5f;
+}
+
+// Closest pair to the player that hasn't talked recently
+static bool FindPair(AHandle playerPed, TimeMillis now, AHandle& outA, AHandle& outB) {
+    const auto& s = ConfigReader::g_Settings;
+    const TimeMillis cooldown = (TimeMillis)s.Ambient_Cooldown_Sec * 1000 * 4;
+
+    for (auto it = g_recentPeds.begin(); it != g_recentPeds.end();) {
+        if (now - it->second > cooldown) it = g_recentPeds.erase(it);
+        else ++it;
+    }
+
+    std::vector<AHandle> candidates;
+    for (AHandle ped : GetNearbyPeds(GetEntityPosition(playerPed), s.Ambient_Radius, 32)) {
+        if (g_recentPeds.count(ped)) continue;
+        if (IsPedAvailable(ped, playerPed)) candidates.push_back(ped);
+    }
+
+    float best = 1e9f;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        for (size_t j = i + 1; j < candidates.size(); ++j) {
+            if (GetDistanceBetweenEntities(candidates[i], candidates[j]) > s.Ambient_Pair_Distance) continue;
+            float d = GetDistanceBetweenEntities(candidates[i], playerPed) + GetDistanceBetweenEntities(candidates[j], playerPed);
+            if (d < best) { best = d; outA = candidates[i]; outB = candidates[j]; }
+        }
+    }
+    return best < 1e9f;
+}
+
+static std::string BuildLinePrompt() {
+    const int me = g_exchange.speaker;
+    const int other = 1 - me;
+    const NpcPersona& p = g_exchange.personas[me];
+    const NpcPersona& o = g_exchange.personas[other];
+
+    std::stringstream ss;
+    ss << "<|system|>\n";
+    ss << "Two people meet on the street and chat briefly.\n";
+    ss << "YOUR CHARACTER:\n";
+    ss << "- Name: " << g_exchange.names[me] << "\n";
+    ss << "- Gender: " << p.gender << "\n";
+    ss << "- Role: " << p.type << " / " << p.subGroup << "\n";
+    ss << "- Traits: " << p.behaviorTraits << "\n";
+    ss << "\nSCENARIO:\n";
+    ss << "- Time: " << GetCurrentTimeState() << "\n";
+    ss << "- Location: " << GetZoneName(GetEntityPosition(g_exchange.peds[me])) << "\n";
+    ss << "- Talking to: " << g_exchange.names[other] << " (Role: " << o.type << " / " << o.subGroup << ")\n";
+    ss << "\nINSTRUCTIONS:\n";
+    ss << "- Speak ONLY as " << g_exchange.names[me] << ". One short sentence, casual small talk.\n";
+    ss << "- Do not write lines for " << g_exchange.names[other] << ".\n";
+    if (g_exchange.linesLeft <= 1) ss << "- This is your last line, say goodbye.\n";
+    ss << "<|end|>\n";
+
+    if (!g_exchange.lines.empty()) {
+        ss << "\nCHAT HISTORY:\n";
+        for (const auto& line : g_exchange.lines) ss << line << "\n";
+    }
+    ss << "\n<|assistant|>\n";
+    return ss.str();
+}
+
+static bool RequestNextLine(TimeMillis now) {
+    if (!HasHeadroom()) return false;
+    g_tokenBucket -= (float)ConfigReader::g_Settings.Ambient_Max_Tokens; // reserve the worst case up front
+
+    GenRequest req;
+    req.prompt = BuildLinePrompt();
+    req.priority = GenPriority::AMBIENT;
+    req.speakerName = g_exchange.names[1 - g_exchange.speaker]; // stop before the other NPC's turn
+    req.maxTokens = ConfigReader::g_Settings.Ambient_Max_Tokens;
+    req.abortOnConvoEnd = false; // there is no player conversation to end
+
+    req.ticket = g_exchange.ticket = EventQueue::NewTicket();
+    g_exchange.replied = false;
+
+    BatchScheduler::Submit(std::move(req));
+    g_exchange.phaseSince = now;
+    g_phase = AmbientPhase::GENERATING;
+    return true;
+}
+
+static void Finish(TimeMillis now) {
+    if (g_exchange.chatID != 0) ConvoManager::CloseConversation(g_exchange.chatID);
+    for (AHandle ped : g_exchange.peds) if (ped) g_recentPeds[ped] = now;
+
+    Log("AMBIENT: Exchange between " + g_exchange.names[0] + " and " + g_exchange.names[1] +
+        " ended after " + std::to_string(g_exchange.lines.size()) + " lines.");
+    g_exchange = AmbientExchange();
+    g_phase = AmbientPhase::IDLE;
+    g_nextExchangeAt = now + (TimeMillis)ConfigReader::g_Settings.Ambient_Cooldown_Sec * 1000;
+}
+
+static void DeliverLine(const std::string& text, AHandle playerPed, VoiceBridge* bridge, TimeMillis now) {
+    const int me = g_exchange.speaker;
+    const std::string& name = g_exchange.names[me];
+    AHandle ped = g_exchange.peds[me];
+
+    std::string line = text;
+    if (line.rfind(name + ":", 0) == 0) line = line.substr(name.length() + 1);
+    size_t start = line.find_first_not_of(" \t\n\r");
+    line = (start == std::string::npos) ? "" : line.substr(start);
+
+    if (line.find("Bye") != std::string::npos || line.find("bye") != std::string::npos ||
+        line.find("[END_CONVERSATION]") != std::string::npos) {
+        g_exchange.wantsToEnd = true;
+    }
+
+    g_exchange.lines.push_back(name + ": " + line);
+    ConvoManager::AddMessageToChat(g_exchange.chatID, name, name + ": " + line);
+
+    // Roughly the time it takes to read (or hear) the line
+    int durationMs = 1500 + (int)line.length() * 60;
+
+    if (GetDistanceBetweenEntities(ped, playerPed) <= ConfigReader::g_Settings.Ambient_Radius) {
+        ShowSubtitle(name + ": " + line, durationMs);
+        if (ConfigReader::g_Settings.TtS_Enabled && bridge && bridge->IsConnected() && bridge->IsReady()) {
+            bridge->Send(line, GetOrAssignNpcVoiceId(ped));
+        }
+    }
+
+    TaskLookAtEntity(ped, g_exchange.peds[1 - me], durationMs);
+    g_exchange.linesLeft--;
+    g_exchange.speaker = 1 - me;
+    g_exchange.nextLineAt = now + (TimeMillis)durationMs;
+    g_exchange.phaseSince = now;
+    g_phase = AmbientPhase::SPEAKING;
+}
+
+// --- PUBLIC ---
+void AmbientDialogue::Update(VoiceBridge* bridge) {
+    const auto& s = ConfigReader::g_Settings;
+    if (!s.Ambient_Enabled || !g_isInitialized) return;
+
+    TimeMillis now = GetTimeMs();
+    RefillBudget(now);
+    AHandle playerPed = GetPlayerHandle();
+
+    if (g_phase != AmbientPhase::IDLE) {
+        if (!IsInteractiveIdle() || !IsGameInSafeMode()) { Abort("interactive path busy"); return; }
+        if (!PairStillValid(playerPed)) { Abort("pair lost"); return; }
+    }
+
+    switch (g_phase) {
+    case AmbientPhase::IDLE: {
+        if (!IsInteractiveIdle() || now < g_nextExchangeAt || now < g_lastScan + SCAN_INTERVAL_MS) return;
+        g_lastScan = now;
+        if (!IsGameInSafeMode() || !HasHeadroom()) return;
+
+        AHandle a = 0, b = 0;
+        if (!FindPair(playerPed, now, a, b)) return;
+
+        g_exchange = AmbientExchange();
+        g_exchange.peds[0] = a;
+        g_exchange.peds[1] = b;
+        for (int i = 0; i < 2; ++i) {
+            g_exchange.personas[i] = ConfigReader::GetPersona(g_exchange.peds[i]);
+            const NpcPersona& p = g_exchange.personas[i];
+            g_exchange.names[i] = !p.inGameName.empty() ? p.inGameName : GenerateNpcName(p);
+        }
+        g_exchange.chatID = ConvoManager::InitiateConversation(a, b);
+        g_exchange.linesLeft = s.Ambient_Max_Lines;
+        g_exchange.speaker = rand() % 2;
+
+        Log("AMBIENT: Starting exchange " + std::to_string(g_exchange.chatID) + " between " +
+            g_exchange.names[0] + " and " + g_exchange.names[1]);
+        if (!RequestNextLine(now)) Finish(now);
+        break;
+    }
+
+    case AmbientPhase::GENERATING: {
+        if (!g_exchange.replied) {
+            if (now - g_exchange.phaseSince > GENERATION_TIMEOUT_MS) Abort("generation timeout");
+            return;
+        }
+        std::string text = std::move(g_exchange.reply);
+        g_exchange.replied = false;
+        if (IsFailedResult(text)) { Finish(now); return; }
+        DeliverLine(text, playerPed, bridge, now);
+        break;
+    }
+
+    case AmbientPhase::SPEAKING: {
+        if (now < g_exchange.nextLineAt) return;
+        if (g_exchange.linesLeft <= 0 || g_exchange.wantsToEnd) { Finish(now); return; }
+        if (!RequestNextLine(now) && now - g_exchange.phaseSince > WAIT_FOR_BUDGET_MS) Finish(now);
+        break;
+    }
+    }
+}
+
+void AmbientDialogue::OnReplyReady(const CompletionEvent& ev) {
+    if (g_phase != AmbientPhase::GENERATING || ev.ticket == 0 || ev.ticket != g_exchange.ticket) return;
+    g_exchange.reply = ev.text;
+    g_exchange.replied = true;
+}
+
+void AmbientDialogue::Abort(const std::string& reason) {
+    if (g_phase == AmbientPhase::IDLE) return;
+    Log("AMBIENT: Aborted (" + reason + ")");
+    BatchScheduler::Cancel(GenPriority::AMBIENT);
+    Finish(GetTimeMs());
+}
+
+bool AmbientDialogue::IsActive() {
+    return g_phase != AmbientPhase::IDLE;
+}
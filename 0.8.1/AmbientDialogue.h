@@ -0,0 +1,19 @@
+#pragma once
+// AmbientDialogue.h
+#include <string>
+
+class VoiceBridge;
+struct CompletionEvent;
+
+// Short NPC-to-NPC exchanges near the player, generated at GenPriority::AMBIENT.
+// Runs only while the interactive path is idle and within Ambient_Tokens_Per_Minute.
+class AmbientDialogue {
+public:
+    // Called once per script tick. Cheap when nothing is due.
+    static void Update(VoiceBridge* bridge);
+    // REPLY_READY handler, picks up the line it is waiting for
+    static void OnReplyReady(const CompletionEvent& ev);
+    // Ends the running exchange (e.g. the player starts talking to someone)
+    static void Abort(const std::string& reason);
+    static bool IsActive();
+};
@@ -0,0 +1,192 @@
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "main.h"
+#include "AsyncLogger.h"
+#include "ThreadExit.h"
+
+// ------------------------------------------------------------
+// ASYNC LOGGER
+// Bounded multi-producer ring (per-cell sequence numbers, Vyukov style).
+// A producer claims a cell with one CAS and moves its text in; the writer
+// thread drains in batches, formats the timestamp once per second and
+// flushes every touched file once per batch. The old path opened, wrote and
+// closed a std::ofstream per message, from several threads at once.
+// ------------------------------------------------------------
+
+// --- STATE ---
+struct LogRecord {
+    std::chrono::system_clock::time_point time;
+    LogFile file = LogFile::MAIN;
+    const char* tag = nullptr;
+    std::string text;
+};
+
+struct LogCell {
+    std::atomic<size_t> seq{ 0 };
+    LogRecord rec;
+};
+
+static const size_t RING_SIZE = 8192; // power of two
+static const size_t RING_MASK = RING_SIZE - 1;
+static const int IDLE_SLEEP_MS = 20;
+
+static LogCell* CreateRing() {
+    LogCell* ring = new LogCell[RING_SIZE];
+    for (size_t i = 0; i < RING_SIZE; ++i) ring[i].seq.store(i, std::memory_order_relaxed);
+    return ring;
+}
+
+// Built during static init, so Log() works in DllMain already. Records wait here until Start().
+static LogCell* g_ring = CreateRing();
+static std::atomic<size_t> g_enqueue_pos{ 0 };
+static size_t g_dequeue_pos = 0; // writer thread only
+
+static std::once_flag g_start_once;
+static std::thread g_writer;
+static std::atomic<bool> g_writer_running{ false };
+static std::atomic<bool> g_writer_done{ false };
+static std::atomic<uint64_t> g_dropped{ 0 };
+static std::atomic<bool> g_truncate[(int)LogFile::COUNT];
+
+std::atomic<int> AsyncLogger::g_Level{ (int)LogLevel::INFO };
+
+// --- WRITER THREAD ---
+static std::string FileName(LogFile file) {
+    switch (file) {
+    case LogFile::MAIN:    return LOG_FILE_NAME;
+    case LogFile::METRICS: return LOG_FILE_NAME_METRICS;
+    case LogFile::AUDIO:   return LOG_FILE_NAME_AUDIO;
+    case LogFile::LOAD:    return LOG_FILE_NAME3;
+    case LogFile::AUDIO2:  return "kkamel_audio2.log";
+    case LogFile::LOADER:  return "kkamel_loader.log";
+    default:               return LOG_FILE_NAME;
+    }
+}
+
+static bool Dequeue(LogRecord& out) {
+    LogCell& cell = g_ring[g_dequeue_pos & RING_MASK];
+    if (cell.seq.load(std::memory_order_acquire) != g_dequeue_pos + 1) return false; // empty or still being written
+    out = std::move(cell.rec);
+    cell.seq.store(g_dequeue_pos + RING_SIZE, std::memory_order_release);
+    g_dequeue_pos++;
+    return true;
+}
+
+static void WriterLoop() {
+    std::ofstream files[(int)LogFile::COUNT];
+    bool touched[(int)LogFile::COUNT] = {};
+    std::time_t stampSecond = 0;
+    char stamp[32] = { 0 };
+    uint64_t droppedReported = 0;
+
+    LogRecord rec;
+    while (true) {
+        bool stopping = !g_writer_running.load(std::memory_order_acquire);
+
+        for (int i = 0; i < (int)LogFile::COUNT; ++i) {
+            if (!g_truncate[i].exchange(false)) continue;
+            if (files[i].is_open()) files[i].close();
+            files[i].open(FileName((LogFile)i), std::ios::trunc);
+        }
+
+        int written = 0;
+        while (written < (int)RING_SIZE && Dequeue(rec)) {
+            int f = (int)rec.file;
+            if (!files[f].is_open()) files[f].open(FileName(rec.file), std::ios::app);
+            if (!files[f]) continue;
+
+            std::time_t t = std::chrono::system_clock::to_time_t(rec.time);
+            if (t != stampSecond) {
+                stampSecond = t;
+                std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+            }
+            files[f] << "[" << stamp << "] ";
+            if (rec.tag) files[f] << "[" << rec.tag << "] ";
+            files[f] << rec.text << "\n";
+            touched[f] = true;
+            written++;
+        }
+
+        uint64_t dropped = g_dropped.load(std::memory_order_relaxed);
+        if (dropped != droppedReported && files[(int)LogFile::MAIN]) {
+            files[(int)LogFile::MAIN] << "[" << stamp << "] [Logger] " << (dropped - droppedReported) << " messages dropped (ring full)\n";
+            touched[(int)LogFile::MAIN] = true;
+            droppedReported = dropped;
+        }
+
+        for (int i = 0; i < (int)LogFile::COUNT; ++i) {
+            if (touched[i]) files[i].flush();
+            touched[i] = false;
+        }
+
+        if (written == 0) {
+            if (stopping) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_SLEEP_MS));
+        }
+    }
+    for (auto& f : files) if (f.is_open()) f.close();
+    g_writer_done = true;
+}
+
+static void StartWriter() {
+    g_writer_running = true;
+    g_writer = std::thread(WriterLoop);
+}
+
+// --- API ---
+void AsyncLogger::Start() {
+    std::call_once(g_start_once, StartWriter);
+}
+
+void AsyncLogger::Write(LogFile file, const char* tag, const std::string& message) {
+    size_t pos = g_enqueue_pos.load(std::memory_order_relaxed);
+    LogCell* cell = nullptr;
+    while (true) {
+        cell = &g_ring[pos & RING_MASK];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (g_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (diff < 0) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed); // full, the writer can't keep up
+            return;
+        }
+        else {
+            pos = g_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->rec.time = std::chrono::system_clock::now();
+    cell->rec.file = file;
+    cell->rec.tag = tag;
+    cell->rec.text = message;
+    cell->seq.store(pos + 1, std::memory_order_release);
+}
+
+void AsyncLogger::Truncate(LogFile file) {
+    g_truncate[(int)file] = true;
+}
+
+void AsyncLogger::Shutdown() {
+    if (!g_writer_running.exchange(false)) return;
+    WaitForThreadExit([] { return g_writer_done.load(); }); // no join, see ThreadExit.h
+    if (g_writer.joinable()) g_writer.detach();
+}
+
+uint64_t AsyncLogger::GetDropped() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+void AsyncLogger::SetLevel(int debugLevel) {
+    int level = (int)LogLevel::INFO + std::max(0, debugLevel);
+    level = std::min(level, std::min((int)LogLevel::TRACE, KK_LOG_MAX_LEVEL));
+    g_Level.store(level, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#pragma once
+// AsyncLogger.h
+#include <string>
+#include <cstdint>
+#include <atomic>
+
+// --- LEVELS ---
+// Plain Log*(...) calls are INFO. DEBUG_LEVEL in the INI adds levels: 0 = info, 1 = + debug, 2 = + trace.
+enum class LogLevel : int { ERR = 0, WARN = 1, INFO = 2, DEBUG = 3, TRACE = 4 };
+
+// Compile-time floor: macros above it expand to nothing, the message is never built.
+#ifndef KK_LOG_MAX_LEVEL
+#ifdef NDEBUG
+#define KK_LOG_MAX_LEVEL 3
+#else
+#define KK_LOG_MAX_LEVEL 4
+#endif
+#endif
+
+// Target files of the Log* functions
+enum class LogFile : uint8_t {
+    MAIN,    // LOG_FILE_NAME (Log, LogLLM, LogHelpers)
+    METRICS, // LOG_FILE_NAME_METRICS (LogM)
+    AUDIO,   // LOG_FILE_NAME_AUDIO (LogA)
+    LOAD,    // LOG_FILE_NAME3 (LLM_Inference LogM)
+    AUDIO2,  // kkamel_audio2.log (LLM_Inference LogA)
+    LOADER,  // kkamel_loader.log (LogConfig)
+    COUNT
+};
+
+// Single logging backend. Producers push records into a lock-free ring,
+// one writer thread formats timestamps and appends them to files it keeps open.
+class AsyncLogger {
+public:
+    // Starts the writer thread (ScriptMain, never DllMain). Records written before are kept.
+    static void Start();
+    // Thread safe, never blocks and never touches the disk. Drops the record if the ring is full.
+    // tag: "[tag] " prefix after the timestamp, nullptr = none. Must be a string literal.
+    static void Write(LogFile file, const char* tag, const std::string& message);
+    // Empties the file when the writer (re)opens it (DllMain, fresh log per session)
+    static void Truncate(LogFile file);
+    // Writes out what is queued and stops the writer. Safe to call from DllMain.
+    static void Shutdown();
+    static uint64_t GetDropped();
+
+    // Runtime threshold (LogLevel as int), set from DEBUG_LEVEL after the INI is read
+    static void SetLevel(int debugLevel);
+    static std::atomic<int> g_Level;
+};
+
+// One relaxed load + compare. The message expression is only evaluated when this is true.
+inline bool LogEnabled(LogLevel level) {
+    return (int)level <= AsyncLogger::g_Level.load(std::memory_order_relaxed);
+}
+
+// Usage: LOG_DEBUG(LogLLM, "n_past " + std::to_string(n));
+#define KK_LOG_IF(level, fn, ...) do { if (LogEnabled(level)) fn(__VA_ARGS__); } while (0)
+#define LOG_ERROR(fn, ...) KK_LOG_IF(LogLevel::ERR, fn, __VA_ARGS__)
+#define LOG_WARN(fn, ...)  KK_LOG_IF(LogLevel::WARN, fn, __VA_ARGS__)
+#define LOG_INFO(fn, ...)  KK_LOG_IF(LogLevel::INFO, fn, __VA_ARGS__)
+#if KK_LOG_MAX_LEVEL >= 3
+#define LOG_DEBUG(fn, ...) KK_LOG_IF(LogLevel::DEBUG, fn, __VA_ARGS__)
+#else
+#define LOG_DEBUG(fn, ...) ((void)0)
+#endif
+#if KK_LOG_MAX_LEVEL >= 4
+#define LOG_TRACE(fn, ...) KK_LOG_IF(LogLevel::TRACE, fn, __VA_ARGS__)
+#else
+#define LOG_TRACE(fn, ...) ((void)0)
+#endif
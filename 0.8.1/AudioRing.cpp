@@ -0,0 +1,62 @@
+#define NOMINMAX
+#include <algorithm>
+#include <cstring>
+#include "AudioRing.h"
+
+// ------------------------------------------------------------
+// AUDIO RING
+// Read and write positions only ever grow; the index into the buffer is
+// position & mask. The producer publishes samples with a release store of
+// m_write, the consumer frees space with a release store of m_read.
+// ------------------------------------------------------------
+
+bool AudioRing::Init(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    try { m_buffer.assign(size, 0.0f); }
+    catch (...) { m_buffer.clear(); m_mask = 0; return false; }
+    m_mask = size - 1;
+    Reset();
+    return true;
+}
+
+size_t AudioRing::Write(const float* data, size_t count) {
+    if (m_buffer.empty()) return 0;
+    const uint64_t w = m_write.load(std::memory_order_relaxed);
+    const uint64_t r = m_read.load(std::memory_order_acquire);
+    const size_t space = m_buffer.size() - (size_t)(w - r);
+    const size_t n = std::min(count, space);
+    if (n < count) m_dropped.fetch_add(count - n, std::memory_order_relaxed);
+    if (n == 0) return 0;
+
+    const size_t start = (size_t)w & m_mask;
+    const size_t first = std::min(n, m_buffer.size() - start);
+    std::memcpy(&m_buffer[start], data, first * sizeof(float));
+    if (n > first) std::memcpy(&m_buffer[0], data + first, (n - first) * sizeof(float));
+    m_write.store(w + n, std::memory_order_release);
+    return n;
+}
+
+size_t AudioRing::ReadInto(std::vector<float>& out, size_t maxCount) {
+    const uint64_t r = m_read.load(std::memory_order_relaxed);
+    const uint64_t w = m_write.load(std::memory_order_acquire);
+    const size_t n = std::min((size_t)(w - r), maxCount);
+    if (n == 0) return 0;
+
+    const size_t start = (size_t)r & m_mask;
+    const size_t first = std::min(n, m_buffer.size() - start);
+    out.insert(out.end(), m_buffer.begin() + start, m_buffer.begin() + start + first);
+    if (n > first) out.insert(out.end(), m_buffer.begin(), m_buffer.begin() + (n - first));
+    m_read.store(r + n, std::memory_order_release);
+    return n;
+}
+
+size_t AudioRing::Available() const {
+    return (size_t)(m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_relaxed));
+}
+
+void AudioRing::Reset() {
+    m_write.store(0, std::memory_order_relaxed);
+    m_read.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#pragma once
+// AudioRing.h
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free single-producer / single-consumer ring of float samples.
+// Storage is allocated once in Init; Write and Read never allocate or block,
+// so the producer may be a real-time audio callback.
+class AudioRing {
+public:
+    // Not thread safe. Rounds the capacity up to a power of two.
+    bool Init(size_t capacity);
+    // Producer only. Writes what fits, the rest is counted as dropped.
+    size_t Write(const float* data, size_t count);
+    // Consumer only. Appends up to maxCount samples to 'out' (no reallocation within its capacity).
+    size_t ReadInto(std::vector<float>& out, size_t maxCount = SIZE_MAX);
+    size_t Available() const;
+    size_t Capacity() const { return m_buffer.size(); }
+    // Only while the producer is stopped
+    void Reset();
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<float> m_buffer;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<uint64_t> m_write{ 0 }; // total samples written
+    alignas(64) std::atomic<uint64_t> m_read{ 0 };  // total samples read
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
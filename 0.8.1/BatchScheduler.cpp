@@ -0,0 +1,699 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include "main.h"
+#include "BatchScheduler.h"
+#include "ThreadExit.h"
+
+// ------------------------------------------------------------
+// BATCH SCHEDULER (continuous batching)
+// A single decode thread owns g_ctx. Every step packs the pending token of each
+// running sequence (plus prompt chunks of newly admitted requests) into one
+// llama_batch, each request on its own seq_id. Requests are admitted between
+// steps and retire on their own, so a summary no longer blocks the player's
+// reply and neither of them races the other on the context.
+// With PREFIX_CACHE a finished sequence stays in the KV (CACHED). The next prompt
+// that starts with the same tokens takes that slot and only decodes the rest.
+// ------------------------------------------------------------
+
+// --- STATE ---
+enum class SlotPhase { FREE, PREFILL, GENERATING, CACHED };
+
+struct PendingRequest {
+    GenRequest req;
+    std::promise<std::string> promise;
+    uint64_t id = 0;
+    std::chrono::high_resolution_clock::time_point submitted;
+};
+
+struct SeqSlot {
+    SlotPhase phase = SlotPhase::FREE;
+    llama_seq_id seq = 0;
+    std::unique_ptr<PendingRequest> job;
+
+    std::vector<llama_token> tokens;     // prompt + accepted reply tokens
+    std::vector<llama_token> stopTokens;
+    std::string text;
+    int32_t n_prompt = 0;
+    int32_t n_prefilled = 0; // prompt tokens already in the KV
+    int32_t n_reused = 0;    // ... of which came from a cached prefix
+    int32_t n_past = 0;      // KV length of this sequence while generating
+    int32_t reserved = 0;    // KV cells promised to this request at admission
+    int32_t chunk = 0;       // prompt rows in the current batch
+    int32_t i_batch = -1;    // first batch row with logits for this slot, -1 = none this step
+    int n_gen = 0;
+    int maxTokens = 0;
+    llama_token pending = -1; // accepted, not yet decoded
+
+    bool speculative = false;
+    std::vector<llama_token> draft;
+    SpecTurnStats specStats;
+
+    std::chrono::high_resolution_clock::time_point start;
+    std::chrono::high_resolution_clock::time_point genStart; // prefill done
+    uint64_t lastUsed = 0; // LRU stamp while CACHED
+};
+
+static std::thread g_sched_thread;
+static std::mutex g_sched_mutex; // guards everything up to g_next_id
+static std::condition_variable g_sched_cv;
+static std::deque<std::unique_ptr<PendingRequest>> g_pending;
+static std::vector<GenPriority> g_cancel_queue;
+static bool g_clear_requested = false;
+static bool g_sched_running = false;
+static uint64_t g_next_id = 1;
+static std::atomic<bool> g_sched_done{ true }; // set by the decode thread as its last step
+
+static const int SCHED_EXIT_WAIT_MS = 2000; // one llama_decode of a full batch can take a while on CPU
+
+static std::vector<SeqSlot> g_slots; // decode thread only
+static std::atomic<int> g_active_slots{ 0 };
+static int g_slot_count = 0;
+static uint64_t g_use_tick = 0;
+
+static const int32_t MIN_PREFIX_REUSE = 16; // shorter matches aren't worth pinning a slot
+
+// --- HELPERS ---
+static bool IsActive(const SeqSlot& s) {
+    return s.phase == SlotPhase::PREFILL || s.phase == SlotPhase::GENERATING;
+}
+
+static bool AnyActive() {
+    for (const auto& s : g_slots) if (IsActive(s)) return true;
+    return false;
+}
+
+static int32_t ReservedCells() {
+    int32_t total = 0;
+    for (const auto& s : g_slots) if (s.phase != SlotPhase::FREE) total += s.reserved;
+    return total;
+}
+
+// Leading tokens of this slot that are valid in the KV and may be handed to a new request.
+// A warm-up that is still prefilling can be taken over as well.
+static int32_t ReusableTokens(const SeqSlot& s) {
+    if (s.phase == SlotPhase::CACHED) return (int32_t)s.tokens.size();
+    if (s.phase == SlotPhase::PREFILL && s.job && s.job->req.prefillOnly) return s.n_prefilled;
+    return 0;
+}
+
+static int32_t CommonPrefix(const std::vector<llama_token>& a, int32_t n_a, const std::vector<llama_token>& b) {
+    int32_t n = std::min<int32_t>(n_a, (int32_t)b.size());
+    int32_t i = 0;
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+static void DropCache(SeqSlot& s, llama_memory_t mem) {
+    if (mem) llama_memory_seq_rm(mem, s.seq, -1, -1);
+    s.phase = SlotPhase::FREE;
+    s.tokens.clear();
+    s.reserved = 0;
+}
+
+static SeqSlot* OldestCache(const SeqSlot* except) {
+    SeqSlot* lru = nullptr;
+    for (auto& s : g_slots) {
+        if (&s == except || s.phase != SlotPhase::CACHED) continue;
+        if (!lru || s.lastUsed < lru->lastUsed) lru = &s;
+    }
+    return lru;
+}
+
+// Longest cached prefix first, then a free slot, then the least recently used cache.
+// outReuse = prompt tokens that don't need to be decoded again (never the last one, it has to produce logits).
+static SeqSlot* PickSlot(const std::vector<llama_token>& toks, int32_t& outReuse) {
+    outReuse = 0;
+    SeqSlot* best = nullptr;
+    int32_t bestLen = 0;
+    if (ConfigReader::g_Settings.Prefix_Cache) {
+        for (auto& s : g_slots) {
+            int32_t n = ReusableTokens(s);
+            if (n < MIN_PREFIX_REUSE) continue;
+            int32_t common = CommonPrefix(s.tokens, n, toks);
+            if (common >= MIN_PREFIX_REUSE && common > bestLen) { best = &s; bestLen = common; }
+        }
+    }
+    if (best) {
+        outReuse = std::min<int32_t>(bestLen, (int32_t)toks.size() - 1);
+        return best;
+    }
+    for (auto& s : g_slots) if (s.phase == SlotPhase::FREE) return &s;
+    return OldestCache(nullptr);
+}
+
+static void AddRow(llama_batch& batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+    int32_t i = batch.n_tokens++;
+    batch.token[i] = token;
+    batch.pos[i] = pos;
+    batch.n_seq_id[i] = 1;
+    batch.seq_id[i][0] = seq;
+    batch.logits[i] = logits;
+}
+
+// Resolves the future; requests with a ticket also post REPLY_READY
+static void Resolve(PendingRequest& job, const std::string& result) {
+    job.promise.set_value(result);
+    if (job.req.ticket != 0) EventQueue::Post(EventType::REPLY_READY, job.req.ticket, result);
+}
+
+// For requests that never reached a slot: also closes the TTFT span opened by Submit
+static void ResolvePending(PendingRequest& job, const std::string& result) {
+    if (!job.req.prefillOnly) Tracer::AsyncEnd("TTFT", job.id);
+    Resolve(job, result);
+}
+
+// Pushes a sampled token into the reply. Returns false when generation has to stop.
+static bool AcceptToken(SeqSlot& s, llama_token id, const llama_vocab* vocab) {
+    if (s.n_gen == 0 && s.job) {
+        Tracer::AsyncEnd("TTFT", s.job->id);
+        if (s.job->req.priority == GenPriority::INTERACTIVE) {
+            std::chrono::duration<double, std::milli> ttft = std::chrono::high_resolution_clock::now() - s.job->submitted;
+            Metrics::Record(MetricHist::TTFT_MS, ttft.count());
+        }
+    }
+    s.tokens.push_back(id); // Update History
+
+    // STOP
+    if (llama_vocab_is_eog(vocab, id)) return false;
+    for (auto t : s.stopTokens) if (t == id) return false;
+
+    // DECODE
+    char buf[256] = { 0 };
+    int n = llama_token_to_piece(vocab, id, buf, 256, 0, true);
+    if (n > 0) {
+        std::string piece(buf, n);
+        if (piece.find("<|") != std::string::npos) return false;
+        s.text += piece;
+        if (s.job && s.job->req.streamTokens && s.job->req.ticket != 0) {
+            EventQueue::Post(EventType::TOKEN_CHUNK, s.job->req.ticket, piece);
+        }
+    }
+    return ++s.n_gen < s.maxTokens;
+}
+
+// keepCache: leave what is in the KV as a reusable prefix (only with PREFIX_CACHE)
+static void Retire(SeqSlot& s, const std::string& result, llama_memory_t mem, bool keepCache = false) {
+    int32_t n_kv = (s.phase == SlotPhase::PREFILL) ? s.n_prefilled : s.n_past;
+    if (s.job) {
+        if (s.phase == SlotPhase::PREFILL) Tracer::AsyncEnd("Prefill", s.job->id);
+        else if (!s.job->req.prefillOnly) Tracer::AsyncEnd("Generate", s.job->id);
+        if (s.n_gen == 0 && !s.job->req.prefillOnly) Tracer::AsyncEnd("TTFT", s.job->id);
+    }
+    keepCache = keepCache && ConfigReader::g_Settings.Prefix_Cache && n_kv >= MIN_PREFIX_REUSE;
+    if (!keepCache && mem) llama_memory_seq_rm(mem, s.seq, -1, -1);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end_time - s.start;
+    if (s.n_gen > 0) {
+        LogLLM("SCHED: seq " + std::to_string(s.seq) + " done. " + std::to_string(s.n_gen) + " tokens in " +
+            std::to_string((int)(diff.count() * 1000.0)) + "ms");
+        if (s.speculative) SpeculativeDecoder::EndGeneration(s.specStats, s.n_gen, diff.count());
+        UpdateTPS(s.n_gen, diff.count());
+        std::chrono::duration<double> gen = end_time - s.genStart;
+        if (s.phase == SlotPhase::GENERATING && gen.count() > 0.0) Metrics::Record(MetricHist::DECODE_TPS, s.n_gen / gen.count());
+    }
+
+    if (s.job) Resolve(*s.job, result);
+    s.job.reset();
+    g_active_slots--;
+    s.stopTokens.clear();
+    s.text.clear();
+    s.draft.clear();
+    s.pending = -1;
+    s.speculative = false;
+
+    if (keepCache) {
+        s.tokens.resize(n_kv); // the last sampled token was never decoded
+        s.reserved = n_kv;
+        s.lastUsed = ++g_use_tick;
+        s.phase = SlotPhase::CACHED;
+    }
+    else {
+        s.tokens.clear();
+        s.reserved = 0;
+        s.phase = SlotPhase::FREE;
+    }
+}
+
+// Moves queued requests into free slots while their KV reservation still fits
+static void AdmitRequests(const llama_vocab* vocab, int32_t n_ctx, llama_memory_t mem) {
+    const auto& cfg = ConfigReader::g_Settings;
+    while (true) {
+        bool anySlot = false;
+        for (const auto& s : g_slots) if (s.phase == SlotPhase::FREE || ReusableTokens(s) > 0) anySlot = true;
+        if (!anySlot) return;
+
+        std::unique_ptr<PendingRequest> job;
+        {
+            std::lock_guard<std::mutex> lock(g_sched_mutex);
+            if (g_pending.empty()) return;
+            auto best = g_pending.begin();
+            for (auto it = g_pending.begin(); it != g_pending.end(); ++it) {
+                if ((*it)->req.priority < (*best)->req.priority) best = it;
+            }
+            job = std::move(*best);
+            g_pending.erase(best);
+        }
+
+        // Tokenize + truncate (same limits as the old single-sequence path)
+        int64_t traceStart = Tracer::NowUs();
+        std::vector<llama_token> toks(std::max<int32_t>(n_ctx, 4096));
+        const std::string& prompt = job->req.prompt;
+        int32_t n_tokens = llama_tokenize(vocab, prompt.c_str(), (int32_t)prompt.length(), toks.data(), (int32_t)toks.size(), true, false);
+        Tracer::Complete("Tokenize", traceStart, Tracer::NowUs(), "tokens", n_tokens);
+        if (n_tokens <= 0) {
+            ResolvePending(*job, "TOKENIZATION_FAILED");
+            continue;
+        }
+        toks.resize(n_tokens);
+        if (n_tokens > n_ctx - 100) {
+            toks.resize(n_ctx - 100);
+            n_tokens = (int32_t)toks.size();
+        }
+
+        int32_t reuse = 0;
+        SeqSlot* slot = PickSlot(toks, reuse);
+        if (!slot) {
+            // Only warm-ups with a different prompt are running
+            std::lock_guard<std::mutex> lock(g_sched_mutex);
+            g_pending.push_front(std::move(job));
+            return;
+        }
+
+        const bool prefillOnly = job->req.prefillOnly;
+        int maxTokens = (job->req.maxTokens > 0) ? job->req.maxTokens : cfg.MaxOutputChars;
+        int32_t need = prefillOnly ? n_tokens : n_tokens + maxTokens + SpeculativeDecoder::GetMaxProposal() + 1;
+
+        // Cached prefixes give way to live requests, oldest first
+        while (ReservedCells() - slot->reserved + need > n_ctx) {
+            SeqSlot* lru = OldestCache(slot);
+            if (!lru) break;
+            DropCache(*lru, mem);
+        }
+        if (AnyActive() && ReservedCells() - slot->reserved + need > n_ctx) {
+            // Not enough KV left. Wait for a running sequence to retire.
+            std::lock_guard<std::mutex> lock(g_sched_mutex);
+            g_pending.push_front(std::move(job));
+            return;
+        }
+
+        if (cfg.Prefix_Cache) Metrics::Increment(reuse > 0 ? MetricCounter::CACHE_HIT : MetricCounter::CACHE_MISS);
+        if (slot->phase == SlotPhase::PREFILL) {
+            // Superseded warm-up: the real request continues where it stopped
+            Tracer::AsyncEnd("Prefill", slot->job->id);
+            Resolve(*slot->job, "");
+            slot->job.reset();
+            g_active_slots--;
+        }
+        if (mem) llama_memory_seq_rm(mem, slot->seq, reuse, -1);
+        slot->tokens = std::move(toks);
+        slot->stopTokens = BuildStopTokens(vocab, job->req.speakerName);
+        slot->text.clear();
+        slot->n_prompt = n_tokens;
+        slot->n_prefilled = reuse;
+        slot->n_reused = reuse;
+        slot->n_past = 0;
+        slot->reserved = std::min(need, n_ctx);
+        slot->chunk = 0;
+        slot->i_batch = -1;
+        slot->n_gen = 0;
+        slot->maxTokens = maxTokens;
+        slot->pending = -1;
+        slot->specStats = SpecTurnStats();
+        slot->start = std::chrono::high_resolution_clock::now();
+
+        // The speculative decoder tracks one sequence, give it to the first interactive request
+        bool specTaken = false;
+        for (const auto& s : g_slots) if (IsActive(s) && s.speculative) specTaken = true;
+        slot->speculative = !specTaken && !prefillOnly && job->req.priority == GenPriority::INTERACTIVE &&
+            SpeculativeDecoder::IsEnabled() && SpeculativeDecoder::BeginGeneration(slot->tokens);
+
+        LogLLM("SCHED: Admitted request " + std::to_string(job->id) + " on seq " + std::to_string(slot->seq) +
+            " (" + std::to_string(n_tokens) + " prompt tokens" +
+            (reuse > 0 ? ", " + std::to_string(reuse) + " cached" : "") +
+            (prefillOnly ? ", prefill only" : "") + (slot->speculative ? ", speculative)" : ")"));
+        Tracer::AsyncBegin("Prefill", job->id);
+        slot->job = std::move(job);
+        slot->phase = SlotPhase::PREFILL;
+        g_active_slots++;
+    }
+}
+
+// Consumes the logits of one slot after a successful decode. Returns false when the slot is done.
+static bool AdvanceSlot(SeqSlot& s, const llama_vocab* vocab, int32_t n_vocab, llama_memory_t mem) {
+    const auto& cfg = ConfigReader::g_Settings;
+    float temp = cfg.temp;
+    float top_p = cfg.float_p;
+    int   top_k = (int)cfg.top_k;
+    float min_p = cfg.min_p;
+    float penalty = cfg.repeat_penalty;
+
+    llama_token next = -1;
+    int accepted = 0;
+
+    if (s.pending >= 0) {
+        s.n_past++; // the pending token is in the KV now
+
+        // A draft token is only kept if the main model samples the very same token at
+        // that position, so the output matches what the plain loop would produce.
+        bool finished = false;
+        for (size_t i = 0; i < s.draft.size(); ++i) {
+            float* logits = llama_get_logits_ith(g_ctx, s.i_batch + (int32_t)i);
+            if (!logits) { finished = true; break; }
+
+            llama_token t = ManualSample(logits, n_vocab, s.tokens, temp, top_p, top_k, min_p, penalty);
+            if (t != s.draft[i]) { next = t; break; }
+
+            accepted++;
+            s.n_past++;
+            if (!AcceptToken(s, t, vocab)) { finished = true; break; }
+        }
+        if (!s.draft.empty()) {
+            SpeculativeDecoder::OnVerified((int)s.draft.size(), accepted, s.specStats);
+            // Forget the rejected rows
+            if (accepted < (int)s.draft.size() && mem) llama_memory_seq_rm(mem, s.seq, s.n_past, -1);
+        }
+        if (finished) return false;
+    }
+
+    if (next < 0) {
+        float* logits = llama_get_logits_ith(g_ctx, s.i_batch + accepted);
+        if (!logits) {
+            LogLLM("SCHED: Logits missing for seq " + std::to_string(s.seq));
+            return false;
+        }
+        next = ManualSample(logits, n_vocab, s.tokens, temp, top_p, top_k, min_p, penalty);
+    }
+
+    LOG_TRACE(LogLLM, "SCHED: seq " + std::to_string(s.seq) + " token " + std::to_string(next) +
+        " (" + std::to_string(accepted) + "/" + std::to_string(s.draft.size()) + " draft accepted)");
+    if (!AcceptToken(s, next, vocab)) return false;
+    s.pending = next;
+    return true;
+}
+
+// --- DECODE THREAD ---
+static void SchedulerLoop() {
+    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+    const int32_t n_vocab = llama_n_vocab(vocab);
+    const int32_t n_ctx = (int32_t)llama_n_ctx(g_ctx);
+    const int32_t n_batch = (int32_t)llama_n_batch(g_ctx);
+    llama_memory_t mem = llama_get_memory(g_ctx);
+    llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    Tracer::SetThreadName("LLM Decode");
+    CpuGovernor::ApplyToCurrentThread(Workload::LLM);
+    int n_threads = 0;
+
+    while (true) {
+        // 1. WAIT, CANCEL, CLEAR
+        std::vector<GenPriority> cancels;
+        bool clearCache = false;
+        bool interactiveWaiting = false;
+        {
+            std::unique_lock<std::mutex> lock(g_sched_mutex);
+            g_sched_cv.wait(lock, [] {
+                return !g_sched_running || !g_pending.empty() || !g_cancel_queue.empty() || g_clear_requested || AnyActive();
+                });
+            if (!g_sched_running) break;
+            cancels.swap(g_cancel_queue);
+            clearCache = g_clear_requested;
+            for (const auto& p : g_pending) if (p->req.priority == GenPriority::INTERACTIVE) interactiveWaiting = true;
+        }
+
+        for (auto& s : g_slots) {
+            if (!IsActive(s)) continue;
+            bool cancelled = std::find(cancels.begin(), cancels.end(), s.job->req.priority) != cancels.end();
+            // Ambient talk never competes with a player reply for slots, KV or batch rows
+            if (interactiveWaiting && s.job->req.priority == GenPriority::AMBIENT) cancelled = true;
+            if (cancelled) {
+                Metrics::Increment(MetricCounter::CANCELLED);
+                Retire(s, "", mem, true);
+            }
+            else if (s.job->req.abortOnConvoEnd && g_convo_state == ConvoState::IDLE) Retire(s, CleanupResponse(s.text), mem, true);
+        }
+
+        if (clearCache && !AnyActive()) {
+            for (auto& s : g_slots) if (s.phase == SlotPhase::CACHED) DropCache(s, mem);
+            if (mem) llama_memory_clear(mem, true);
+            std::lock_guard<std::mutex> lock(g_sched_mutex);
+            g_clear_requested = false;
+            LogLLM("SCHED: KV cache cleared.");
+        }
+
+        // 2. ADMIT
+        AdmitRequests(vocab, n_ctx, mem);
+        if (!AnyActive()) continue;
+
+        // 3. BUILD BATCH: running sequences first, then prompt chunks (interactive before background)
+        batch.n_tokens = 0;
+        int32_t budget = n_batch;
+        for (auto& s : g_slots) {
+            s.i_batch = -1;
+            s.chunk = 0;
+            if (s.phase != SlotPhase::GENERATING) continue;
+
+            s.draft.clear();
+            if (budget <= 0) continue; // batch full, this sequence samples next step
+            int room = std::min(budget - 1, s.maxTokens - s.n_gen - 1);
+            if (s.speculative && room > 0) SpeculativeDecoder::ProposeTokens(s.tokens, room, s.draft);
+
+            s.i_batch = batch.n_tokens;
+            AddRow(batch, s.pending, s.n_past, s.seq, true);
+            for (size_t i = 0; i < s.draft.size(); ++i) AddRow(batch, s.draft[i], s.n_past + 1 + (llama_pos)i, s.seq, true);
+            budget -= 1 + (int32_t)s.draft.size();
+            if (s.speculative) s.specStats.targetDecodes++;
+        }
+        for (GenPriority prio : { GenPriority::INTERACTIVE, GenPriority::BACKGROUND, GenPriority::AMBIENT }) {
+            for (auto& s : g_slots) {
+                if (budget <= 0) break;
+                if (s.phase != SlotPhase::PREFILL || s.job->req.priority != prio) continue;
+
+                s.chunk = std::min(budget, s.n_prompt - s.n_prefilled);
+                for (int32_t i = 0; i < s.chunk; ++i) {
+                    int32_t p = s.n_prefilled + i;
+                    AddRow(batch, s.tokens[p], p, s.seq, p == s.n_prompt - 1);
+                }
+                if (s.n_prefilled + s.chunk == s.n_prompt) s.i_batch = batch.n_tokens - 1;
+                budget -= s.chunk;
+            }
+        }
+        if (batch.n_tokens == 0) continue;
+
+        // 4. DECODE
+        bool interactiveRows = false;
+        for (const auto& s : g_slots) {
+            if (IsActive(s) && (s.i_batch >= 0 || s.chunk > 0) && s.job->req.priority == GenPriority::INTERACTIVE) interactiveRows = true;
+        }
+        int wantThreads = CpuGovernor::ThreadsFor(Workload::LLM, interactiveRows);
+        if (wantThreads != n_threads) {
+            n_threads = wantThreads;
+            llama_set_n_threads(g_ctx, n_threads, n_threads);
+        }
+
+        int64_t traceStart = Tracer::NowUs();
+        int ret = llama_decode(g_ctx, batch);
+        Tracer::Complete("llama_decode", traceStart, Tracer::NowUs(), "rows", batch.n_tokens);
+        if (ret != 0) {
+            LogLLM("SCHED: llama_decode failed (" + std::to_string(ret) + ") with " + std::to_string(batch.n_tokens) + " rows.");
+
+            // Drop cached prefixes first. If there were none, give up on the youngest,
+            // least important request. The rest retries next step.
+            bool droppedCache = false;
+            for (auto& s : g_slots) {
+                if (s.phase == SlotPhase::CACHED) { DropCache(s, mem); droppedCache = true; }
+            }
+            SeqSlot* victim = nullptr;
+            for (auto& s : g_slots) {
+                if (droppedCache || !IsActive(s)) continue;
+                if (!victim || s.job->req.priority > victim->job->req.priority ||
+                    (s.job->req.priority == victim->job->req.priority && s.job->id > victim->job->id)) victim = &s;
+            }
+            for (auto& s : g_slots) {
+                if (!IsActive(s)) continue;
+                if (!s.draft.empty()) SpeculativeDecoder::OnVerified((int)s.draft.size(), 0, s.specStats);
+                s.draft.clear();
+                if (&s == victim) {
+                    Retire(s, s.phase == SlotPhase::PREFILL ? "CTX_FAIL" : CleanupResponse(s.text), mem);
+                }
+                else if (mem) {
+                    llama_memory_seq_rm(mem, s.seq, s.phase == SlotPhase::PREFILL ? s.n_prefilled : s.n_past, -1);
+                }
+            }
+            continue;
+        }
+
+        // 5. SAMPLE / VERIFY / RETIRE
+        for (auto& s : g_slots) {
+            if (s.phase == SlotPhase::PREFILL) {
+                s.n_prefilled += s.chunk;
+                if (s.n_prefilled < s.n_prompt) continue;
+                s.n_past = s.n_prompt;
+                s.phase = SlotPhase::GENERATING;
+                s.genStart = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double> prefill = s.genStart - s.start;
+                if (s.n_prompt > s.n_reused && prefill.count() > 0.0) {
+                    Metrics::Record(MetricHist::PREFILL_TPS, (s.n_prompt - s.n_reused) / prefill.count());
+                }
+                Tracer::AsyncEnd("Prefill", s.job->id);
+                if (!s.job->req.prefillOnly) Tracer::AsyncBegin("Generate", s.job->id);
+                if (s.job->req.prefillOnly) {
+                    Retire(s, "", mem, true);
+                    continue;
+                }
+            }
+            if (s.phase != SlotPhase::GENERATING || s.i_batch < 0) continue;
+
+            bool keepGoing = false;
+            try { keepGoing = AdvanceSlot(s, vocab, n_vocab, mem); }
+            catch (...) { LogLLM("SCHED: Exception while sampling seq " + std::to_string(s.seq)); }
+            if (!keepGoing) Retire(s, CleanupResponse(s.text), mem, true);
+        }
+    }
+
+    // Shutdown: nobody may wait forever on a future
+    for (auto& s : g_slots) if (IsActive(s)) Retire(s, "LLM_NOT_INITIALIZED", mem);
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        for (auto& p : g_pending) ResolvePending(*p, "LLM_NOT_INITIALIZED");
+        g_pending.clear();
+    }
+    llama_batch_free(batch);
+    g_sched_done = true;
+}
+
+// --- LIFECYCLE ---
+bool BatchScheduler::Start() {
+    if (!g_model || !g_ctx) {
+        LogLLM("SCHED: Cannot start without model and context.");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    if (g_sched_running) return true;
+
+    int n_seq = std::max(1, ConfigReader::g_Settings.Parallel_Sequences);
+    g_slots.clear();
+    g_slots.resize(n_seq);
+    for (int i = 0; i < n_seq; ++i) g_slots[i].seq = i;
+    g_slot_count = n_seq;
+    g_active_slots = 0;
+
+    g_sched_running = true;
+    g_sched_done = false;
+    g_sched_thread = std::thread(SchedulerLoop);
+    LogLLM("SCHED: Decode thread started with " + std::to_string(n_seq) + " sequence slots, n_ctx " +
+        std::to_string(llama_n_ctx(g_ctx)) + ", n_batch " + std::to_string(llama_n_batch(g_ctx)));
+    return true;
+}
+
+bool BatchScheduler::Stop(bool inDllMain) {
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        if (!g_sched_running) return g_sched_done;
+        g_sched_running = false;
+    }
+    g_sched_cv.notify_all();
+    if (inDllMain) {
+        WaitForThreadExit([] { return g_sched_done.load(); }, SCHED_EXIT_WAIT_MS); // no join, see ThreadExit.h
+        if (g_sched_thread.joinable()) g_sched_thread.detach();
+        if (!g_sched_done) {
+            LogLLM("SCHED: Decode thread still busy at shutdown, detached.");
+            return false;
+        }
+    }
+    else if (g_sched_thread.joinable()) {
+        g_sched_thread.join();
+    }
+    g_slots.clear();
+    LogLLM("SCHED: Decode thread stopped.");
+    return true;
+}
+
+bool BatchScheduler::IsRunning() {
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    return g_sched_running;
+}
+
+bool BatchScheduler::IsIdle() {
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    return g_sched_running && g_pending.empty() && g_active_slots == 0;
+}
+
+int BatchScheduler::GetFreeSlots() {
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    if (!g_sched_running) return 0;
+    return std::max(0, g_slot_count - g_active_slots.load() - (int)g_pending.size());
+}
+
+// --- REQUESTS ---
+std::future<std::string> BatchScheduler::Submit(GenRequest request) {
+    auto job = std::make_unique<PendingRequest>();
+    job->req = std::move(request);
+    std::future<std::string> result = job->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        if (!g_sched_running) {
+            Resolve(*job, "LLM_NOT_INITIALIZED");
+            return result;
+        }
+        job->id = g_next_id++;
+        job->submitted = std::chrono::high_resolution_clock::now();
+        if (!job->req.prefillOnly) Tracer::AsyncBegin("TTFT", job->id);
+        g_pending.push_back(std::move(job));
+    }
+    g_sched_cv.notify_one();
+    return result;
+}
+
+std::future<std::string> BatchScheduler::Submit(const std::string& prompt, GenPriority priority) {
+    GenRequest req;
+    req.prompt = prompt;
+    req.priority = priority;
+    req.speakerName = g_current_npc_name;
+    return Submit(std::move(req));
+}
+
+std::future<std::string> BatchScheduler::Prefill(const std::string& prompt, GenPriority priority) {
+    GenRequest req;
+    req.prompt = prompt;
+    req.priority = priority;
+    req.abortOnConvoEnd = false;
+    req.prefillOnly = true;
+    return Submit(std::move(req));
+}
+
+void BatchScheduler::Cancel(GenPriority priority) {
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        if (!g_sched_running) return;
+        for (auto it = g_pending.begin(); it != g_pending.end();) {
+            if ((*it)->req.priority == priority) {
+                Metrics::Increment(MetricCounter::CANCELLED);
+                ResolvePending(**it, "");
+                it = g_pending.erase(it);
+            }
+            else ++it;
+        }
+        g_cancel_queue.push_back(priority);
+    }
+    g_sched_cv.notify_one();
+}
+
+bool BatchScheduler::ClearCache() {
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        if (!g_sched_running) return false;
+        g_clear_requested = true;
+    }
+    g_sched_cv.notify_one();
+    return true;
+}
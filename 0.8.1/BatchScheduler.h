@@ -0,0 +1,47 @@
+#pragma once
+// BatchScheduler.h
+#include <cstdint>
+#include <string>
+#include <future>
+#include "FileEnums.h"
+
+// One generation job. Everything the decode thread needs is copied in at submit time.
+struct GenRequest {
+    std::string prompt;
+    GenPriority priority = GenPriority::INTERACTIVE;
+    std::string speakerName;      // adds "<name>:" as a stop string (empty = none)
+    int maxTokens = 0;            // 0 = MaxOutputChars from the INI
+    bool abortOnConvoEnd = true;  // stop early once g_convo_state drops to IDLE
+    bool prefillOnly = false;     // only load the prompt into the KV, resolves "" (warm-up)
+    uint64_t ticket = 0;          // != 0: the result is also posted as EventType::REPLY_READY with this ticket
+    bool streamTokens = false;    // post every decoded piece as TOKEN_CHUNK (needs a ticket)
+};
+
+class BatchScheduler {
+public:
+    // --- LIFECYCLE ---
+    // Starts the decode thread. g_ctx must exist and must not be used by anyone else afterwards.
+    static bool Start();
+    // Finishes every open request with "LLM_NOT_INITIALIZED" and joins the decode thread.
+    // From DllMain it only waits for the thread to finish and detaches it (see ThreadExit.h).
+    // False if it is still running then: g_ctx and g_model must stay allocated.
+    static bool Stop(bool inDllMain = false);
+    static bool IsRunning();
+    // Sequence slots neither running nor claimed by a queued request
+    static int GetFreeSlots();
+    // Running, nothing queued and no sequence decoding (cached prefixes don't count)
+    static bool IsIdle();
+
+    // --- REQUESTS ---
+    // Thread safe. The future resolves with the cleaned reply.
+    static std::future<std::string> Submit(GenRequest request);
+    // Interactive request for the current NPC (stop string = g_current_npc_name)
+    static std::future<std::string> Submit(const std::string& prompt, GenPriority priority = GenPriority::INTERACTIVE);
+    // Warm-up: prefills 'prompt' into a spare sequence and keeps it cached, so a later
+    // request that starts with the same text only decodes the rest.
+    static std::future<std::string> Prefill(const std::string& prompt, GenPriority priority = GenPriority::BACKGROUND);
+    // Drops queued and running requests of that priority. Their futures resolve with "".
+    static void Cancel(GenPriority priority);
+    // Clears the KV cache (incl. cached prefixes) as soon as no sequence is running. False if the scheduler is not up.
+    static bool ClearCache();
+};
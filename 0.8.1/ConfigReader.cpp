@@ -49,7 +49,7 @@ std::string ConfigReader::GetValueFromINI(const char* iniPath, const std::string
 }
 
 std::vector<std::string> ConfigReader::SplitString(const std::string& str, char delimiter) {
-    LogConfig("SplitString called with string: " + str + ", delimiter: " + delimiter);
+    LOG_TRACE(LogConfig, "SplitString called with string: " + str + ", delimiter: " + delimiter);
     std::vector<std::string> tokens;
     std::string token;
     std::istringstream tokenStream(str);
@@ -60,77 +60,77 @@ std::vector<std::string> ConfigReader::SplitString(const std::string& str, char
             tokens.push_back(token);
         }
     }
-    LogConfig("SplitString returned " + std::to_string(tokens.size()) + " tokens");
+    LOG_TRACE(LogConfig, "SplitString returned " + std::to_string(tokens.size()) + " tokens");
     return tokens;
 }
 
 int ConfigReader::KeyNameToVK(const std::string& keyName) {
-    LogConfig("KeyNameToVK called with keyName: " + keyName);
+    LOG_DEBUG(LogConfig, "KeyNameToVK called with keyName: " + keyName);
     std::string upperKey = keyName;
     std::transform(upperKey.begin(), upperKey.end(), upperKey.begin(), ::toupper);
     if (upperKey.length() == 1 && upperKey[0] >= 'A' && upperKey[0] <= 'Z') {
         int vk_code = upperKey[0];
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_" + upperKey + " (" + std::to_string(vk_code) + ")");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_" + upperKey + " (" + std::to_string(vk_code) + ")");
         return vk_code;
     }
     if (upperKey.length() == 1 && upperKey[0] >= '0' && upperKey[0] <= '9') {
         int vk_code = upperKey[0];
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_" + upperKey + " (" + std::to_string(vk_code) + ")");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_" + upperKey + " (" + std::to_string(vk_code) + ")");
         return vk_code;
     }
     if (upperKey == "ESC" || upperKey == "VK_ESCAPE") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_ESCAPE");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_ESCAPE");
         return VK_ESCAPE;
     }
     if (upperKey == "F1" || upperKey == "VK_F1") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F1");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F1");
         return VK_F1;
     }
     if (upperKey == "F2" || upperKey == "VK_F2") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F2");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F2");
         return VK_F2;
     }
     if (upperKey == "F3" || upperKey == "VK_F3") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F3");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F3");
         return VK_F3;
     }
     if (upperKey == "F4" || upperKey == "VK_F4") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F4");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F4");
         return VK_F4;
     }
     if (upperKey == "F5" || upperKey == "VK_F5") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F5");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F5");
         return VK_F5;
     }
     if (upperKey == "F6" || upperKey == "VK_F6") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F6");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F6");
         return VK_F6;
     }
     if (upperKey == "F7" || upperKey == "VK_F7") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F7");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F7");
         return VK_F7;
     }
     if (upperKey == "F8" || upperKey == "VK_F8") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F8");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F8");
         return VK_F8;
     }
     if (upperKey == "F9" || upperKey == "VK_F9") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F9");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F9");
         return VK_F9;
     }
     if (upperKey == "F10" || upperKey == "VK_F10") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F10");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F10");
         return VK_F10;
     }
     if (upperKey == "F11" || upperKey == "VK_F11") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F11");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F11");
         return VK_F11;
     }
     if (upperKey == "F12" || upperKey == "VK_F12") {
-        LogConfig("KeyNameToVK mapped " + keyName + " to VK_F12");
+        LOG_DEBUG(LogConfig, "KeyNameToVK mapped " + keyName + " to VK_F12");
         return VK_F12;
     }
-    LogConfig("KeyNameToVK FAILED. Unmapped key: " + keyName + ". Returning 0.");
+    LOG_WARN(LogConfig, "KeyNameToVK FAILED. Unmapped key: " + keyName + ". Returning 0.");
     return 0;
 }
 
@@ -150,7 +150,7 @@ uint32_t ConfigReader::GetHashFromHex(const std::string& hexString) {
 }
 
 void ConfigReader::LoadINISectionToCache(const char* iniPath, const std::string& section, std::map<std::string, std::string>& cache) {
-    LogConfig("LoadINISectionToCache called for INI: " + std::string(iniPath) + ", section: " + section);
+    LOG_DEBUG(LogConfig, "LoadINISectionToCache called for INI: " + std::string(iniPath) + ", section: " + section);
     const int bufferSize = 32767;
     std::vector<char> buffer(bufferSize);
     DWORD bytesRead = GetPrivateProfileSectionA(section.c_str(), buffer.data(), bufferSize, iniPath);
@@ -294,8 +294,33 @@ void ConfigReader::LoadAllConfigs() {
         // Models & Logging
         g_Settings.MODEL_PATH = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "MODEL_PATH", "");
         g_Settings.MODEL_ALT_NAME = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "MODEL_ALT_NAME", "Phi3.gguf");
+
+        // Speculative Decoding (prompt n-gram lookup and/or a draft model sharing the main model's vocab)
+        try { g_Settings.Speculative_Mode = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "SPECULATIVE_DECODING", "0")); }
+        catch (...) {}
+        g_Settings.DRAFT_MODEL_PATH = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DRAFT_MODEL_PATH", "");
+        g_Settings.DRAFT_MODEL_ALT_NAME = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DRAFT_MODEL_ALT_NAME", "Phi3_draft.gguf");
+        try { g_Settings.DRAFT_GPU_LAYERS = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DRAFT_GPU_LAYERS", "0")); }
+        catch (...) {}
+        try { g_Settings.Draft_Min_Tokens = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DRAFT_MIN_TOKENS", "2")); }
+        catch (...) {}
+        try { g_Settings.Draft_Max_Tokens = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DRAFT_MAX_TOKENS", "8")); }
+        catch (...) {}
+        if (g_Settings.Draft_Min_Tokens < 1) g_Settings.Draft_Min_Tokens = 1;
+        if (g_Settings.Draft_Max_Tokens < g_Settings.Draft_Min_Tokens) g_Settings.Draft_Max_Tokens = g_Settings.Draft_Min_Tokens;
+        try { g_Settings.Lookup_Ngram_Min = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "LOOKUP_NGRAM_MIN", "2")); }
+        catch (...) {}
+        try { g_Settings.Lookup_Ngram_Max = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "LOOKUP_NGRAM_MAX", "4")); }
+        catch (...) {}
+        try { g_Settings.Lookup_Max_Tokens = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "LOOKUP_MAX_TOKENS", "6")); }
+        catch (...) {}
+        if (g_Settings.Lookup_Ngram_Min < 1) g_Settings.Lookup_Ngram_Min = 1;
+        if (g_Settings.Lookup_Ngram_Max < g_Settings.Lookup_Ngram_Min) g_Settings.Lookup_Ngram_Max = g_Settings.Lookup_Ngram_Min;
+        if (g_Settings.Lookup_Max_Tokens < 1) g_Settings.Lookup_Max_Tokens = 1;
+
         g_Settings.LOG_NAME = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "LOG_NAME", "kkamel.log");
         g_Settings.DEBUG_LEVEL = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "DEBUG_LEVEL", "0"));
+        AsyncLogger::SetLevel(g_Settings.DEBUG_LEVEL);
 
         // STT / TTS
         g_Settings.StT_Enabled = (GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "SPEECH_TO_TEXT", "0") == "1");
@@ -324,6 +349,58 @@ void ConfigReader::LoadAllConfigs() {
         catch (...) {}
         try { g_Settings.n_ubatch = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "n_ubatch", "256")); }
         catch (...) {}
+        try { g_Settings.Parallel_Sequences = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "parallel_sequences", "4")); }
+        catch (...) {}
+        if (g_Settings.Parallel_Sequences < 1) g_Settings.Parallel_Sequences = 1;
+        if (g_Settings.Parallel_Sequences > 16) g_Settings.Parallel_Sequences = 16;
+        try { g_Settings.Prefix_Cache = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "prefix_cache", "1")); }
+        catch (...) {}
+        try { g_Settings.Target_Prewarm = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "target_prewarm", "1")); }
+        catch (...) {}
+        try { g_Settings.Trace_Enabled = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "trace_pipeline", "0")); }
+        catch (...) {}
+        try { g_Settings.Metrics_Overlay = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "metrics_overlay", "0")); }
+        catch (...) {}
+        try { g_Settings.Telemetry_Interval_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "telemetry_interval_ms", "1000")); }
+        catch (...) {}
+        try { g_Settings.Memory_Governor = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "memory_governor", "1")); }
+        catch (...) {}
+        try { g_Settings.Memory_Headroom_MB = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "memory_headroom_mb", "1024")); }
+        catch (...) {}
+        try { g_Settings.Memory_Low_MB = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "memory_low_mb", "512")); }
+        catch (...) {}
+        try { g_Settings.Cpu_Governor = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "cpu_governor", "1")); }
+        catch (...) {}
+        try { g_Settings.Cpu_Game_Cores = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "cpu_game_cores", "-1")); }
+        catch (...) {}
+        try { g_Settings.Cpu_Frame_Budget_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "cpu_frame_budget_ms", "33")); }
+        catch (...) {}
+        try { g_Settings.Task_Pool_Threads = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "task_pool_threads", "3")); }
+        catch (...) {}
+        try { g_Settings.StT_Max_Record_Sec = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_max_record_sec", "30")); }
+        catch (...) {}
+        try { g_Settings.StT_Streaming = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_streaming", "1")); }
+        catch (...) {}
+        try { g_Settings.StT_Stream_Step_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_stream_step_ms", "1000")); }
+        catch (...) {}
+        try { g_Settings.Tts_Sentence_Streaming = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "tts_sentence_streaming", "1")); }
+        catch (...) {}
+        try { g_Settings.StT_Whisper_States = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_whisper_states", "2")); }
+        catch (...) {}
+        try { g_Settings.StT_Audio_Ctx_Margin_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_audio_ctx_margin_ms", "1000")); }
+        catch (...) {}
+        try { g_Settings.StT_Open_Mic = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_open_mic", "0")); }
+        catch (...) {}
+        try { g_Settings.Vad_Enabled = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "vad_enabled", "1")); }
+        catch (...) {}
+        try { g_Settings.Vad_Threshold_Db = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "vad_threshold_db", "9")); }
+        catch (...) {}
+        try { g_Settings.Vad_Min_Speech_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "vad_min_speech_ms", "200")); }
+        catch (...) {}
+        try { g_Settings.Vad_Pad_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "vad_pad_ms", "200")); }
+        catch (...) {}
+        try { g_Settings.Vad_Hangover_Ms = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "vad_hangover_ms", "800")); }
+        catch (...) {}
         try { g_Settings.KV_Cache_Quantization_Type = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "kv_cache_model_quantization_type", "0")); }
         catch (...) {}
 
@@ -351,7 +428,27 @@ void ConfigReader::LoadAllConfigs() {
         try { g_Settings.LORA_SCALE = std::stof(GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "LORA_SCALE", "1.0")); }
         catch (...) {}
 
+        // Ambient NPC-to-NPC dialogue (runs only while the player is not talking)
+        try { g_Settings.Ambient_Enabled = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_DIALOGUE", "0")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Radius = std::stof(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_RADIUS", "20.0")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Pair_Distance = std::stof(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_PAIR_DISTANCE", "4.0")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Max_Lines = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_MAX_LINES", "4")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Max_Tokens = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_MAX_TOKENS", "40")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Tokens_Per_Minute = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_TOKENS_PER_MINUTE", "300")); }
+        catch (...) {}
+        try { g_Settings.Ambient_Cooldown_Sec = std::stoi(GetValueFromINI(SETTINGS_INI_PATH, "AMBIENT", "AMBIENT_COOLDOWN_SEC", "45")); }
+        catch (...) {}
+        if (g_Settings.Ambient_Max_Lines < 2) g_Settings.Ambient_Max_Lines = 2;
+        if (g_Settings.Ambient_Max_Tokens < 8) g_Settings.Ambient_Max_Tokens = 8;
+        if (g_Settings.Ambient_Tokens_Per_Minute < g_Settings.Ambient_Max_Tokens) g_Settings.Ambient_Tokens_Per_Minute = g_Settings.Ambient_Max_Tokens;
+
         g_Settings.StopStrings = GetValueFromINI(SETTINGS_INI_PATH, "SETTINGS", "STOP_TOKENS", ""); // From [SETTINGS]
+        g_Settings.StT_Bench_Margins = GetValueFromINI(SETTINGS_INI_PATH, "ADDITIONAL_SETTINGS", "stt_bench_margins_ms", "0,500,1000,2000");
         g_ContentGuidelines = GetValueFromINI(SETTINGS_INI_PATH, "CONTENT_GUIDELINES", "PROMPT_INJECTION", "You are a helpful assistant.");
 
         // 4. LOAD DATABASES
@@ -374,10 +471,10 @@ void ConfigReader::LoadAllConfigs() {
 NpcPersona ConfigReader::GetPersona(AHandle ped) {
     if (!AbstractGame::IsEntityValid(ped)) return NpcPersona();
     Hash entityHash = AbstractGame::GetEntityModel(ped);
-    LogConfig("GetPersona: Entity model hash=" + std::to_string(entityHash));
+    LOG_TRACE(LogConfig, "GetPersona: Entity model hash=" + std::to_string(entityHash));
     auto it = g_PersonaCache.find(entityHash);
     if (it != g_PersonaCache.end()) {
-        LogConfig("Persona found in .ini");
+        LOG_TRACE(LogConfig, "Persona found in .ini");
         return it->second;
     }
     NpcPersona p;
@@ -396,66 +493,66 @@ NpcPersona ConfigReader::GetPersona(AHandle ped) {
         p.gender = "Neutral";
         p.type = "ANIMAL";
     }
-    LogConfig("Persona loaded successfully");
+    LOG_TRACE(LogConfig, "Persona loaded successfully");
     g_PersonaCache[entityHash] = p;
     return p;
 }
 
 std::string ConfigReader::GetRelationship(const std::string& npcSubGroup, const std::string& playerSubGroup) {
-    LogConfig("GetRelationship called for npcSubGroup: " + npcSubGroup + ", playerSubGroup: " + playerSubGroup);
+    LOG_TRACE(LogConfig, "GetRelationship called for npcSubGroup: " + npcSubGroup + ", playerSubGroup: " + playerSubGroup);
     if (npcSubGroup.empty() || playerSubGroup.empty()) {
-        LogConfig("GetRelationship: SubGroup is empty, fallback to neutral");
+        LOG_TRACE(LogConfig, "GetRelationship: SubGroup is empty, fallback to neutral");
         return "neutral, stranger";
     }
     std::string key = npcSubGroup + ":" + playerSubGroup;
     auto it = g_RelationshipMatrix.find(key);
     if (it != g_RelationshipMatrix.end()) {
-        LogConfig("GetRelationship: Found direct relationship: " + it->second);
+        LOG_TRACE(LogConfig, "GetRelationship: Found direct relationship: " + it->second);
         return it->second;
     }
     key = playerSubGroup + ":" + npcSubGroup;
     it = g_RelationshipMatrix.find(key);
     if (it != g_RelationshipMatrix.end()) {
-        LogConfig("GetRelationship: Found reverse relationship: " + it->second);
+        LOG_TRACE(LogConfig, "GetRelationship: Found reverse relationship: " + it->second);
         return it->second;
     }
     if (npcSubGroup == "Ambient" || playerSubGroup == "Ambient") {
-        LogConfig("GetRelationship: Fallback to neutral, stranger for Ambient group");
+        LOG_TRACE(LogConfig, "GetRelationship: Fallback to neutral, stranger for Ambient group");
         return "neutral, stranger";
     }
     if ((npcSubGroup == "Law" || npcSubGroup == "LSPD" || npcSubGroup == "FIB") &&
         (playerSubGroup == "Gang" || playerSubGroup == "Families" || playerSubGroup == "Ballas")) {
-        LogConfig("GetRelationship: Fallback to adversary, distrusts, pursues for Law vs Gang");
+        LOG_TRACE(LogConfig, "GetRelationship: Fallback to adversary, distrusts, pursues for Law vs Gang");
         return "adversary, distrusts, pursues";
     }
     if ((npcSubGroup == "Gang" || npcSubGroup == "Families" || playerSubGroup == "Ballas") &&
         (playerSubGroup == "Law" || playerSubGroup == "LSPD" || playerSubGroup == "FIB")) {
-        LogConfig("GetRelationship: Fallback to adversary, distrusts, pursued for Gang vs Law");
+        LOG_TRACE(LogConfig, "GetRelationship: Fallback to adversary, distrusts, pursued for Gang vs Law");
         return "adversary, distrusts, pursued";
     }
-    LogConfig("GetRelationship: Fallback to neutral, unknown");
+    LOG_TRACE(LogConfig, "GetRelationship: Fallback to neutral, unknown");
     return "neutral, unknown";
 }
 
 std::string ConfigReader::GetZoneContext(const std::string& zoneName) {
-    LogConfig("GetZoneContext called for zoneName: " + zoneName);
+    LOG_TRACE(LogConfig, "GetZoneContext called for zoneName: " + zoneName);
     auto it = g_ZoneContextCache.find(zoneName);
     if (it != g_ZoneContextCache.end()) {
-        LogConfig("GetZoneContext: Found context: " + it->second);
+        LOG_TRACE(LogConfig, "GetZoneContext: Found context: " + it->second);
         return it->second;
     }
-    LogConfig("GetZoneContext: No context found, returning default");
+    LOG_TRACE(LogConfig, "GetZoneContext: No context found, returning default");
     return "Location: Unknown";
 }
 
 std::string ConfigReader::GetOrgContext(const std::string& orgName) {
-    LogConfig("GetOrgContext called for orgName: " + orgName);
+    LOG_TRACE(LogConfig, "GetOrgContext called for orgName: " + orgName);
     auto it = g_OrgContextCache.find(orgName);
     if (it != g_OrgContextCache.end()) {
-        LogConfig("GetOrgContext: Found context: " + it->second);
+        LOG_TRACE(LogConfig, "GetOrgContext: Found context: " + it->second);
         return it->second;
     }
-    LogConfig("GetOrgContext: No context found, returning empty string");
+    LOG_TRACE(LogConfig, "GetOrgContext: No context found, returning empty string");
     return "";
 }
 void ConfigReader::LoadVoiceDatabase() {
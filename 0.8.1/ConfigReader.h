@@ -49,8 +49,21 @@ struct ModSettings {
     bool USE_VRAM_PREFERED = false;
     int StT_Enabled = 0;
     int TtS_Enabled = 0;
+    int Tts_Sentence_Streaming = 1; // queue each finished sentence for TTS while the reply is still generated
     std::string MODEL_PATH = "";
     std::string MODEL_ALT_NAME = "";
+
+    // Speculative Decoding (draft proposes, main model verifies)
+    int Speculative_Mode = 0; // 0=Off, 1=Draft Model, 2=Prompt Lookup, 3=Prompt Lookup + Draft Model
+    std::string DRAFT_MODEL_PATH = "";
+    std::string DRAFT_MODEL_ALT_NAME = "";
+    int DRAFT_GPU_LAYERS = 0;
+    int Draft_Min_Tokens = 2;
+    int Draft_Max_Tokens = 8;
+    int Lookup_Ngram_Min = 2;  // shortest suffix matched against the prompt
+    int Lookup_Ngram_Max = 4;  // longest suffix, tried first
+    int Lookup_Max_Tokens = 6; // tokens copied after a match
+
     int StTRB_Activation_Key = 0;
     int DEBUG_LEVEL = 0;
     std::string LOG_NAME = "kkamel.log";
@@ -66,6 +79,30 @@ struct ModSettings {
     int KV_Cache_Quantization_Type = -1;
     int n_batch = 512;
     int n_ubatch = 256;
+    int Parallel_Sequences = 4; // concurrent LLM requests sharing one context (continuous batching)
+    int Prefix_Cache = 1;       // keep finished sequences in the KV and reuse matching prompt prefixes
+    int Target_Prewarm = 1;     // prefill the system prompt of the ped the player is likely to talk to
+    int Trace_Enabled = 0;      // write a Chrome trace (kkamel_trace_<chat>.json) per conversation
+    int Metrics_Overlay = 0;    // draw latency percentiles and counters on screen
+    int Telemetry_Interval_Ms = 1000; // RAM/VRAM sampling period of the ResourceMonitor
+    int Memory_Governor = 1;    // scale n_ctx / KV type / KV offload to the free VRAM at runtime
+    int Memory_Headroom_MB = 1024; // VRAM left free when picking or growing the context
+    int Memory_Low_MB = 512;    // below this much free VRAM (sustained) the context steps down
+    int Cpu_Governor = 1;       // thread counts, priorities and cores per workload from the CPU topology
+    int Cpu_Game_Cores = -1;    // fast cores left to the game (-1 = half of them, at least 2)
+    int Cpu_Frame_Budget_Ms = 33; // script loop frame time above which background work is throttled
+    int Task_Pool_Threads = 3;  // workers for STT, summaries and other background tasks
+    int StT_Max_Record_Sec = 30; // longest push-to-talk recording, sizes the preallocated capture buffers
+    int StT_Streaming = 1;      // transcribe while push-to-talk is held, only the last window is left at release
+    int StT_Stream_Step_Ms = 1000; // audio between two streaming window decodes
+    int StT_Whisper_States = 2; // whisper decoder states (1-4); state 0 is kept free of background work
+    int StT_Audio_Ctx_Margin_Ms = 1000; // whisper encoder window = clip length + this (-1 = full 30 s window)
+    int StT_Open_Mic = 0;       // hands-free: listen whenever it is the player's turn, end of speech submits it
+    int Vad_Enabled = 1;        // trim silence and skip whisper on recordings without speech
+    int Vad_Threshold_Db = 9;   // level above the noise floor that counts as speech
+    int Vad_Min_Speech_Ms = 200; // less speech than this = empty recording
+    int Vad_Pad_Ms = 200;       // kept around the detected speech
+    int Vad_Hangover_Ms = 800;  // open mic: silence that ends the turn
     float temp = 0.65f;
     float top_k = 40.0f;
     float top_p = 0.9f;
@@ -87,8 +124,18 @@ struct ModSettings {
     int MIN_PCSREMEMBER_SIZE = 100;
     int MAX_PCSREMEMBER_SIZE = 500;
     std::string StopStrings = "";
+    std::string StT_Bench_Margins = "0,500,1000,2000"; // margins (ms) SttBench compares against the full window
     int DeletionTimerClearFull = 160;
     int MaxAllowedChatHistory = 2;
+
+    // Ambient Dialogue (NPC-to-NPC, low priority)
+    int Ambient_Enabled = 0;
+    float Ambient_Radius = 20.0f;        // pair search + hearing range around the player
+    float Ambient_Pair_Distance = 4.0f;  // max distance between the two NPCs
+    int Ambient_Max_Lines = 4;
+    int Ambient_Max_Tokens = 40;         // per line
+    int Ambient_Tokens_Per_Minute = 300; // hard throughput budget
+    int Ambient_Cooldown_Sec = 45;       // pause between exchanges
 };
 
 struct KnowledgeSection {
@@ -0,0 +1,310 @@
+#define NOMINMAX
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <thread>
+// No main.h: this file also builds on Linux for tests/CpuGovernorTest.cpp
+#include "AbstractTypes.h"
+#include "helperfunctions.h"
+#include "ConfigReader.h"
+#include "CpuGovernor.h"
+using namespace AbstractTypes;
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------
+// CPU GOVERNOR
+// Policies are computed once from the topology. The only state that changes
+// afterwards is which workloads are running (atomics) and the frame-time
+// throttle (game thread). The LLM's ggml threadpool lives in CpuThreadpool.cpp.
+// ------------------------------------------------------------
+
+// --- PLATFORMS ---
+#ifdef _WIN32
+// Only processor group 0 (up to 64 logical processors) is used
+class WindowsCpuPlatform : public ICpuPlatform {
+public:
+    const char* Name() const override { return "Windows"; }
+
+    bool DetectTopology(CpuTopology& out) override {
+        DWORD len = 0;
+        GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &len);
+        if (len == 0) return false;
+        std::vector<char> buf(len);
+        auto* first = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.data());
+        if (!GetLogicalProcessorInformationEx(RelationProcessorCore, first, &len)) return false;
+
+        for (char* p = buf.data(); p < buf.data() + len;) {
+            auto* info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(p);
+            if (info->Relationship == RelationProcessorCore && info->Processor.GroupMask[0].Group == 0) {
+                CpuTopology::Core core;
+                core.efficiency = info->Processor.EfficiencyClass;
+                KAFFINITY mask = info->Processor.GroupMask[0].Mask;
+                for (int bit = 0; bit < 64; ++bit) if (mask & ((KAFFINITY)1 << bit)) core.logical.push_back(bit);
+                if (!core.logical.empty()) out.cores.push_back(core);
+            }
+            p += info->Size;
+        }
+        return !out.cores.empty();
+    }
+
+    bool SetCurrentThreadPriority(WorkPriority priority) override {
+        int prio = THREAD_PRIORITY_NORMAL;
+        if (priority == WorkPriority::BELOW_NORMAL) prio = THREAD_PRIORITY_BELOW_NORMAL;
+        if (priority == WorkPriority::LOW) prio = THREAD_PRIORITY_LOWEST;
+        return SetThreadPriority(GetCurrentThread(), prio) != 0;
+    }
+
+    bool SetCurrentThreadAffinity(const std::vector<int>& cpus) override {
+        DWORD_PTR mask = 0;
+        for (int c : cpus) if (c >= 0 && c < 64) mask |= (DWORD_PTR)1 << c;
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+};
+#else
+// sysfs topology, nice values and pthread affinity
+class LinuxCpuPlatform : public ICpuPlatform {
+public:
+    const char* Name() const override { return "Linux"; }
+
+    bool DetectTopology(CpuTopology& out) override {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        std::map<std::pair<int, int>, size_t> index; // (package, core) -> out.cores
+        for (int cpu = 0; cpu < n; ++cpu) {
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+            int core = ReadInt(base + "/topology/core_id", cpu);
+            int package = ReadInt(base + "/topology/physical_package_id", 0);
+            auto key = std::make_pair(package, core);
+            if (!index.count(key)) {
+                index[key] = out.cores.size();
+                out.cores.push_back(CpuTopology::Core());
+                out.cores.back().efficiency = ReadInt(base + "/cpu_capacity", 0); // big.LITTLE, else 0
+            }
+            out.cores[index[key]].logical.push_back(cpu);
+        }
+        return !out.cores.empty();
+    }
+
+    bool SetCurrentThreadPriority(WorkPriority priority) override {
+        int nice = 0;
+        if (priority == WorkPriority::BELOW_NORMAL) nice = 5;
+        if (priority == WorkPriority::LOW) nice = 10;
+        return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) == 0;
+    }
+
+    bool SetCurrentThreadAffinity(const std::vector<int>& cpus) override {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+        return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+private:
+    static int ReadInt(const std::string& path, int fallback) {
+        std::ifstream f(path);
+        int v;
+        return (f >> v) ? v : fallback;
+    }
+};
+#endif
+
+// --- STATE ---
+static const int LEGACY_THREADS = 4;                 // what llama/whisper used before the governor
+static const TimeMillis THROTTLE_AFTER_MS = 2000;    // frame time over budget this long -> throttle
+static const TimeMillis RELEASE_AFTER_MS = 5000;     // under 80% of the budget this long -> release
+
+static std::unique_ptr<ICpuPlatform> g_platform;
+static std::vector<WorkloadPolicy> g_policies;
+static std::atomic<bool> g_enabled{ false };
+static std::atomic<int> g_running[(int)Workload::COUNT];
+
+// Game thread only (ThrottleBackground() reads the atomic)
+static std::atomic<bool> g_throttled{ false };
+static std::atomic<float> g_frame_ema{ 0.0f };
+static TimeMillis g_last_frame = 0;
+static TimeMillis g_over_since = 0;
+static TimeMillis g_under_since = 0;
+
+// --- HELPERS ---
+static const char* WorkloadName(Workload w) {
+    switch (w) {
+    case Workload::LLM: return "LLM";
+    case Workload::STT: return "STT";
+    case Workload::TTS: return "TTS";
+    default: return "Background";
+    }
+}
+
+static std::vector<int> LogicalOf(const std::vector<CpuTopology::Core>& cores) {
+    std::vector<int> out;
+    for (const auto& c : cores) out.insert(out.end(), c.logical.begin(), c.logical.end());
+    return out;
+}
+
+// Same tick source as GetTimeMs() (GetTickCount64), without the game headers
+static TimeMillis NowMs() {
+    return (TimeMillis)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int CpuTopology::LogicalCount() const {
+    int n = 0;
+    for (const auto& c : cores) n += (int)c.logical.size();
+    return n;
+}
+
+// --- LIFECYCLE ---
+std::vector<WorkloadPolicy> CpuGovernor::BuildPolicies(const CpuTopology& topology, int gameCores) {
+    std::vector<WorkloadPolicy> policies((int)Workload::COUNT);
+    std::vector<CpuTopology::Core> cores = topology.cores;
+    const int n = (int)cores.size();
+    if (n == 0) {
+        for (auto& p : policies) p.threads = LEGACY_THREADS;
+        policies[(int)Workload::BACKGROUND].priority = WorkPriority::LOW;
+        return policies;
+    }
+
+    // Fast cores first. The game keeps the first ones, we never take all of them.
+    std::stable_sort(cores.begin(), cores.end(), [](const CpuTopology::Core& a, const CpuTopology::Core& b) { return a.efficiency > b.efficiency; });
+    const int topEfficiency = cores.front().efficiency;
+    const int nFast = (int)std::count_if(cores.begin(), cores.end(), [&](const CpuTopology::Core& c) { return c.efficiency == topEfficiency; });
+    if (gameCores < 0) gameCores = std::max(std::min(2, nFast - 1), nFast / 2);
+    gameCores = std::max(0, std::min(gameCores, n - 1));
+
+    std::vector<CpuTopology::Core> fast, slow;
+    for (int i = gameCores; i < n; ++i) (cores[i].efficiency == topEfficiency ? fast : slow).push_back(cores[i]);
+    // ggml waits for its slowest thread, so slow cores only join if there are too few fast ones
+    std::vector<CpuTopology::Core> llmCores = fast;
+    if (llmCores.size() < 2) llmCores.insert(llmCores.end(), slow.begin(), slow.end());
+    const std::vector<CpuTopology::Core>& bgCores = slow.empty() ? llmCores : slow;
+
+    const int llmThreads = std::max(1, (int)llmCores.size());
+    WorkloadPolicy& llm = policies[(int)Workload::LLM];
+    llm.threads = llmThreads;
+    llm.cpus = LogicalOf(llmCores);
+
+    WorkloadPolicy& stt = policies[(int)Workload::STT];
+    stt.threads = std::max(1, std::min(4, llmThreads / 2));
+    stt.cpus = llm.cpus;
+
+    WorkloadPolicy& tts = policies[(int)Workload::TTS];
+    tts.threads = std::max(1, std::min(2, (int)bgCores.size()));
+    tts.cpus = LogicalOf(bgCores);
+
+    WorkloadPolicy& bg = policies[(int)Workload::BACKGROUND];
+    bg.threads = std::max(1, (int)bgCores.size() / 2);
+    bg.priority = WorkPriority::LOW;
+    bg.cpus = LogicalOf(bgCores);
+    return policies;
+}
+
+void CpuGovernor::Initialize(std::unique_ptr<ICpuPlatform> platform) {
+    for (auto& r : g_running) r = 0;
+    if (platform) g_platform = std::move(platform);
+#ifdef _WIN32
+    else g_platform = std::make_unique<WindowsCpuPlatform>();
+#else
+    else g_platform = std::make_unique<LinuxCpuPlatform>();
+#endif
+
+    CpuTopology topology;
+    g_enabled = ConfigReader::g_Settings.Cpu_Governor != 0 && g_platform->DetectTopology(topology);
+    if (!g_enabled) {
+        g_policies = BuildPolicies(CpuTopology(), 0);
+        Log("CPU: Governor off, " + std::to_string(LEGACY_THREADS) + " threads per workload, default priorities.");
+        return;
+    }
+
+    g_policies = BuildPolicies(topology, ConfigReader::g_Settings.Cpu_Game_Cores);
+    Log("CPU: " + std::string(g_platform->Name()) + " topology, " + std::to_string(topology.cores.size()) + " cores / " +
+        std::to_string(topology.LogicalCount()) + " logical.");
+    for (int w = 0; w < (int)Workload::COUNT; ++w) {
+        const auto& p = g_policies[w];
+        std::string cpus;
+        for (int c : p.cpus) cpus += (cpus.empty() ? "" : ",") + std::to_string(c);
+        Log("CPU: " + std::string(WorkloadName((Workload)w)) + " -> " + std::to_string(p.threads) + " threads on [" + cpus + "]" +
+            (p.priority == WorkPriority::LOW ? ", low priority" : ""));
+    }
+}
+
+// --- POLICIES ---
+WorkloadPolicy CpuGovernor::GetPolicy(Workload workload) {
+    if (g_policies.empty()) g_policies = BuildPolicies(CpuTopology(), 0);
+    return g_policies[(int)workload];
+}
+
+bool CpuGovernor::IsEnabled() {
+    return g_enabled;
+}
+
+int CpuGovernor::ThreadsFor(Workload workload, bool interactive) {
+    int threads = GetPolicy(workload).threads;
+    if (!g_enabled) return threads;
+
+    if (workload == Workload::LLM) {
+        // Whisper runs on the same cores, don't oversubscribe them (one thread set per busy whisper state)
+        threads -= g_running[(int)Workload::STT].load() * GetPolicy(Workload::STT).threads;
+        if (!interactive && ThrottleBackground()) threads /= 2;
+    }
+    if (workload == Workload::BACKGROUND && ThrottleBackground()) threads = 1;
+    return std::max(1, threads);
+}
+
+void CpuGovernor::ApplyToCurrentThread(Workload workload) {
+    if (!g_enabled || !g_platform) return;
+    WorkloadPolicy p = GetPolicy(workload);
+    g_platform->SetCurrentThreadPriority(p.priority);
+    if (!p.cpus.empty()) g_platform->SetCurrentThreadAffinity(p.cpus);
+}
+
+// --- FRAME SIGNAL ---
+void CpuGovernor::OnFrame() {
+    TimeMillis now = NowMs();
+    if (g_last_frame == 0) { g_last_frame = now; return; }
+    float dt = (float)(now - g_last_frame);
+    g_last_frame = now;
+    if (dt > 1000.0f) return; // pause menu / loading screen, not a frame
+
+    float ema = g_frame_ema.load(std::memory_order_relaxed);
+    ema = (ema == 0.0f) ? dt : ema * 0.9f + dt * 0.1f;
+    g_frame_ema.store(ema, std::memory_order_relaxed);
+
+    const float budget = (float)std::max(1, ConfigReader::g_Settings.Cpu_Frame_Budget_Ms);
+    g_over_since = (ema > budget) ? (g_over_since ? g_over_since : now) : 0;
+    g_under_since = (ema < budget * 0.8f) ? (g_under_since ? g_under_since : now) : 0;
+
+    if (!g_throttled && g_over_since && now - g_over_since >= THROTTLE_AFTER_MS) {
+        g_throttled = true;
+        Log("CPU: Frame time " + std::to_string((int)ema) + " ms over budget, throttling background work.");
+    }
+    else if (g_throttled && g_under_since && now - g_under_since >= RELEASE_AFTER_MS) {
+        g_throttled = false;
+        Log("CPU: Frame time back to " + std::to_string((int)ema) + " ms, background work resumes.");
+    }
+}
+
+bool CpuGovernor::ThrottleBackground() {
+    return g_enabled && g_throttled.load(std::memory_order_relaxed);
+}
+
+float CpuGovernor::GetFrameTimeMs() {
+    return g_frame_ema.load(std::memory_order_relaxed);
+}
+
+// --- SCOPED WORKLOAD ---
+ScopedWorkload::ScopedWorkload(Workload workload) : m_workload(workload) {
+    g_running[(int)m_workload]++;
+}
+
+ScopedWorkload::~ScopedWorkload() {
+    g_running[(int)m_workload]--;
+}
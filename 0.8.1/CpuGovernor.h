@@ -0,0 +1,102 @@
+#pragma once
+// CpuGovernor.h
+#include <string>
+#include <vector>
+#include <memory>
+
+struct llama_context;
+
+// Who is asking for CPU time
+enum class Workload : int {
+    LLM = 0,        // decode thread + its ggml threadpool
+    STT = 1,        // whisper
+    TTS = 2,        // audio DLL (queried through API_Cpu_GetThreads)
+    BACKGROUND = 3, // summaries, warm-ups, ambient chatter
+    COUNT
+};
+
+enum class WorkPriority { LOW, BELOW_NORMAL, NORMAL };
+
+// Physical cores with their logical processors. Higher efficiency = faster core (P-core).
+struct CpuTopology {
+    struct Core {
+        std::vector<int> logical;
+        int efficiency = 0;
+    };
+    std::vector<Core> cores;
+    int LogicalCount() const;
+};
+
+struct WorkloadPolicy {
+    int threads = 1;
+    WorkPriority priority = WorkPriority::NORMAL;
+    std::vector<int> cpus; // logical processors, empty = no affinity
+};
+
+// OS specific part. Everything else is plain code and runs anywhere.
+class ICpuPlatform {
+public:
+    virtual ~ICpuPlatform() = default;
+    virtual const char* Name() const = 0;
+    virtual bool DetectTopology(CpuTopology& out) = 0;
+    virtual bool SetCurrentThreadPriority(WorkPriority priority) = 0;
+    virtual bool SetCurrentThreadAffinity(const std::vector<int>& cpus) = 0;
+};
+
+// Fixed topology, records what would have been applied
+class MockCpuPlatform : public ICpuPlatform {
+public:
+    explicit MockCpuPlatform(CpuTopology topology) : m_topology(std::move(topology)) {}
+    const char* Name() const override { return "Mock"; }
+    bool DetectTopology(CpuTopology& out) override { out = m_topology; return !out.cores.empty(); }
+    bool SetCurrentThreadPriority(WorkPriority priority) override { lastPriority = priority; return true; }
+    bool SetCurrentThreadAffinity(const std::vector<int>& cpus) override { lastAffinity = cpus; return true; }
+    WorkPriority lastPriority = WorkPriority::NORMAL;
+    std::vector<int> lastAffinity;
+private:
+    CpuTopology m_topology;
+};
+
+// Splits the CPU between the game and our workloads. The first Cpu_Game_Cores fast
+// cores are left to the game, LLM and STT share the rest (STT threads are taken out
+// of the LLM budget while a transcription runs), background work prefers slow cores.
+// When the script loop's frame time degrades, background work is throttled.
+class CpuGovernor {
+public:
+    // --- LIFECYCLE ---
+    // platform = nullptr picks Windows / Linux
+    static void Initialize(std::unique_ptr<ICpuPlatform> platform = nullptr);
+    // Pure policy function, no OS calls (used by Initialize, see tests/CpuGovernorTest.cpp)
+    static std::vector<WorkloadPolicy> BuildPolicies(const CpuTopology& topology, int gameCores);
+
+    // --- POLICIES ---
+    static WorkloadPolicy GetPolicy(Workload workload);
+    // Cpu_Governor = 1 and the topology was detected
+    static bool IsEnabled();
+    // Thread count right now (LLM shrinks while STT runs or when only background rows are decoded under throttle)
+    static int ThreadsFor(Workload workload, bool interactive = true);
+    // Priority + affinity of the calling thread
+    static void ApplyToCurrentThread(Workload workload);
+
+    // LLM worker threads: one ggml threadpool sized and pinned by the LLM policy, attached to every g_ctx
+    // (CpuThreadpool.cpp, so that this file builds without llama/ggml)
+    static void AttachThreadpool(llama_context* ctx);
+    // After the last context using it was freed
+    static void ReleaseThreadpool();
+
+    // --- FRAME SIGNAL (game thread) ---
+    static void OnFrame();
+    static bool ThrottleBackground();
+    static float GetFrameTimeMs();
+};
+
+// Marks a workload as running for ThreadsFor()
+class ScopedWorkload {
+public:
+    explicit ScopedWorkload(Workload workload);
+    ~ScopedWorkload();
+    ScopedWorkload(const ScopedWorkload&) = delete;
+    ScopedWorkload& operator=(const ScopedWorkload&) = delete;
+private:
+    Workload m_workload;
+};
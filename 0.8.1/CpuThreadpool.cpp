@@ -0,0 +1,38 @@
+#include "main.h"
+#include "ggml-cpu.h"
+#include "CpuGovernor.h"
+
+// ------------------------------------------------------------
+// LLM THREADPOOL
+// The LLM gets one ggml threadpool for its whole lifetime, ThreadsFor() only
+// decides how many of its threads a decode uses. Kept out of CpuGovernor.cpp
+// so the policy code builds without llama/ggml.
+// ------------------------------------------------------------
+
+static ggml_threadpool* g_llm_pool = nullptr;
+
+void CpuGovernor::AttachThreadpool(llama_context* ctx) {
+    if (!ctx) return;
+    const int threads = ThreadsFor(Workload::LLM);
+    llama_set_n_threads(ctx, threads, threads);
+    if (!IsEnabled()) return;
+
+    if (!g_llm_pool) {
+        WorkloadPolicy p = GetPolicy(Workload::LLM);
+        ggml_threadpool_params tpp = ggml_threadpool_params_default(p.threads);
+        for (int c : p.cpus) if (c >= 0 && c < GGML_MAX_N_THREADS) tpp.cpumask[c] = true;
+        tpp.strict_cpu = false; // threads may move between the LLM cores, but not onto the game's
+        g_llm_pool = ggml_threadpool_new(&tpp);
+        if (!g_llm_pool) {
+            Log("CPU: ggml_threadpool_new failed, llama keeps its own threads.");
+            return;
+        }
+    }
+    llama_attach_threadpool(ctx, g_llm_pool, g_llm_pool);
+}
+
+void CpuGovernor::ReleaseThreadpool() {
+    if (!g_llm_pool) return;
+    ggml_threadpool_free(g_llm_pool);
+    g_llm_pool = nullptr;
+}
@@ -0,0 +1,94 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <atomic>
+#include <vector>
+#include "main.h"
+#include "EventQueue.h"
+
+// ------------------------------------------------------------
+// EVENT QUEUE
+// Intrusive MPSC list with a stub node (Vyukov). A producer swaps itself in
+// as the tail and then links the previous tail to it; the consumer follows
+// the links from the head. Between those two steps of a producer the list
+// looks shorter than it is, Dispatch just picks the rest up next tick.
+// ------------------------------------------------------------
+
+// --- STATE ---
+struct EventNode {
+    std::atomic<EventNode*> next{ nullptr };
+    CompletionEvent ev;
+};
+
+static EventNode g_stub;
+static std::atomic<EventNode*> g_tail{ &g_stub }; // producers
+static EventNode* g_head = &g_stub;               // consumer, its event was already taken
+static std::atomic<int> g_depth{ 0 };
+static std::atomic<uint64_t> g_next_ticket{ 1 };
+static std::vector<EventHandler> g_handlers[(int)EventType::COUNT];
+
+// --- HELPERS ---
+static bool Pop(CompletionEvent& out) {
+    EventNode* head = g_head;
+    EventNode* next = head->next.load(std::memory_order_acquire);
+    if (!next) return false;
+    out = std::move(next->ev);
+    g_head = next; // becomes the new stub
+    if (head != &g_stub) delete head;
+    g_depth--;
+    return true;
+}
+
+// --- PRODUCERS ---
+void EventQueue::Post(CompletionEvent ev) {
+    EventNode* node = new EventNode();
+    node->ev = std::move(ev);
+    g_depth++;
+    EventNode* prev = g_tail.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+void EventQueue::Post(EventType type, uint64_t ticket, std::string text, uint64_t chatID, int64_t arg) {
+    CompletionEvent ev;
+    ev.type = type;
+    ev.ticket = ticket;
+    ev.chatID = chatID;
+    ev.arg = arg;
+    ev.text = std::move(text);
+    Post(std::move(ev));
+}
+
+uint64_t EventQueue::NewTicket() {
+    return g_next_ticket++;
+}
+
+// --- CONSUMER ---
+void EventQueue::Subscribe(EventType type, EventHandler handler) {
+    g_handlers[(int)type].push_back(std::move(handler));
+}
+
+int EventQueue::Dispatch(int maxEvents) {
+    int handled = 0;
+    CompletionEvent ev;
+    while (handled < maxEvents && Pop(ev)) {
+        for (auto& handler : g_handlers[(int)ev.type]) {
+            try { handler(ev); }
+            catch (const std::exception& e) {
+                Log("EVENTS: Handler for event " + std::to_string((int)ev.type) + " threw: " + e.what());
+            }
+        }
+        handled++;
+    }
+    return handled;
+}
+
+void EventQueue::Clear() {
+    CompletionEvent ev;
+    while (Pop(ev)) {}
+}
+
+int EventQueue::GetDepth() {
+    return g_depth;
+}
@@ -0,0 +1,38 @@
+#pragma once
+// EventQueue.h
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class EventType : int { REPLY_READY, TOKEN_CHUNK, TRANSCRIPT_READY, TRANSCRIPT_PARTIAL, SUMMARY_READY, TTS_DONE, COUNT };
+
+// Result of an asynchronous stage, posted by the thread that produced it
+struct CompletionEvent {
+    EventType type = EventType::REPLY_READY;
+    uint64_t ticket = 0; // from NewTicket() at submit time, tells current results from stale ones
+    uint64_t chatID = 0; // conversation the result belongs to (0 = none)
+    int64_t arg = 0;     // SUMMARY_READY: history lines it replaces (0 = archive summary), TTS_DONE: final AudioJobState,
+                         // TRANSCRIPT_PARTIAL: length of the committed (final) part of 'text'
+    std::string text;
+};
+
+using EventHandler = std::function<void(const CompletionEvent&)>;
+
+// Lock-free multi-producer / single-consumer queue from the workers to the script thread.
+// Workers post, the script tick drains it and runs the handlers of each event in order.
+class EventQueue {
+public:
+    // --- PRODUCERS (any thread, never blocks) ---
+    static void Post(CompletionEvent ev);
+    static void Post(EventType type, uint64_t ticket, std::string text, uint64_t chatID = 0, int64_t arg = 0);
+    // Unique and never 0
+    static uint64_t NewTicket();
+
+    // --- CONSUMER (script thread only) ---
+    static void Subscribe(EventType type, EventHandler handler);
+    // Handles up to maxEvents events, returns how many. An empty queue costs one atomic load.
+    static int Dispatch(int maxEvents = 64);
+    // Drops queued events without running handlers
+    static void Clear();
+    static int GetDepth();
+};
@@ -19,4 +19,11 @@ enum class InferenceState {
     COMPLETE
 };
 
+// Scheduling order for LLM requests (lower value is admitted first)
+enum class GenPriority {
+    INTERACTIVE, // the reply the player is waiting for
+    BACKGROUND,  // summaries and other bookkeeping
+    AMBIENT      // NPC-to-NPC small talk, preempted by any interactive request
+};
+
 //EOF
\ No newline at end of file
@@ -18,36 +18,23 @@ extern std::string LOG_FILE_NAME_METRICS = "kkamel_metrics.log";
 extern std::string LOG_FILE_NAME_AUDIO = "kkamel_audio.log";
 extern std::string LOG_FILE_NAME3 = "kkamel_load.log";
 
+// All Log* functions queue into the AsyncLogger, the file I/O happens on its writer thread
+
 //logs the general base data
 void Log(const std::string& msg) {
-    std::ofstream f(LOG_FILE_NAME, std::ios::app);
-    if (f) {
-        auto t = std::time(nullptr);
-        auto tm = *std::localtime(&t);
-        f << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] " << msg << "\n";
-    }
+    AsyncLogger::Write(LogFile::MAIN, nullptr, msg);
 }
 
 
 //logs metadata
 void LogM(const std::string& msg) {
-    std::ofstream f(LOG_FILE_NAME_METRICS, std::ios::app);
-    if (f) {
-        auto t = std::time(nullptr);
-        auto tm = *std::localtime(&t);
-        f << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] " << msg << "\n";
-    }
+    AsyncLogger::Write(LogFile::METRICS, nullptr, msg);
 }
 
 
 //logs audio A
 void LogA(const std::string& msg) {
-    std::ofstream f(LOG_FILE_NAME_AUDIO, std::ios::app);
-    if (f) {
-        auto t = std::time(nullptr);
-        auto tm = *std::localtime(&t);
-        f << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] " << msg << "\n";
-    }
+    AsyncLogger::Write(LogFile::AUDIO, nullptr, msg);
 }
 
 /**
@@ -65,13 +52,7 @@ static void LogA(const std::string& message) {
 
 // logs config loading
 void LogConfig(const std::string& message) {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::ofstream log("kkamel_loader.log", std::ios_base::app);
-    if (log.is_open()) {
-        log << "[" << std::put_time(std::localtime(&now_c), "%Y-%m-%d %H:%M:%S") << "] [ConfigReader] " << message << "\n";
-        log.flush();
-    }
+    AsyncLogger::Write(LogFile::LOADER, "ConfigReader", message);
 }
 
 
@@ -167,6 +148,13 @@ extern "C" {
         if (g_target_ped != 0 && g_target_ped != pedHandle) {
             EndConversation();
         }
+        AmbientDialogue::Abort("API conversation");
+
+        // Same trace session as a key-started conversation (EndConversation writes it out)
+        if (g_convo_state == ConvoState::IDLE) {
+            Tracer::BeginSession();
+            Tracer::Instant("API_StartConversation");
+        }
 
         g_target_ped = pedHandle;
 
@@ -179,7 +167,7 @@ extern "C" {
         // 2. Handle Name
         std::string finalName;
         if (name_override && name_override[0] != '\0') finalName = name_override;
-        else {
+        else if (!TargetPredictor::TakeWarmName(pedHandle, finalName)) {
             NpcPersona p = ConfigReader::GetPersona(pedHandle);
             finalName = GenerateNpcName(p);
         }
@@ -199,11 +187,7 @@ extern "C" {
             prompt += "\n[SYSTEM INSTRUCTION]: " + instrStr + "\n<|assistant|>\n";
         }
 
-        g_response_start_time = std::chrono::high_resolution_clock::now();
-        g_llm_start_time = std::chrono::high_resolution_clock::now();
-
-        g_llm_future = std::async(std::launch::async, GenerateLLMResponse, prompt);
-        g_llm_state = InferenceState::RUNNING;
+        SubmitReply(prompt);
     }
 
 
@@ -234,13 +218,9 @@ extern "C" {
 
 
     __declspec(dllexport) void API_ClearCache() {
-        if (g_ctx) {
-            llama_memory_t mem = llama_get_memory(g_ctx);
-            if (mem) {
-                llama_memory_clear(mem, true);
-                Log("[API] KV Cache (LLM working memory) cleared.");
-                return;
-            }
+        if (g_ctx && BatchScheduler::ClearCache()) {
+            Log("[API] KV Cache (LLM working memory) cleared once running requests finish.");
+            return;
         }
         Log("[API] KV Cache: No context/memory to clear.");
     }
@@ -290,75 +270,18 @@ extern "C" {
             }
 
 
-            enum ggml_type kv_type = GGML_TYPE_F32;
-            llama_context_params ctx_params = llama_context_default_params();
-            ctx_params.n_ctx = static_cast<uint32_t>(ConfigReader::g_Settings.Max_Working_Input);
-            ctx_params.n_batch = 1024;
-            ctx_params.n_ubatch = 256;
-
-            if (ConfigReader::g_Settings.USE_VRAM_PREFERED) {
-                ctx_params.type_k = GGML_TYPE_F16;
-                ctx_params.type_v = GGML_TYPE_F16;
-            }
-
-            g_ctx = llama_init_from_model(g_model, ctx_params);
+            // Same context setup as the startup path (MemoryGovernor picks the step from the free VRAM)
+            g_ctx = MemoryGovernor::CreateContext();
             if (!g_ctx) {
                 Log("FATAL: API_LoadLLM failed: llama_init_from_model failed.");
                 return false;
             }
 
-
-            if (ConfigReader::g_Settings.USE_VRAM_PREFERED) {
-                ctx_params.type_k = GGML_TYPE_F16;
-                ctx_params.type_v = GGML_TYPE_F16;
-            }
-            switch (ConfigReader::g_Settings.KV_Cache_Quantization_Type)
-            {
-            case 2: 
-                kv_type = GGML_TYPE_Q2_K;
-                Log("KV Cache Quantization: Using Q2_K (~2.56 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            case 3: 
-                kv_type = GGML_TYPE_Q3_K;
-                Log("KV Cache Quantization: Using Q3_K (~3.43 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            case 4: 
-                kv_type = GGML_TYPE_Q4_K;
-                Log("KV Cache Quantization: Using Q4_K (~4.5 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            case 5: 
-                kv_type = GGML_TYPE_Q5_K;
-                Log("KV Cache Quantization: Using Q5_K (~5.5 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            case 6: 
-                kv_type = GGML_TYPE_Q6_K;
-                Log("KV Cache Quantization: Using Q6_K (~6.56 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            case 8: 
-                kv_type = GGML_TYPE_Q8_0;
-                Log("KV Cache Quantization: Using Q8_0 (8 bits)");
-                ctx_params.type_k = kv_type;
-                ctx_params.type_v = kv_type;
-                break;
-
-            default:
-                Log("KV Cache Quantization: Using default float type (F32/F16).");
-                break;
+            SpeculativeDecoder::InitializeFromConfig(root);
+            if (!BatchScheduler::Start()) {
+                Log("FATAL: API_LoadLLM failed: BatchScheduler could not start.");
+                ShutdownLLM();
+                return false;
             }
 
             if (ConfigReader::g_Settings.StT_Enabled) {
@@ -430,6 +353,81 @@ extern "C" {
         return GetFreeVRAM_MB();
     }
 
+    // metric: MetricHist (0 TTFT ms, 1 prefill tok/s, 2 decode tok/s, 3 STT ms, 4 TTS RTF), percentile 0..100
+    __declspec(dllexport) float API_Metrics_GetPercentile(int metric, float percentile) {
+        return (float)Metrics::Percentile((MetricHist)metric, percentile);
+    }
+
+    __declspec(dllexport) long long API_Metrics_GetSampleCount(int metric) {
+        return (long long)Metrics::GetCount((MetricHist)metric);
+    }
+
+    // counter: MetricCounter (0 cache hits, 1 cache misses, 2 cancellations, 3 LLM timeouts, 4 STT timeouts)
+    __declspec(dllexport) long long API_Metrics_GetCounter(int counter) {
+        return (long long)Metrics::GetCounter((MetricCounter)counter);
+    }
+
+    __declspec(dllexport) bool API_Metrics_GetSummary(char* buffer, int bufferSize) {
+        std::string summary = Metrics::Summary();
+        if (!buffer || summary.length() + 1 > static_cast<size_t>(bufferSize)) return false;
+
+        strcpy(buffer, summary.c_str());
+        return true;
+    }
+
+    // Transcript of the push-to-talk recording still in progress (committed text + current guess)
+    __declspec(dllexport) bool API_Stt_GetPartial(char* buffer, int bufferSize) {
+        std::string partial = SttStream::GetPartial();
+        if (!buffer || partial.length() + 1 > static_cast<size_t>(bufferSize)) return false;
+
+        strcpy(buffer, partial.c_str());
+        return true;
+    }
+
+    // Whisper window benchmark over <corpusDir>\*.wav + .txt (empty = <mod root>STT_Bench\). Results: stt_bench.csv + STT log
+    __declspec(dllexport) bool API_Stt_RunBenchmark(const char* corpusDir) {
+        std::string dir = (corpusDir && corpusDir[0]) ? std::string(corpusDir) : GetModRootPath() + "STT_Bench\\";
+        return SttBench::Start(dir);
+    }
+
+    __declspec(dllexport) bool API_Stt_GetBenchmarkSummary(char* buffer, int bufferSize) {
+        if (SttBench::IsRunning()) return false;
+        std::string summary = SttBench::GetSummary();
+        if (!buffer || summary.empty() || summary.length() + 1 > static_cast<size_t>(bufferSize)) return false;
+
+        strcpy(buffer, summary.c_str());
+        return true;
+    }
+
+    __declspec(dllexport) void API_Metrics_Reset() {
+        Metrics::Reset();
+    }
+
+    // workload: 0 LLM, 1 STT, 2 TTS, 3 background. For the audio DLL and other mods sharing the CPU.
+    __declspec(dllexport) int API_Cpu_GetThreads(int workload) {
+        if (workload < 0 || workload >= (int)Workload::COUNT) return 0;
+        return CpuGovernor::ThreadsFor((Workload)workload);
+    }
+
+    __declspec(dllexport) bool API_Cpu_IsThrottled() {
+        return CpuGovernor::ThrottleBackground();
+    }
+
+    // Task pool counters: 0 workers, 1 queued, 2 running, 3 completed, 4 cancelled, 5 failed, 6 stolen
+    __declspec(dllexport) long long API_Tasks_GetStat(int which) {
+        TaskPoolStats s = TaskPool::GetStats();
+        switch (which) {
+        case 0: return s.workers;
+        case 1: return s.queued;
+        case 2: return s.running;
+        case 3: return (long long)s.completed;
+        case 4: return (long long)s.cancelled;
+        case 5: return (long long)s.failed;
+        case 6: return (long long)s.stolen;
+        default: return -1;
+        }
+    }
+
     __declspec(dllexport) int API_Convo_Initiate(int initiatorHandle, int targetHandle, int forceID) {
         return (int)ConvoManager::InitiateConversation(initiatorHandle, targetHandle, forceID);
     }
@@ -479,26 +477,8 @@ extern "C" {
 }
 
 float GetFreeVRAM_MB() {
-    IDXGIFactory4* pFactory = nullptr;
     float freeMB = 24000.0f; // Fallback: Viel Speicher annehmen, falls Check fehlschlgt
 
-    if (SUCCEEDED(CreateDXGIFactory1(__uuidof(IDXGIFactory4), (void**)&pFactory))) {
-        IDXGIAdapter* pAdapter = nullptr;
-        if (SUCCEEDED(pFactory->EnumAdapters(0, &pAdapter))) {
-            IDXGIAdapter3* pAdapter3 = nullptr;
-            if (SUCCEEDED(pAdapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&pAdapter3))) {
-                DXGI_QUERY_VIDEO_MEMORY_INFO memInfo;
-                if (SUCCEEDED(pAdapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memInfo))) {
-                    // Budget = Gesamter VRAM, Usage = Verbrauchter VRAM
-                    float budgetMB = static_cast<float>(memInfo.Budget) / 1024.f / 1024.f;
-                    float usedMB = static_cast<float>(memInfo.CurrentUsage) / 1024.f / 1024.f;
-                    freeMB = budgetMB - usedMB;
-                }
-                pAdapter3->Release();
-            }
-            pAdapter->Release();
-        }
-        pFactory->Release();
-    }
-    return freeMB;
+    // Budget - Usage aus dem ResourceMonitor-Cache (kein DXGI-Aufruf auf diesem Thread)
+    return ResourceMonitor::GetFreeVRAM_MB(freeMB);
 }
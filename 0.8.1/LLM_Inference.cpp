@@ -8,11 +8,13 @@ using namespace AbstractTypes;
 
 
 #include <algorithm> // Fr std::min, std::max
+#include <condition_variable>
 #include "whisper.h"
 #include "whisper-arch.h"
 #include <string.h>
 #include "main.h"
 #include "LLM_Inference.h"
+#include "AudioRing.h"
 
 ModSettings g_ModSettings;
 // ------------------------------------------------------------
@@ -25,7 +27,7 @@ ModSettings g_ModSettings;
 llama_model* g_model = nullptr;
 llama_context* g_ctx = nullptr;
 InferenceState g_llm_state = InferenceState::IDLE;
-std::future<std::string> g_llm_future;
+uint64_t g_llm_ticket = 0;
 std::string g_llm_response = "";
 std::chrono::high_resolution_clock::time_point g_response_start_time;
 static int32_t g_repeat_last_n = 512;
@@ -40,10 +42,14 @@ struct llama_adapter_lora* g_lora_adapter = nullptr;
 
 // STT Globals
 struct whisper_context* g_whisper_ctx = nullptr;
-std::vector<float> g_audio_buffer;
+std::vector<float> g_audio_buffer; // current recording, filled from g_capture_ring on the script thread
 ma_device g_capture_device;
-bool g_is_recording = false;
-std::future<std::string> g_stt_future;
+std::atomic<bool> g_is_recording{ false };
+static AudioRing g_capture_ring;    // written by the miniaudio callback
+static std::vector<float> g_spare_buffer; // swapped in when a recording is taken
+static std::mutex g_spare_mutex;
+static size_t g_max_record_samples = 0;
+TaskHandle<std::string> g_stt_future;
 
 // --- MEMORY MONITORING ---
 static size_t g_memoryAllocations = 0;
@@ -52,12 +58,7 @@ static size_t g_memoryFrees = 0;
 
 //logs audio A
 static void LogA(const std::string& msg) {
-    std::ofstream f("kkamel_audio2.log", std::ios::app);
-    if (f) {
-        auto t = std::time(nullptr);
-        auto tm = *std::localtime(&t);
-        f << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] " << msg << "\n";
-    }
+    AsyncLogger::Write(LogFile::AUDIO2, nullptr, msg);
 }
 
 
@@ -71,16 +72,21 @@ void LogMemoryStats() {
 
 // --- LOGGING ---
 static void LogM(const std::string& message) {
-    std::ofstream log(LOG_FILE_NAME3, std::ios_base::app);
-    if (log.is_open()) {
-        auto t = std::time(nullptr);
-        auto tm = *std::localtime(&t);
-        log << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] [ModMain] " << message << "\n";
-        log.flush();
-    }
+    AsyncLogger::Write(LogFile::LOAD, "ModMain", message);
 }
 
 static void LlamaLogCallback(ggml_log_level level, const char* text, void* user_data) {
+    // llama.cpp talks a lot (every tensor at load time). Only warnings and errors are INFO.
+    // CONT continues the previous message of this thread and keeps its level.
+    thread_local LogLevel lastLevel = LogLevel::DEBUG;
+    LogLevel ours = LogLevel::DEBUG;
+    if (level == GGML_LOG_LEVEL_ERROR) ours = LogLevel::ERR;
+    else if (level == GGML_LOG_LEVEL_WARN) ours = LogLevel::WARN;
+    else if (level == GGML_LOG_LEVEL_DEBUG) ours = LogLevel::TRACE;
+    else if (level == GGML_LOG_LEVEL_CONT) ours = lastLevel;
+    lastLevel = ours;
+    if (!LogEnabled(ours)) return;
+
     std::string logText = text;
     if (!logText.empty() && logText.back() == '\n') {
         logText.pop_back();
@@ -89,13 +95,7 @@ static void LlamaLogCallback(ggml_log_level level, const char* text, void* user_
 }
 
 void LogLLM(const std::string& message) {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::ofstream log("kkamel.log", std::ios_base::app);
-    if (log.is_open()) {
-        log << "[" << std::put_time(std::localtime(&now_c), "%Y-%m-%d %H:%M:%S") << "] [LLM_Inference] " << message << "\n";
-        log.flush();
-    }
+    AsyncLogger::Write(LogFile::MAIN, "LLM_Inference", message);
 }
 
 // --- NAMENSLISTEN (WIE IN v1.0.8) ---
@@ -193,15 +193,51 @@ void UpdateRepeatPenaltyFromConfig() {
         " (based on MaxHistoryTokens = " + std::to_string(ConfigReader::g_Settings.MaxHistoryTokens) + ")");
 }
 
-std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory) {
-    // Safety check
-    if (!g_model || !g_ctx) {
-        LogLLM("AssemblePrompt FATAL: g_model or g_ctx is null.");
-        return "";
+// Knowledge sections matched by keywords of the last player message. They depend on the
+// line the player is still typing, so with the prefix cache they go after the history.
+static std::string BuildKeywordContext(const std::vector<std::string>& chatHistory) {
+    std::stringstream injectedContext;
+
+    // Scan the last player message for keywords (Your Original Logic)
+    std::string lastPlayerMsg = "";
+    if (!chatHistory.empty()) {
+        for (auto it = chatHistory.rbegin(); it != chatHistory.rend(); ++it) {
+            if (it->find("<|user|>") != std::string::npos) { lastPlayerMsg = *it; break; }
+        }
     }
-    const llama_vocab* vocab = llama_model_get_vocab(g_model);
-    if (!vocab) return "";
 
+    std::string normalizedPlayerInput = NormalizeString(lastPlayerMsg);
+
+    if (!normalizedPlayerInput.empty()) {
+        for (const auto& pair : ConfigReader::g_KnowledgeDB) {
+            const auto& section = pair.second;
+            if (section.isAlwaysLoaded) continue; // already part of the system block
+
+            for (const std::string& keyword : section.keywords) {
+                if (normalizedPlayerInput.find(keyword) != std::string::npos) {
+                    if (section.loadEntireSectionOnMatch) {
+                        injectedContext << section.content;
+                    }
+                    else {
+                        for (const auto& kvPair : section.keyValues) {
+                            if (NormalizeString(kvPair.first) == keyword) {
+                                injectedContext << kvPair.first << " = " << kvPair.second << "\n";
+                                break;
+                            }
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    return injectedContext.str();
+}
+
+// System block (persona, scenario, injected context). Kept separate so the same text can be
+// prefilled before the conversation starts. Without chatHistory nothing in here changes by the
+// minute (the game time goes after the history, see BuildPrompt), so a cached prefix stays valid.
+std::string AssembleSystemPrompt(AHandle targetPed, AHandle playerPed, const std::string& fallbackName, const std::vector<std::string>* chatHistory) {
     // =================================================================
     // STEP 1: Build the Base Prompt & Dynamically Injected Context
     // =================================================================
@@ -217,7 +253,7 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
     EntityData targetData = EntityRegistry::GetData(targetID);
 
     // 3. Determine Name (Registry override wins over Config)
-    std::string npcName = !targetData.overrideName.empty() ? targetData.overrideName : g_current_npc_name;
+    std::string npcName = !targetData.overrideName.empty() ? targetData.overrideName : fallbackName;
     // [INTEGRATION END] -----------------------------------------------
 
     // --- Part A: Core Personality & Scenario ---
@@ -259,7 +295,6 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
     basePromptStream << "- Role: " << target.type << " / " << target.subGroup << "\n";
     basePromptStream << "- Traits: " << target.behaviorTraits << "\n";
     basePromptStream << "\nSCENARIO:\n";
-    basePromptStream << "- Time: " << GetCurrentTimeState() << "\n";
     basePromptStream << "- Interacting with: " << playerName << " (Role: " << player.type << " / " << player.subGroup << ")\n";
     basePromptStream << "- Character Relationship: " << char_rel << "\n";
     basePromptStream << "- Group Relationship: " << group_rel << "\n";
@@ -273,7 +308,6 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
 
     // --- Part B: The Dynamic Context Injection Logic ---
     std::stringstream injectedContext;
-    std::set<std::string> alreadyInjectedSections;
 
     // [INTEGRATION: INJECT CUSTOM MEMORY] -----------------------------
     // If the Registry has saved memories (facts), inject them first
@@ -286,45 +320,11 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
     for (const auto& pair : ConfigReader::g_KnowledgeDB) {
         if (pair.second.isAlwaysLoaded) {
             injectedContext << pair.second.content;
-            alreadyInjectedSections.insert(pair.first);
-        }
-    }
-
-    // 2. Scan the last player message for keywords (Your Original Logic)
-    std::string lastPlayerMsg = "";
-    if (!chatHistory.empty()) {
-        for (auto it = chatHistory.rbegin(); it != chatHistory.rend(); ++it) {
-            if (it->find("<|user|>") != std::string::npos) { lastPlayerMsg = *it; break; }
         }
     }
 
-    std::string normalizedPlayerInput = NormalizeString(lastPlayerMsg);
-
-    if (!normalizedPlayerInput.empty()) {
-        for (const auto& pair : ConfigReader::g_KnowledgeDB) {
-            const auto& section = pair.second;
-            if (section.isAlwaysLoaded || alreadyInjectedSections.count(pair.first)) continue;
-
-            for (const std::string& keyword : section.keywords) {
-                if (normalizedPlayerInput.find(keyword) != std::string::npos) {
-                    if (section.loadEntireSectionOnMatch) {
-                        injectedContext << section.content;
-                    }
-                    else {
-                        for (const auto& kvPair : section.keyValues) {
-                            if (NormalizeString(kvPair.first) == keyword) {
-                                injectedContext << kvPair.first << " = " << kvPair.second << "\n";
-                                break;
-                            }
-                        }
-                    }
-                    alreadyInjectedSections.insert(pair.first);
-                    goto next_section_label;
-                }
-            }
-        next_section_label:;
-        }
-    }
+    // 2. Scan the last player message for keywords (no prefix cache: nothing to keep stable)
+    if (chatHistory) injectedContext << BuildKeywordContext(*chatHistory);
 
     // 3. Inject current location context
     AVec3 centre = GetEntityPosition(playerPed);
@@ -339,35 +339,71 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
     if (!finalInjectedText.empty()) {
         basePromptStream << "\n[ADDITIONAL CONTEXT]:\n" << finalInjectedText;
     }
+    if (chatHistory) basePromptStream << "\n- Time: " << GetCurrentTimeState() << "\n";
     basePromptStream << "<|end|>\n";
-    std::string static_prompt = basePromptStream.str();
+    return basePromptStream.str();
+}
+
+// stableOnly: stop after the history (no keyword context, no time, no <|assistant|>), i.e. the
+// part of the next prompt that is already known while the player is still typing.
+// Both modes pick the history with the same budget, so the prefix is a true prefix of the prompt.
+// With prefix_cache=0 there is no prefix to keep: everything stays in the system block as before.
+static std::string BuildPrompt(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory, bool stableOnly) {
+    TRACE_SCOPE(stableOnly ? "AssemblePromptPrefix" : "AssemblePrompt");
+    // Safety check
+    if (!g_model || !g_ctx) {
+        LogLLM("AssemblePrompt FATAL: g_model or g_ctx is null.");
+        return "";
+    }
+    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+    if (!vocab) return "";
+
+    // A game minute is ~2 real seconds, so the time lives in a system turn after the history
+    // together with the keyword context
+    const bool splitTail = ConfigReader::g_Settings.Prefix_Cache != 0;
+    std::string static_prompt = AssembleSystemPrompt(targetPed, playerPed, g_current_npc_name, splitTail ? nullptr : &chatHistory);
+    std::string tailContext;
+    if (splitTail && !stableOnly) {
+        tailContext = "\n<|system|>\n[CURRENT SITUATION]:\n" + BuildKeywordContext(chatHistory) +
+            "- Time: " + GetCurrentTimeState() + "\n<|end|>";
+    }
 
     // =================================================================
     // STEP 2: Calculate Budgets (VRAM Management)
     // =================================================================
     const int32_t n_ctx = llama_n_ctx(g_ctx);
     const int32_t response_buffer = 256;
+    const int32_t tail_reserve = splitTail ? 192 : 0; // keyword context + time, not known yet in stableOnly mode
 
     std::vector<llama_token> static_tokens(n_ctx);
     int32_t static_token_count = llama_tokenize(vocab, static_prompt.c_str(), static_prompt.length(), static_tokens.data(), static_tokens.size(), false, false);
 
-    int32_t history_token_budget = n_ctx - static_token_count - response_buffer;
+    int32_t history_token_budget = n_ctx - static_token_count - response_buffer - tail_reserve;
     history_token_budget = std::min(history_token_budget, static_cast<int32_t>(ConfigReader::g_Settings.MaxHistoryTokens));
 
     // =================================================================
     // STEP 3: Fill the History Budget (from Newest to Oldest)
     // =================================================================
     std::vector<std::string> selected_history;
+    std::vector<int32_t> selected_tokens;
     int32_t history_tokens_used = 0;
 
-    if (history_token_budget > 0 && !chatHistory.empty()) {
+    // The player's new line is always kept. The older lines are picked with room left for it,
+    // so the prefix (partial or no new line) and the prompt (full line) start at the same line.
+    size_t n_older = chatHistory.size();
+    if (n_older > 0 && chatHistory.back().rfind("<|user|>", 0) == 0) n_older--;
+    const int32_t input_reserve = ConfigReader::g_Settings.MaxInputChars / 3 + 8;
+    const int32_t older_budget = history_token_budget - input_reserve;
+
+    if (older_budget > 0 && n_older > 0) {
         std::vector<llama_token> msg_tokens(n_ctx);
-        for (auto it = chatHistory.rbegin(); it != chatHistory.rend(); ++it) {
-            const std::string& message = *it;
+        for (size_t i = n_older; i-- > 0;) {
+            const std::string& message = chatHistory[i];
             int32_t msg_token_count = llama_tokenize(vocab, message.c_str(), message.length(), msg_tokens.data(), msg_tokens.size(), false, false);
 
-            if (history_tokens_used + msg_token_count <= history_token_budget) {
+            if (history_tokens_used + msg_token_count <= older_budget) {
                 selected_history.insert(selected_history.begin(), message);
+                selected_tokens.insert(selected_tokens.begin(), msg_token_count);
                 history_tokens_used += msg_token_count;
             }
             else {
@@ -375,6 +411,22 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
             }
         }
     }
+    if (n_older < chatHistory.size()) {
+        selected_history.push_back(chatHistory.back());
+        selected_tokens.push_back(0);
+    }
+
+    // A tail larger than its reserve only costs the oldest lines of this one prompt
+    if (!tailContext.empty()) {
+        int32_t tail_tokens = llama_tokenize(vocab, tailContext.c_str(), tailContext.length(), static_tokens.data(), static_tokens.size(), false, false);
+        int32_t overflow = tail_tokens - tail_reserve;
+        const size_t keep = n_older < chatHistory.size() ? 1 : 0; // the player's new line
+        while (overflow > 0 && selected_history.size() > keep) {
+            overflow -= selected_tokens.front();
+            selected_tokens.erase(selected_tokens.begin());
+            selected_history.erase(selected_history.begin());
+        }
+    }
 
     // =================================================================
     // STEP 4: Assemble Final Prompt
@@ -388,11 +440,21 @@ std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vect
             finalPromptStream << line << "\n";
         }
     }
+    if (stableOnly) return finalPromptStream.str();
 
+    finalPromptStream << tailContext;
     finalPromptStream << "\n<|assistant|>\n";
     return finalPromptStream.str();
 }
 
+std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory) {
+    return BuildPrompt(targetPed, playerPed, chatHistory, false);
+}
+
+std::string AssemblePromptPrefix(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory) {
+    return BuildPrompt(targetPed, playerPed, chatHistory, true);
+}
+
 bool InitializeLLM(const char* model_path) {
     LogLLM("InitializeLLM called with model_path: " + std::string(model_path));
     if (g_model != nullptr) {
@@ -453,25 +515,23 @@ bool InitializeLLM(const char* model_path) {
     return true;
 }
 
-void ShutdownLLM() {
+void ShutdownLLM(bool inDllMain) {
     LogLLM("ShutdownLLM called");
-    if (g_llm_state == InferenceState::RUNNING) {
-        if (g_llm_future.valid()) {
-            try {
-                g_llm_future.wait();
-                g_llm_future.get();
-            }
-            catch (...) {
-                LogLLM("ShutdownLLM: Ignored exception during future cleanup");
-            }
-        }
+    // Resolves the running reply (REPLY_READY "LLM_NOT_INITIALIZED")
+    if (!BatchScheduler::Stop(inDllMain)) {
+        LogLLM("ShutdownLLM: Decode thread still running, model and context stay allocated");
+        return;
     }
+    SpeculativeDecoder::ShutdownDraftModel();
     if (g_ctx != nullptr) {
         LogLLM("ShutdownLLM: Freeing context");
         llama_free(g_ctx);
         g_ctx = nullptr;
         g_memoryFrees++;
     }
+    // ggml_threadpool_free joins the pool's workers, not allowed under the loader lock
+    if (!inDllMain) CpuGovernor::ReleaseThreadpool();
+    else LogLLM("ShutdownLLM: Detach, the LLM threadpool is left to the process exit");
     if (g_model != nullptr) {
         LogLLM("ShutdownLLM: Freeing model");
         llama_model_free(g_model);
@@ -489,6 +549,7 @@ void ShutdownLLM() {
 // In LLM_Inference.cpp
 
 std::string CleanupResponse(std::string text) {
+    TRACE_SCOPE("CleanupResponse");
     // Logging Helper (optional, aber ntzlich)
     LogLLM("CleanupResponse: Original text (first 400): " + text.substr(0, (std::min)((size_t)400, text.length())));
 
@@ -619,63 +680,8 @@ llama_token ManualSample(float* logits, int32_t n_vocab, const std::vector<llama
     return candidates[0].id;
 }
 
-std::string GenerateLLMResponse(const std::string& fullPrompt) {
-    LogLLM(">>> GenerateLLMResponse (MANUAL CPU SAMPLER)");
-
-    // 1. Init
-    auto start = std::chrono::high_resolution_clock::now();
-    std::string response_text = "";
-    int32_t n_decode = 0;
-    int32_t MAX_OUTPUT = ConfigReader::g_Settings.MaxOutputChars;
-
-    if (!g_model || !g_ctx) return "LLM_NOT_INITIALIZED";
-    const llama_vocab* vocab = llama_model_get_vocab(g_model);
-    int32_t n_vocab = llama_n_vocab(vocab);
-
-    // 2. Tokenize
-    std::vector<llama_token> tokens_list(4096);
-    int32_t n_tokens = llama_tokenize(vocab, fullPrompt.c_str(), (int32_t)fullPrompt.length(), tokens_list.data(), (int32_t)tokens_list.size(), true, false);
-    if (n_tokens <= 0) return "TOKENIZATION_FAILED";
-    tokens_list.resize(n_tokens);
-
-    // 3. Truncate
-    int32_t n_ctx = llama_n_ctx(g_ctx);
-    if (n_tokens > n_ctx - 100) {
-        tokens_list.resize(n_ctx - 100);
-        n_tokens = (int32_t)tokens_list.size();
-    }
-
-    // 4. SPLIT DECODE (Keep this!)
-    llama_batch batch = llama_batch_init(n_tokens, 0, 1);
-    int32_t n_past = 0;
-
-    // A. Context
-    if (n_tokens > 1) {
-        batch.n_tokens = n_tokens - 1;
-        for (int i = 0; i < batch.n_tokens; i++) {
-            batch.token[i] = tokens_list[i];
-            batch.pos[i] = i;
-            batch.n_seq_id[i] = 1;
-            batch.seq_id[i][0] = 0;
-            batch.logits[i] = false;
-        }
-        if (llama_decode(g_ctx, batch) != 0) { llama_batch_free(batch); return "CTX_FAIL"; }
-        n_past = batch.n_tokens;
-    }
-
-    // B. Last Token
-    batch.n_tokens = 1;
-    batch.token[0] = tokens_list[n_tokens - 1];
-    batch.pos[0] = n_past;
-    batch.n_seq_id[0] = 1;
-    batch.seq_id[0][0] = 0;
-    batch.logits[0] = true;
-
-    if (llama_decode(g_ctx, batch) != 0) { llama_batch_free(batch); return "LAST_FAIL"; }
-
-    int32_t n_cur = n_tokens;
-
-    // 5. Stop Tokens
+// Stop tokens for one request. speakerName is the NPC the reply belongs to.
+std::vector<llama_token> BuildStopTokens(const llama_vocab* vocab, const std::string& speakerName) {
     std::vector<llama_token> stop_tokens;
 
     // A. Liste aus der INI laden (Dein neues Feature!)
@@ -693,8 +699,8 @@ std::string GenerateLLMResponse(const std::string& fullPrompt) {
     stop_strings.push_back("[END_CONVERSATION]");
 
     // C. Auch den aktuellen NPC-Namen als Stop nutzen (verhindert Selbstgesprche)
-    if (!g_current_npc_name.empty()) {
-        stop_strings.push_back(g_current_npc_name + ":");
+    if (!speakerName.empty()) {
+        stop_strings.push_back(speakerName + ":");
     }
 
     // D. Alle Strings in Tokens umwandeln
@@ -708,95 +714,132 @@ std::string GenerateLLMResponse(const std::string& fullPrompt) {
             stop_tokens.insert(stop_tokens.end(), buf.begin(), buf.begin() + n);
         }
     }
+    return stop_tokens;
+}
 
-    // 6. SETTINGS (Here you connect your ConfigReader!)
-    float temp = ConfigReader::g_Settings.temp;
-    float top_p = ConfigReader::g_Settings.float_p;
-    int   top_k = ConfigReader::g_Settings.top_k;
-    float min_p = ConfigReader::g_Settings.min_p;
-    float penalty = ConfigReader::g_Settings.repeat_penalty; 
-
-    // 7. GENERATION LOOP (SAFE)
-    try {
-        while (n_decode < MAX_OUTPUT) {
-            if (g_convo_state == ConvoState::IDLE) break;
-
-            // A. GET LOGITS (Safe Access)
-            float* logits = llama_get_logits_ith(g_ctx, 0);
-            if (!logits) logits = llama_get_logits_ith(g_ctx, -1);
-
-            if (!logits) {
-                LogLLM("FATAL: Logits missing.");
-                break;
-            }
-
-            // B. MANUAL SAMPLE (No Crash Risk!)
-            llama_token id = ManualSample(logits, n_vocab, tokens_list, temp, top_p, top_k, min_p, penalty);
-
-            tokens_list.push_back(id); // Update History
-
-            // C. STOP
-            if (llama_vocab_is_eog(vocab, id)) break;
-            bool stop = false;
-            for (auto t : stop_tokens) if (t == id) stop = true;
-            if (stop) break;
-
-            // D. DECODE
-            char buf[256] = { 0 };
-            int n = llama_token_to_piece(vocab, id, buf, 256, 0, true);
-            if (n > 0) {
-                std::string piece(buf, n);
-                if (piece.find("<|") != std::string::npos) break;
-                response_text += piece;
-            }
-
-            // E. NEXT BATCH
-            batch.n_tokens = 1;
-            batch.token[0] = id;
-            batch.pos[0] = n_cur;
-            batch.logits[0] = true;
+// Blocking convenience wrapper. The actual decode loop lives in BatchScheduler.
+std::string GenerateLLMResponse(const std::string& fullPrompt) {
+    LogLLM(">>> GenerateLLMResponse (BATCH SCHEDULER)");
+    if (!g_model || !g_ctx) return "LLM_NOT_INITIALIZED";
+    return BatchScheduler::Submit(fullPrompt).get();
+}
 
-            if (llama_decode(g_ctx, batch) != 0) break;
+// miniaudio callback
+void audio_capture_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
+{
+    if (g_is_recording.load(std::memory_order_acquire) && pInput != NULL) {
+        // Real-time thread: no allocation, no locks. The script thread collects it (PumpAudioCapture).
+        g_capture_ring.Write((const float*)pInput, frameCount);
+    }
+}
 
-            n_cur++;
-            n_decode++;
+// ------------------------------------------------------------
+// WHISPER STATES
+// g_whisper_ctx only holds the weights. Each whisper_state has its own KV cache
+// and compute buffers: one transcription at a time per state, several states
+// side by side. They live as long as the model, so no call allocates them again.
+// State 0 is reserved for interactive transcriptions, background work only
+// gets the others.
+// ------------------------------------------------------------
+struct WhisperSlot {
+    whisper_state* state = nullptr;
+    bool busy = false;
+};
+static std::mutex g_whisper_mutex;           // guards the slots
+static std::condition_variable g_whisper_cv; // a slot became free
+static std::vector<WhisperSlot> g_whisper_slots;
+static whisper_full_params g_whisper_params; // built once, per call only audio_ctx and n_threads change
+static const size_t WHISPER_WARMUP_SAMPLES = 2 * WHISPER_SAMPLE_RATE;
+
+// Waits for a free slot (only: that one). -1 once whisper is shut down.
+static int AcquireWhisperSlot(bool background, int only = -1) {
+    std::unique_lock<std::mutex> lock(g_whisper_mutex);
+    int found = -1;
+    g_whisper_cv.wait(lock, [&] {
+        if (g_whisper_slots.empty()) return true;
+        size_t first = (only >= 0) ? (size_t)only : (background && g_whisper_slots.size() > 1) ? 1 : 0;
+        size_t last = (only >= 0) ? first + 1 : g_whisper_slots.size();
+        for (size_t i = first; i < g_whisper_slots.size() && i < last; ++i) {
+            if (!g_whisper_slots[i].busy) { found = (int)i; return true; }
         }
-    }
-    catch (...) {
-        llama_batch_free(batch);
-        return "Error: Exception";
-    }
+        return false;
+    });
+    if (found >= 0) g_whisper_slots[found].busy = true;
+    return found;
+}
 
-    llama_batch_free(batch);
-    auto end = std::chrono::high_resolution_clock::now();
-    LogLLM("Gen time: " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) + "ms");
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> diff = end_time - start;
-    UpdateTPS(n_decode, diff.count());
-    return CleanupResponse(response_text);
+static void ReleaseWhisperSlot(int slot) {
+    {
+        std::lock_guard<std::mutex> lock(g_whisper_mutex);
+        g_whisper_slots[slot].busy = false;
+    }
+    g_whisper_cv.notify_all();
 }
 
-// miniaudio callback
-void audio_capture_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
-{
-    if (g_is_recording && pInput != NULL) {
-        const float* pInputF32 = (const float*)pInput;
-        // Add the new audio samples to our global buffer
-        g_audio_buffer.insert(g_audio_buffer.end(), pInputF32, pInputF32 + frameCount);
+// First whisper_full on a state sets up the backend and sizes its buffers. Done on
+// silence at load, so the player's first push-to-talk is as fast as any other.
+static void WarmUpWhisper() {
+    TRACE_SCOPE("Whisper Warm-up");
+    std::vector<float> silence(WHISPER_WARMUP_SAMPLES, 0.0f);
+    std::vector<SttSegment> segments;
+    size_t slots;
+    {
+        std::lock_guard<std::mutex> lock(g_whisper_mutex);
+        slots = g_whisper_slots.size();
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < slots; ++i) {
+        int slot = AcquireWhisperSlot(false, (int)i);
+        if (slot < 0) return;
+        whisper_full_params wparams = g_whisper_params;
+        wparams.audio_ctx = WhisperAudioCtxFor(silence.size(), ConfigReader::g_Settings.StT_Audio_Ctx_Margin_Ms);
+        wparams.n_threads = CpuGovernor::ThreadsFor(Workload::STT);
+        whisper_full_with_state(g_whisper_ctx, g_whisper_slots[slot].state, wparams, silence.data(), (int)silence.size());
+        ReleaseWhisperSlot(slot);
     }
+    std::chrono::duration<double, std::milli> ms = std::chrono::high_resolution_clock::now() - start;
+    LogA("WarmUpWhisper: " + std::to_string(slots) + " state(s) ready in " + std::to_string((int)ms.count()) + " ms.");
 }
 
 // 1. Initialize Whisper Model
 bool InitializeWhisper(const char* model_path) {
+    if (g_whisper_ctx) ShutdownWhisper(); // reload through the API
     LogA("InitializeWhisper: Attempting to load model at: " + std::string(model_path));
     struct whisper_context_params cparams = whisper_context_default_params();
-    g_whisper_ctx = whisper_init_from_file_with_params(model_path, cparams);
+    g_whisper_ctx = whisper_init_from_file_with_params_no_state(model_path, cparams);
 
     if (g_whisper_ctx == nullptr) {
         LogA("InitializeWhisper: FAILED to initialize whisper context.");
         return false;
     }
-    LogA("InitializeWhisper: Model loaded successfully.");
+
+    int wanted = std::max(1, std::min(4, ConfigReader::g_Settings.StT_Whisper_States));
+    {
+        std::lock_guard<std::mutex> lock(g_whisper_mutex);
+        for (int i = 0; i < wanted; ++i) {
+            whisper_state* state = whisper_init_state(g_whisper_ctx);
+            if (state == nullptr) break; // out of memory: run with what we have
+            WhisperSlot slot;
+            slot.state = state;
+            g_whisper_slots.push_back(slot);
+        }
+    }
+    if (g_whisper_slots.empty()) {
+        LogA("InitializeWhisper: FAILED to allocate a whisper state.");
+        whisper_free(g_whisper_ctx);
+        g_whisper_ctx = nullptr;
+        return false;
+    }
+
+    g_whisper_params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    g_whisper_params.print_progress = false;
+    g_whisper_params.print_realtime = false;
+    g_whisper_params.print_special = false;
+    g_whisper_params.print_timestamps = false;
+    g_whisper_params.language = "auto"; // Use "auto" or "de" if you use the multilingual model
+
+    LogA("InitializeWhisper: Model loaded successfully (" + std::to_string(g_whisper_slots.size()) + " state(s)).");
+    TaskPool::Submit("Whisper Warm-up", TaskPriority::HIGH, Workload::STT, []() { WarmUpWhisper(); });
     return true;
 }
 
@@ -810,6 +853,19 @@ bool InitializeAudioCaptureDevice() {
     deviceConfig.dataCallback = audio_capture_callback;
     deviceConfig.pUserData = NULL;
 
+    // Everything a recording can need is allocated here, once
+    int maxSec = std::max(1, ConfigReader::g_Settings.StT_Max_Record_Sec);
+    g_max_record_samples = (size_t)maxSec * WHISPER_SAMPLE_RATE;
+    if (!g_capture_ring.Init(g_max_record_samples)) {
+        LogA("InitializeAudioCaptureDevice: FAILED to allocate the capture ring.");
+        return false;
+    }
+    g_audio_buffer.reserve(g_max_record_samples);
+    {
+        std::lock_guard<std::mutex> lock(g_spare_mutex);
+        g_spare_buffer.reserve(g_max_record_samples);
+    }
+
     if (ma_device_init(NULL, &deviceConfig, &g_capture_device) != MA_SUCCESS) {
         LogA("InitializeAudioCaptureDevice: FAILED to initialize audio capture device.");
         return false;
@@ -818,11 +874,17 @@ bool InitializeAudioCaptureDevice() {
     return true;
 }
 
+// Trace id of the capture span (job ids of the scheduler stay far below)
+static const uint64_t STT_SPAN_ID = 0x5770;
+
 // 3. Start Recording
 void StartAudioRecording() {
     LogA("StartAudioRecording: Starting audio stream...");
-    g_audio_buffer.clear();
+    g_capture_ring.Reset(); // the device is stopped, nobody writes
+    g_audio_buffer.clear(); // keeps its capacity
+    if (g_audio_buffer.capacity() < g_max_record_samples) g_audio_buffer.reserve(g_max_record_samples); // spare was not returned
     g_is_recording = true;
+    Tracer::AsyncBegin("STT Capture", STT_SPAN_ID);
     if (ma_device_start(&g_capture_device) != MA_SUCCESS) {
         LogA("StartAudioRecording: FAILED to start audio device.");
         g_is_recording = false;
@@ -833,12 +895,84 @@ void StartAudioRecording() {
 void StopAudioRecording() {
     LogA("StopAudioRecording: Stopping audio stream.");
     g_is_recording = false;
-    ma_device_stop(&g_capture_device);
+    ma_device_stop(&g_capture_device); // returns once the callback has finished
+    PumpAudioCapture();
+    Tracer::AsyncEnd("STT Capture", STT_SPAN_ID);
     LogA("StopAudioRecording: Audio buffer size: " + std::to_string(g_audio_buffer.size()));
+    if (g_capture_ring.Dropped() > 0) {
+        LogA("StopAudioRecording: Dropped " + std::to_string(g_capture_ring.Dropped()) + " samples (longer than stt_max_record_sec).");
+    }
+}
+
+size_t PumpAudioCapture() {
+    size_t room = (g_audio_buffer.size() < g_max_record_samples) ? g_max_record_samples - g_audio_buffer.size() : 0;
+    return g_capture_ring.ReadInto(g_audio_buffer, room);
+}
+
+bool IsRecordingFull() {
+    return g_audio_buffer.size() >= g_max_record_samples;
+}
+
+std::vector<float> TakeRecording() {
+    std::vector<float> recording;
+    recording.swap(g_audio_buffer);
+    {
+        std::lock_guard<std::mutex> lock(g_spare_mutex);
+        g_audio_buffer.swap(g_spare_buffer);
+    }
+    g_audio_buffer.clear();
+    return recording;
+}
+
+void RecycleRecording(std::vector<float>&& buffer) {
+    std::lock_guard<std::mutex> lock(g_spare_mutex);
+    if (buffer.capacity() > g_spare_buffer.capacity()) g_spare_buffer.swap(buffer);
+}
+
+// The encoder always runs over its whole context (1500 frames = 30 s), padding included.
+// Our clips are a few seconds long, so most of that work is spent on silence.
+static const int WHISPER_FULL_AUDIO_CTX = 1500;
+static const int WHISPER_MIN_AUDIO_CTX = 128; // ~2.5 s floor for very short clips
+
+int WhisperAudioCtxFor(size_t n_samples, int marginMs) {
+    if (marginMs < 0) return 0;
+    int64_t ms = (int64_t)(n_samples * 1000 / WHISPER_SAMPLE_RATE) + marginMs;
+    int frames = (int)std::min<int64_t>((ms + 19) / 20, WHISPER_FULL_AUDIO_CTX); // 20 ms per frame
+    frames = std::max(frames, WHISPER_MIN_AUDIO_CTX);
+    frames = (frames + 31) & ~31; // few distinct encoder shapes
+    return (frames >= WHISPER_FULL_AUDIO_CTX) ? 0 : frames;
+}
+
+bool RunWhisper(const float* pcm, size_t n_samples, std::vector<SttSegment>& segments, int audioCtx, bool background) {
+    segments.clear();
+    if (g_whisper_ctx == nullptr || pcm == nullptr || n_samples == 0) return false;
+
+    whisper_full_params wparams = g_whisper_params;
+    wparams.audio_ctx = (audioCtx < 0) ? WhisperAudioCtxFor(n_samples, ConfigReader::g_Settings.StT_Audio_Ctx_Margin_Ms) : audioCtx;
+    // Thread count from the CpuGovernor (the pool worker already took on the STT policy); the LLM gives up as many threads while this runs
+    ScopedWorkload sttBusy(Workload::STT);
+    wparams.n_threads = CpuGovernor::ThreadsFor(Workload::STT);
+
+    int slot = AcquireWhisperSlot(background);
+    if (slot < 0) return false;
+    whisper_state* state = g_whisper_slots[slot].state;
+    bool ok = (whisper_full_with_state(g_whisper_ctx, state, wparams, pcm, (int)n_samples) == 0);
+
+    int n_segments = ok ? whisper_full_n_segments_from_state(state) : 0;
+    for (int i = 0; i < n_segments; ++i) {
+        SttSegment seg;
+        seg.text = whisper_full_get_segment_text_from_state(state, i);
+        seg.t0_ms = whisper_full_get_segment_t0_from_state(state, i) * 10; // whisper counts in 10 ms steps
+        seg.t1_ms = whisper_full_get_segment_t1_from_state(state, i) * 10;
+        segments.push_back(std::move(seg));
+    }
+    ReleaseWhisperSlot(slot);
+    return ok;
 }
 
 // 5. Transcribe (This runs in the async thread)
-std::string TranscribeAudio(std::vector<float> pcm_data) {
+std::string TranscribeAudio(const std::vector<float>& pcm_data) {
+    TRACE_SCOPE("Whisper");
     LogA("TranscribeAudio: Thread started. Processing " + std::to_string(pcm_data.size()) + " audio samples.");
     if (g_whisper_ctx == nullptr) {
         LogA("TranscribeAudio: FAILED - Whisper context is null.");
@@ -849,25 +983,25 @@ std::string TranscribeAudio(std::vector<float> pcm_data) {
         return "";
     }
 
-    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    wparams.print_progress = false;
-    wparams.print_realtime = false;
-    wparams.print_special = false;
-    wparams.print_timestamps = false;
-    wparams.language = "auto"; // Use "auto" or "de" if you use the multilingual model
-    wparams.n_threads = 4;   // Keep it low to not lag the game
+    // Leading/trailing silence is cut off, a clip without speech never reaches whisper
+    size_t begin = 0, end = pcm_data.size();
+    if (Vad::IsEnabled() && !Vad::FindSpeech(pcm_data.data(), pcm_data.size(), begin, end)) {
+        LogA("TranscribeAudio: No speech detected, whisper skipped.");
+        Metrics::Increment(MetricCounter::VAD_REJECTED);
+        return "";
+    }
 
-    if (whisper_full(g_whisper_ctx, wparams, pcm_data.data(), pcm_data.size()) != 0) {
+    auto stt_start = std::chrono::high_resolution_clock::now();
+    std::vector<SttSegment> segments;
+    if (!RunWhisper(pcm_data.data() + begin, end - begin, segments)) {
         LogA("TranscribeAudio: FAILED - whisper_full failed to process audio.");
         return "";
     }
+    std::chrono::duration<double, std::milli> stt_ms = std::chrono::high_resolution_clock::now() - stt_start;
+    Metrics::Record(MetricHist::STT_MS, stt_ms.count());
 
-    int n_segments = whisper_full_n_segments(g_whisper_ctx);
     std::string transcribed_text = "";
-    for (int i = 0; i < n_segments; ++i) {
-        const char* text = whisper_full_get_segment_text(g_whisper_ctx, i);
-        transcribed_text += text;
-    }
+    for (const auto& seg : segments) transcribed_text += seg.text;
 
     LogA("TranscribeAudio: Transcription complete: " + transcribed_text);
     return transcribed_text;
@@ -877,6 +1011,16 @@ std::string TranscribeAudio(std::vector<float> pcm_data) {
 // 6. Shutdown STT
 void ShutdownWhisper() {
     if (g_whisper_ctx) {
+        {
+            // Running transcriptions finish first, waiting ones get no slot
+            std::unique_lock<std::mutex> lock(g_whisper_mutex);
+            g_whisper_cv.wait(lock, [] {
+                return std::none_of(g_whisper_slots.begin(), g_whisper_slots.end(), [](const WhisperSlot& s) { return s.busy; });
+            });
+            for (WhisperSlot& s : g_whisper_slots) whisper_free_state(s.state);
+            g_whisper_slots.clear();
+        }
+        g_whisper_cv.notify_all();
         whisper_free(g_whisper_ctx);
         g_whisper_ctx = nullptr;
         LogA("ShutdownWhisper: Whisper context freed.");
@@ -4,15 +4,17 @@
 #include <vector>
 #include <future>
 #include <chrono>
+#include "llama.h"
 #include "AbstractTypes.h"
 #include "ConfigReader.h" // Needed for NpcPersona
 #include "FileEnums.h"
+#include "TaskPool.h"
 
 
 
 // Global Variables (Externs)
 extern InferenceState g_llm_state;
-extern std::future<std::string> g_llm_future;
+extern uint64_t g_llm_ticket; // REPLY_READY of the running interactive request (0 = none)
 extern std::string g_llm_response;
 extern std::chrono::high_resolution_clock::time_point g_response_start_time;
 extern std::chrono::high_resolution_clock::time_point g_llm_start_time;
@@ -23,12 +25,20 @@ extern float g_current_tps;
 
 // Functions
 bool InitializeLLM(const char* model_path);
-void ShutdownLLM();
+// inDllMain: no joins under the loader lock; what a still running thread uses is left allocated
+void ShutdownLLM(bool inDllMain = false);
 std::string GenerateLLMResponse(const std::string& fullPrompt);
+std::vector<llama_token> BuildStopTokens(const llama_vocab* vocab, const std::string& speakerName);
+llama_token ManualSample(float* logits, int32_t n_vocab, const std::vector<llama_token>& history,
+    float temp, float top_p, int top_k, float min_p, float rep_penalty);
+// chatHistory != nullptr: keyword context and time go into the block as well (prefix_cache=0 layout)
+std::string AssembleSystemPrompt(AHandle targetPed, AHandle playerPed, const std::string& fallbackName, const std::vector<std::string>* chatHistory = nullptr);
 std::string AssemblePrompt(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory);
+std::string AssemblePromptPrefix(AHandle targetPed, AHandle playerPed, const std::vector<std::string>& chatHistory);
 std::string CleanupResponse(std::string text);
 std::string PerformChatSummarization(const std::string& npcName, const std::vector<std::string>& history);
 std::string GenerateNpcName(const NpcPersona& persona);
+std::string GetCurrentTimeState();
 void LogLLM(const std::string& message);
 void LogMemoryStats();
 void UpdateTPS(int tokensGenerated, double elapsedSeconds);
@@ -38,13 +48,33 @@ bool InitializeWhisper(const char* model_path);
 bool InitializeAudioCaptureDevice();
 void StartAudioRecording();
 void StopAudioRecording();
-std::string TranscribeAudio(std::vector<float> pcm_data);
+// One decoded piece of speech, times relative to the start of the audio passed in
+struct SttSegment {
+    std::string text;
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+};
+// Encoder frames for a clip of n_samples plus marginMs (1500 frames = 30 s). 0 = the full window.
+int WhisperAudioCtxFor(size_t n_samples, int marginMs);
+// Runs whisper on the samples (16 kHz mono) on a free whisper_state, waits if all are busy. False if whisper failed.
+// audioCtx: encoder frames, -1 = sized to the clip (stt_audio_ctx_margin_ms), 0 = full 30 s window
+// background: never takes the state reserved for interactive transcriptions
+bool RunWhisper(const float* pcm, size_t n_samples, std::vector<SttSegment>& segments, int audioCtx = -1, bool background = false);
+// Moves what the capture callback wrote into g_audio_buffer. Script thread, also done by StopAudioRecording.
+size_t PumpAudioCapture();
+// g_audio_buffer reached stt_max_record_sec, further capture is dropped
+bool IsRecordingFull();
+// Hands the finished recording over without copying; capture continues in a spare buffer
+std::vector<float> TakeRecording();
+// Returns a transcribed recording's storage so the next one doesn't allocate (any thread)
+void RecycleRecording(std::vector<float>&& buffer);
+std::string TranscribeAudio(const std::vector<float>& pcm_data);
 void ShutdownWhisper();
 void ShutdownAudioDevice();
 
 // Audio Globals
-extern bool g_is_recording;
-extern std::future<std::string> g_stt_future;
+extern std::atomic<bool> g_is_recording;
+extern TaskHandle<std::string> g_stt_future;
 extern std::vector<float> g_audio_buffer;
 
 //EOF
\ No newline at end of file
@@ -67,9 +67,13 @@ AHandle g_target_ped = 0;
 // std::map<uint32_t, std::string> g_persistent_npc_names;
 std::string g_current_npc_name;
 
-std::vector<std::future<void>> g_backgroundTasks;
-
 ULONGLONG g_stt_start_time = 0;
+static uint64_t g_stt_ticket = 0; // TRANSCRIPT_PARTIAL / TRANSCRIPT_READY of the running recording
+static size_t g_stt_prefilled_chars = 0; // committed transcript already prefilled
+static const size_t STT_PREFILL_STEP_CHARS = 12; // committed text to gain before prefilling again
+static bool g_open_mic = false;       // the running recording was started by the open mic, not by PTT
+static bool g_open_mic_heard = false; // ... and the VAD has heard the player start talking
+static const size_t OPEN_MIC_PREROLL = WHISPER_SAMPLE_RATE / 2; // audio kept from before the speech started
 std::chrono::high_resolution_clock::time_point g_llm_start_time;
 //std::map<int, NpcSession> g_ActiveSessions;
 //std::map<std::string, NpcMemory> g_PersistentNpcMemory;
@@ -81,30 +85,15 @@ std::chrono::high_resolution_clock::time_point g_llm_start_time;
 // ------------------------------------------------------------
 // SYSTEM METRICS (RAM / VRAM)
 // ------------------------------------------------------------
+// Reads the ResourceMonitor cache, no DXGI work on the calling thread
 void LogSystemMetrics(const std::string& ctx) {
     LogM("--- BENCHMARK [" + ctx + "] ---");
-    PROCESS_MEMORY_COUNTERS pmc;
-    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-        float ramMB = static_cast<float>(pmc.WorkingSetSize) / 1024.f / 1024.f;
-        LogM("RAM: " + std::to_string(ramMB) + " MB");
+    ResourceSample s = ResourceMonitor::Latest();
+    if (s.ramValid) {
+        LogM("RAM: " + std::to_string(s.ramMB) + " MB");
     }
-    IDXGIFactory4* pFactory = nullptr;
-    if (SUCCEEDED(CreateDXGIFactory1(__uuidof(IDXGIFactory4), (void**)&pFactory))) {
-        IDXGIAdapter* pAdapter = nullptr;
-        if (SUCCEEDED(pFactory->EnumAdapters(0, &pAdapter))) {
-            IDXGIAdapter3* pAdapter3 = nullptr;
-            if (SUCCEEDED(pAdapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&pAdapter3))) {
-                DXGI_QUERY_VIDEO_MEMORY_INFO memInfo;
-                if (SUCCEEDED(pAdapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memInfo))) {
-                    float usedMB = static_cast<float>(memInfo.CurrentUsage) / 1024.f / 1024.f;
-                    float budgetMB = static_cast<float>(memInfo.Budget) / 1024.f / 1024.f;
-                    LogM("VRAM: " + std::to_string(usedMB) + " / " + std::to_string(budgetMB) + " MB");
-                }
-                pAdapter3->Release();
-            }
-            pAdapter->Release();
-        }
-        pFactory->Release();
+    if (s.vramValid) {
+        LogM("VRAM: " + std::to_string(s.vramUsedMB) + " / " + std::to_string(s.vramBudgetMB) + " MB");
     }
     LogM("--- END BENCHMARK ---");
 }
@@ -179,7 +168,7 @@ bool DoesFileExist(const std::string& p) {
 // CONVERSATION CLEAN-UP
 // ------------------------------------------------------------
 
-void EndConversation() {
+void EndConversation(bool stopVoice) {
     Log("EndConversation() called.");
 
     // 1. Hardware & Game Cleanup
@@ -197,6 +186,7 @@ void EndConversation() {
         ChatID savedID = g_current_chat_ID;
         std::vector<std::string> historySnapshot = ConvoManager::GetChatHistory(savedID);
         std::string savedName = g_current_npc_name;
+        Tracer::EndSession("kkamel_trace_" + std::to_string(savedID) + ".json");
 
         // B. Archive the chat immediately
         ConvoManager::CloseConversation(savedID);
@@ -204,17 +194,14 @@ void EndConversation() {
 
         // C. Launch Secretary in Background (Parallel)
         if (ConfigReader::g_Settings.TrySummarizeChat && historySnapshot.size() > 4) {
-            g_backgroundTasks.push_back(std::async(std::launch::async, [savedID, historySnapshot, savedName]() {
-
-                // This runs on another thread. It takes 2-5 seconds.
-                // It uses the FUNCTION we just defined above.
-                std::string summary = PerformChatSummarization(savedName, historySnapshot);
-
-                // When done, send result to Manager to update the archive
-                if (!summary.empty() && summary.find("LLM_ERROR") == std::string::npos) {
-                    ConvoManager::SetConversationSummary(savedID, summary);
-                }
-                }));
+            // This runs on a pool worker. It takes 2-5 seconds.
+            // It uses the FUNCTION we just defined above.
+            // When done, the result goes to the Manager via SUMMARY_READY (see OnSummaryReady)
+            TaskPool::Submit("Chat Summary", TaskPriority::LOW, Workload::BACKGROUND,
+                [historySnapshot, savedName]() { return PerformChatSummarization(savedName, historySnapshot); },
+                [savedID](const std::string& summary) {
+                    EventQueue::Post(EventType::SUMMARY_READY, 0, summary, savedID, 0);
+                });
         }
     }
 
@@ -227,9 +214,203 @@ void EndConversation() {
     g_llm_state = InferenceState::IDLE;
     g_renderText.clear();
 
-    // 4. Reset Futures
-    if (g_llm_future.valid()) g_llm_future = std::future<std::string>();
-    if (g_stt_future.valid()) g_stt_future = std::future<std::string>();
+    // 4. Reset Futures (background summaries keep running in the scheduler)
+    BatchScheduler::Cancel(GenPriority::INTERACTIVE);
+    g_llm_ticket = 0; // whatever still arrives for this conversation is dropped
+    g_stt_ticket = 0;
+    SttStream::Cancel();
+    SentenceStream::Cancel();
+    if (stopVoice && bridge) bridge->CancelPending(); // streamed sentences still queued, and the one playing
+    g_open_mic = false;
+    g_open_mic_heard = false;
+    g_stt_future.Cancel(); // drops it if no worker picked it up yet
+    g_stt_future.Reset();
+}
+
+// ------------------------------------------------------------
+// PREFILL NEXT TURN
+// System block and history are known as soon as the input UI opens. Loading
+// them while the player types/speaks leaves only the player's line and the
+// <|assistant|> tag for the real request (see BatchScheduler prefix cache).
+// ------------------------------------------------------------
+
+void PrefillNextTurn(AHandle playerPed) {
+    if (!ConfigReader::g_Settings.Prefix_Cache || g_current_chat_ID == 0) return;
+    std::vector<std::string> history = ConvoManager::GetChatHistory(g_current_chat_ID);
+    std::string prefix = AssemblePromptPrefix(g_target_ped, playerPed, history);
+    if (!prefix.empty()) BatchScheduler::Prefill(prefix, GenPriority::INTERACTIVE);
+}
+
+// ------------------------------------------------------------
+// COMPLETION EVENTS
+// Workers post their results to the EventQueue and the script tick dispatches
+// them here, so nothing polls a future per frame. A ticket is handed out per
+// request; results of an abandoned turn (timeout, conversation ended) no
+// longer match it and are dropped.
+// ------------------------------------------------------------
+
+void SubmitReply(const std::string& prompt) {
+    GenRequest req;
+    req.prompt = prompt;
+    req.speakerName = g_current_npc_name;
+    req.ticket = g_llm_ticket = EventQueue::NewTicket();
+    req.streamTokens = SentenceStream::IsEnabled();
+    if (req.streamTokens) SentenceStream::Begin(req.ticket, GetOrAssignNpcVoiceId(g_target_ped));
+
+    g_response_start_time = std::chrono::high_resolution_clock::now();
+    g_llm_start_time = g_response_start_time;
+    BatchScheduler::Submit(std::move(req)); // the reply comes back as REPLY_READY
+    g_llm_state = InferenceState::RUNNING;
+}
+
+static void OnReplyReady(const CompletionEvent& ev) {
+    if (ev.ticket == 0 || ev.ticket != g_llm_ticket || g_llm_state != InferenceState::RUNNING) return;
+
+    auto elapsed_delay = std::chrono::high_resolution_clock::now() - g_response_start_time;
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_delay).count();
+    if (ms < ConfigReader::g_Settings.MinResponseDelayMs) {
+        AbstractGame::SystemWait(static_cast<uint32_t>(ConfigReader::g_Settings.MinResponseDelayMs - ms));
+    }
+    g_llm_response = ev.text;
+    g_llm_ticket = 0;
+    g_llm_state = InferenceState::COMPLETE;
+}
+
+static void OnTokenChunk(const CompletionEvent& ev) {
+    if (ev.ticket == 0 || ev.ticket != g_llm_ticket) return;
+    SentenceStream::OnTokenChunk(ev, bridge);
+}
+
+static void OnTranscriptReady(const CompletionEvent& ev) {
+    if (ev.ticket == 0 || ev.ticket != g_stt_ticket || g_input_state != InputState::TRANSCRIBING) return;
+    g_stt_ticket = 0;
+    g_stt_future.Reset();
+
+    const std::string& txt = ev.text;
+    // With the VAD on, silence never reaches whisper. Without it, whisper turns noise into
+    // one- or two-character "words", the old length guard filters those out.
+    size_t minChars = Vad::IsEnabled() ? 1 : 3;
+    if (txt.length() >= minChars) {
+        if (g_current_chat_ID != 0) {
+            // 1. Send text to the Manager (instead of g_chat_history)
+            ConvoManager::AddMessageToChat(g_current_chat_ID, "Player", txt);
+
+            // 2. Get the clean history from the Manager
+            std::vector<std::string> history = ConvoManager::GetChatHistory(g_current_chat_ID);
+
+            // 3. Build Prompt using the Manager's history
+            std::string prompt = AssemblePrompt(g_target_ped, GetPlayerHandle(), history);
+
+            // 4. Launch LLM
+            LogSystemMetrics("Pre-Inference (STT)");
+            SubmitReply(prompt);
+        }
+    }
+    else {
+        Log("STT empty -> discard");
+    }
+    g_input_state = InputState::IDLE;
+}
+
+// ------------------------------------------------------------
+// RECORDING
+// ------------------------------------------------------------
+static void StartRecording(bool openMic) {
+    StartAudioRecording();
+    g_stt_ticket = EventQueue::NewTicket();
+    g_stt_prefilled_chars = 0;
+    g_open_mic = openMic;
+    g_open_mic_heard = false;
+    // The open mic only starts streaming once the VAD hears speech
+    if (openMic) Vad::ResetStream();
+    else SttStream::Begin(g_stt_ticket);
+    g_input_state = InputState::RECORDING;
+}
+
+bool IsOpenMicListening() {
+    return g_input_state == InputState::RECORDING && g_open_mic && !g_open_mic_heard;
+}
+
+// PTT released or the open mic heard the end of the sentence
+static void SubmitRecording() {
+    StopAudioRecording();
+    g_stt_start_time = GetTimeMs();
+    g_input_state = InputState::TRANSCRIBING;
+    g_open_mic = false;
+    g_open_mic_heard = false;
+    uint64_t ticket = g_stt_ticket;
+    g_stt_future = TaskPool::Submit("Whisper", TaskPriority::HIGH, Workload::STT,
+        [pcm = TakeRecording()]() mutable {
+            std::string txt = SttStream::IsEnabled() ? SttStream::Finish(pcm) : TranscribeAudio(pcm);
+            RecycleRecording(std::move(pcm));
+            return txt;
+        },
+        [ticket](const std::string& txt) { EventQueue::Post(EventType::TRANSCRIPT_READY, ticket, txt); });
+    AbstractGame::ShowSubtitle("", 5000);
+}
+
+// Player's turn: nothing is pending and the NPC is not speaking anymore
+static bool IsOpenMicTurn() {
+    if (!ConfigReader::g_Settings.StT_Enabled || !ConfigReader::g_Settings.StT_Open_Mic || !Vad::IsEnabled()) return false;
+    if (g_convo_state != ConvoState::IN_CONVERSATION || g_input_state != InputState::IDLE || g_llm_state != InferenceState::IDLE) return false;
+    if (bridge && bridge->IsConnected()) {
+        AudioJobState state = bridge->GetState();
+        if (state == AudioJobState::PENDING || state == AudioJobState::PROCESSING || state == AudioJobState::PLAYING) return false;
+    }
+    return true;
+}
+
+// Words the streaming transcriber committed while PTT is still held. The prompt up to
+// them is prefilled, so at release only the rest of the sentence needs decoding.
+static void OnTranscriptPartial(const CompletionEvent& ev) {
+    if (ev.ticket == 0 || ev.ticket != g_stt_ticket || g_current_chat_ID == 0) return;
+    if (g_input_state == InputState::RECORDING) AbstractGame::ShowSubtitle(ev.text, 3000);
+
+    size_t committed = std::min((size_t)std::max<int64_t>(0, ev.arg), ev.text.length());
+    if (!ConfigReader::g_Settings.Prefix_Cache || committed < g_stt_prefilled_chars + STT_PREFILL_STEP_CHARS) return;
+    g_stt_prefilled_chars = committed;
+
+    // Same entry format as ConvoManager::AddMessageToChat
+    std::vector<std::string> history = ConvoManager::GetChatHistory(g_current_chat_ID);
+    history.push_back("<|user|>\n" + ev.text.substr(0, committed));
+    std::string prefix = AssemblePromptPrefix(g_target_ped, GetPlayerHandle(), history);
+    if (!prefix.empty() && prefix.back() == '\n') prefix.pop_back(); // the final line goes on after the committed words
+    if (!prefix.empty()) BatchScheduler::Prefill(prefix, GenPriority::INTERACTIVE);
+}
+
+static void OnSummaryReady(const CompletionEvent& ev) {
+    if (ev.arg == 0) {
+        // Archive summary of a closed chat
+        if (!ev.text.empty() && ev.text.find("LLM_ERROR") == std::string::npos) {
+            ConvoManager::SetConversationSummary(ev.chatID, ev.text);
+        }
+        return;
+    }
+
+    // Intermediate summary from the ChatOptimizer, only for the chat it was made from
+    bool live = (ev.chatID != 0 && ev.chatID == g_current_chat_ID);
+    std::vector<std::string> history;
+    if (live) history = ConvoManager::GetChatHistory(ev.chatID);
+    if (ChatOptimizer::ApplySummary(ev.text, (int)ev.arg, history) && live) {
+        ConvoManager::ReplaceHistory(ev.chatID, history);
+    }
+}
+
+// One per finished VoiceBridge job (see section 11)
+static void OnTtsDone(const CompletionEvent& ev) {
+    bool ok = ev.arg == (int64_t)AudioJobState::COMPLETED;
+    Metrics::Increment(ok ? MetricCounter::TTS_SPOKEN : MetricCounter::TTS_FAILED);
+    Tracer::Instant(ok ? "TTS done" : "TTS failed");
+}
+
+static void RegisterEventHandlers() {
+    EventQueue::Subscribe(EventType::REPLY_READY, OnReplyReady);
+    EventQueue::Subscribe(EventType::REPLY_READY, AmbientDialogue::OnReplyReady);
+    EventQueue::Subscribe(EventType::TOKEN_CHUNK, OnTokenChunk);
+    EventQueue::Subscribe(EventType::TRANSCRIPT_READY, OnTranscriptReady);
+    EventQueue::Subscribe(EventType::TRANSCRIPT_PARTIAL, OnTranscriptPartial);
+    EventQueue::Subscribe(EventType::SUMMARY_READY, OnSummaryReady);
+    EventQueue::Subscribe(EventType::TTS_DONE, OnTtsDone);
 }
 
 
@@ -311,6 +492,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
         // ONE-TIME INITIALISATION
         // ----------------------------------------------------
         if (!g_isInitialized) {
+            AsyncLogger::Start(); // DllMain only queued its lines, the writer thread starts here
             Log("ScriptMain: Initialising");
             auto t0 = std::chrono::high_resolution_clock::now();
             g_gameHWND = FindGameWindowHandle();
@@ -326,6 +508,10 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 AbstractGame::ShowSubtitle("Config Error", 10000);
                 TERMINATE(); return;
             }
+            ResourceMonitor::Start();
+            CpuGovernor::Initialize();
+            TaskPool::Start();
+            RegisterEventHandlers();
             LogSystemMetrics("Baseline");
 
             // **NEU: Bridge initialisieren**
@@ -356,56 +542,8 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 TERMINATE(); return;
             }
 
-            enum ggml_type kv_type = GGML_TYPE_F32;
-            llama_context_params ctx_params = llama_context_default_params();
-            //ctx_params.n_ctx = static_cast<uint32_t>(ConfigReader::g_Settings.MaxHistoryTokens);
-            ctx_params.n_ctx = static_cast<uint32_t>(ConfigReader::g_Settings.Max_Working_Input);
-            ctx_params.n_batch = 1024;
-            ctx_params.n_ubatch = 256;
-            if (!ConfigReader::g_Settings.USE_VRAM_PREFERED) {
-                kv_type = GGML_TYPE_F16;
-            }
-            switch (ConfigReader::g_Settings.KV_Cache_Quantization_Type)
-            {
-            case 2: // ~2.56 bits-per-weight
-                kv_type = GGML_TYPE_Q2_K;
-                Log("KV Cache Quantization: Using Q2_K (~2.56 bits)");
-                break;
-
-            case 3: // ~3.43 bits-per-weight
-                kv_type = GGML_TYPE_Q3_K;
-                Log("KV Cache Quantization: Using Q3_K (~3.43 bits)");
-                break;
-
-            case 4: // ~4.5 bits-per-weight
-                kv_type = GGML_TYPE_Q4_K;
-                Log("KV Cache Quantization: Using Q4_K (~4.5 bits)");
-                break;
-
-            case 5: // ~5.5 bits-per-weight
-                kv_type = GGML_TYPE_Q5_K;
-                Log("KV Cache Quantization: Using Q5_K (~5.5 bits)");
-                break;
-
-            case 6: // ~6.56 bits-per-weight
-                kv_type = GGML_TYPE_Q6_K;
-                Log("KV Cache Quantization: Using Q6_K (~6.56 bits)");
-                break;
-
-            case 8: // 8.0 bits-per-weight
-                kv_type = GGML_TYPE_Q8_0;
-                Log("KV Cache Quantization: Using Q8_0 (8 bits)");
-                break;
-
-            default:
-                // No explicit quantization or unknown value, keeps the default (F32/F16).
-                Log("KV Cache Quantization: Using default float type (F32/F16).");
-                break;
-            }
-            ctx_params.type_k = kv_type;
-            ctx_params.type_v = kv_type;
-
-            g_ctx = llama_init_from_model(g_model, ctx_params);
+            // n_ctx / KV type / KV offload come from the MemoryGovernor (INI values, scaled to the free VRAM)
+            g_ctx = MemoryGovernor::CreateContext();
             if (g_ctx == nullptr) {
                 Log("FATAL: llama_init_from_model failed. Cannot proceed with LLM context.");
                 // Handle error (e.g., return false or terminate)
@@ -445,6 +583,21 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 }
             }
 
+            // ------------------------------------------------------------
+            // 2b. DRAFT MODEL (optional, speculative decoding)
+            // ------------------------------------------------------------
+            if (SpeculativeDecoder::InitializeFromConfig(root)) {
+                Log("Speculative decoding: draft model ready");
+            }
+
+            // ------------------------------------------------------------
+            // 2c. BATCH SCHEDULER (owns g_ctx from here on)
+            // ------------------------------------------------------------
+            if (!BatchScheduler::Start()) {
+                Log("FATAL: BatchScheduler could not start.");
+                TERMINATE(); return;
+            }
+
             // ------------------------------------------------------------
             // 3. WHISPER (STT) INITIALIZATION
             // ------------------------------------------------------------
@@ -515,6 +668,10 @@ extern "C" __declspec(dllexport) void ScriptMain() {
             }
 
             HandleFullscreenYield();
+
+            // ----- 0. COMPLETION EVENTS (replies, transcripts, summaries) -----
+            EventQueue::Dispatch();
+
             // ----- 1. SUBTITLE RENDERING -----
             if (!g_renderText.empty() && GetTimeMs() < g_renderEndTime) {
                 std::stringstream ss(g_renderText);
@@ -549,20 +706,15 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 // A. CHAT OPTIMIZER LOGIC (Updated for Manager)
                 // ==========================================
                 if (g_current_chat_ID != 0) {
-                    // 1. Get a copy of the history from the Manager
-                    std::vector<std::string> currentHistory = ConvoManager::GetChatHistory(g_current_chat_ID);
-
-                    // 2. Apply any pending optimizations (Async result check)
-                    if (ChatOptimizer::ApplyPendingOptimizations(currentHistory)) {
-                        // If changed, push the optimized history back to the Manager
-                        ConvoManager::ReplaceHistory(g_current_chat_ID, currentHistory);
-                    }
-
-                    // 3. Trigger new optimization check (Interval)
+                    // Finished summaries arrive as SUMMARY_READY (see OnSummaryReady)
+                    // Trigger new optimization check (Interval)
                     static uint32_t last_opt_check = 0;
                     if (AbstractGame::GetTimeMs() > last_opt_check + 5000) {
                         last_opt_check = AbstractGame::GetTimeMs();
 
+                        // Get a copy of the history from the Manager
+                        std::vector<std::string> currentHistory = ConvoManager::GetChatHistory(g_current_chat_ID);
+
                         // The Optimizer class now handles VRAM checks internally
                         ChatOptimizer::CheckAndOptimize(
                             g_current_chat_ID,
@@ -615,24 +767,14 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::high_resolution_clock::now() - g_llm_start_time).count();
                 if (elapsed > 30) {
                     Log("LLM Timeout ? discard");
-                    if (g_llm_future.valid()) g_llm_future = std::future<std::string>();
+                    Metrics::Increment(MetricCounter::LLM_TIMEOUT);
+                    BatchScheduler::Cancel(GenPriority::INTERACTIVE);
+                    g_llm_ticket = 0;
+                    if (bridge) bridge->CancelPending(); // the half-streamed reply stops, the error line follows
                     g_llm_response = "LLM_TIMEOUT";
                     g_llm_state = InferenceState::COMPLETE;
                 }
-                else if (g_llm_future.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
-                    auto elapsed_delay = std::chrono::high_resolution_clock::now() - g_response_start_time;
-                    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_delay).count();
-                    if (ms < ConfigReader::g_Settings.MinResponseDelayMs) {
-                        AbstractGame::SystemWait(static_cast<uint32_t>(ConfigReader::g_Settings.MinResponseDelayMs - ms));
-                    }
-                    try { g_llm_response = g_llm_future.get(); }
-                    catch (const std::exception& e) {
-                        Log("LLM future exception: " + std::string(e.what()));
-                        g_llm_response = "LLM_ERROR";
-                    }
-                    g_llm_future = std::future<std::string>();
-                    g_llm_state = InferenceState::COMPLETE;
-                }
+                // The reply itself arrives as REPLY_READY (see OnReplyReady)
             }
 
             // ----- 4. KEYBOARD INPUT -----
@@ -640,6 +782,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 int kb = UpdateKeyboardStatus();
 
                 if (kb == 1) { // User pressed ENTER
+                    Tracer::Instant("Input Submitted");
                     std::string txt = GetKeyboardResult();
                     if (!txt.empty()) {
 
@@ -666,12 +809,9 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                             std::string prompt = AssemblePrompt(g_target_ped, playerPed, history);
 
                             LogSystemMetrics("Pre-Inference (KB)");
-                            g_response_start_time = std::chrono::high_resolution_clock::now();
-                            g_llm_start_time = std::chrono::high_resolution_clock::now();
 
-                            // Launch Async Generation
-                            g_llm_future = std::async(std::launch::async, GenerateLLMResponse, prompt);
-                            g_llm_state = InferenceState::RUNNING;
+                            // Queue Generation (decoded alongside any running background request)
+                            SubmitReply(prompt);
                             g_input_state = InputState::IDLE;
                         }
                         else {
@@ -693,57 +833,48 @@ extern "C" __declspec(dllexport) void ScriptMain() {
 
             // ----- 5. STT RECORDING -----
             if (g_input_state == InputState::RECORDING) {
-                if (ConfigReader::g_Settings.StTRB_Activation_Key != 0 &&
+                size_t before = g_audio_buffer.size();
+                PumpAudioCapture(); // keeps the capture ring drained
+                if (g_open_mic) {
+                    VadEvent vad = Vad::Feed(g_audio_buffer.data() + before, g_audio_buffer.size() - before);
+                    if (!g_open_mic_heard && vad == VadEvent::SPEECH_START) {
+                        LogA("Open mic: speech started");
+                        Tracer::Instant("Speech Start");
+                        g_open_mic_heard = true;
+                        SttStream::Begin(g_stt_ticket);
+                    }
+                    else if (!g_open_mic_heard && g_audio_buffer.size() > OPEN_MIC_PREROLL * 4) {
+                        // Nobody talks yet: keep only the pre-roll (stays in the reserved storage)
+                        g_audio_buffer.erase(g_audio_buffer.begin(), g_audio_buffer.end() - OPEN_MIC_PREROLL);
+                    }
+                }
+                if (!g_open_mic || g_open_mic_heard) SttStream::Update(g_audio_buffer);
+
+                if (g_open_mic) {
+                    if (g_open_mic_heard && (!Vad::InSpeech() || IsRecordingFull())) {
+                        LogA("Open mic: end of speech -> stop");
+                        SubmitRecording();
+                    }
+                }
+                else if (ConfigReader::g_Settings.StTRB_Activation_Key != 0 &&
                     GetAsyncKeyState(ConfigReader::g_Settings.StTRB_Activation_Key) == 0) {
                     LogA("PTT released ? stop");
-                    StopAudioRecording();
-                    g_stt_start_time = GetTimeMs();
-                    g_input_state = InputState::TRANSCRIBING;
-                    g_stt_future = std::async(std::launch::async, TranscribeAudio, g_audio_buffer);
+                    SubmitRecording();
                     // UI::SET_TEXT... replaced((char*)"STRING");
                     // UI::ADD_TEXT... replaced((char*)"Transcribing");
-                    AbstractGame::ShowSubtitle("", 5000);
                 }
             }
 
-            // ----- 6. STT TRANSCRIPTION DONE -----
+            // ----- 6. STT TRANSCRIPTION TIMEOUT -----
+            // The transcript itself arrives as TRANSCRIPT_READY (see OnTranscriptReady)
             if (g_input_state == InputState::TRANSCRIBING) {
-                // Check if the thread is finished
-                if (g_stt_future.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
-                    std::string txt = g_stt_future.get();
-
-                    // Reset future
-                    g_stt_future = std::future<std::string>();
-
-                    if (!txt.empty() && txt.length() > 2) {
-                        // --- NEW INTEGRATION (The Fix) ---
-                        if (g_current_chat_ID != 0) {
-                            // 1. Send text to the Manager (instead of g_chat_history)
-                            ConvoManager::AddMessageToChat(g_current_chat_ID, "Player", txt);
-
-                            // 2. Get the clean history from the Manager
-                            std::vector<std::string> history = ConvoManager::GetChatHistory(g_current_chat_ID);
-
-                            // 3. Build Prompt using the Manager's history
-                            std::string prompt = AssemblePrompt(g_target_ped, playerPed, history);
-
-                            // 4. Launch LLM
-                            LogSystemMetrics("Pre-Inference (STT)");
-                            g_response_start_time = std::chrono::high_resolution_clock::now();
-                            g_llm_start_time = std::chrono::high_resolution_clock::now();
-                            g_llm_future = std::async(std::launch::async, GenerateLLMResponse, prompt);
-                            g_llm_state = InferenceState::RUNNING;
-                        }
-                    }
-                    else {
-                        Log("STT empty -> discard");
-                    }
-                    g_input_state = InputState::IDLE;
-                }
-                // Timeout check
-                else if (AbstractGame::GetTimeMs() > g_stt_start_time + 10000) {
+                if (AbstractGame::GetTimeMs() > g_stt_start_time + 10000) {
                     Log("STT Timeout -> discard");
-                    if (g_stt_future.valid()) g_stt_future = std::future<std::string>();
+                    Metrics::Increment(MetricCounter::STT_TIMEOUT);
+                    g_stt_ticket = 0;
+                    SttStream::Cancel();
+                    g_stt_future.Cancel();
+                    g_stt_future.Reset();
                     AbstractGame::ShowSubtitle("Transcription Timeout", 3000);
                     g_input_state = InputState::IDLE;
                 }
@@ -753,6 +884,9 @@ extern "C" __declspec(dllexport) void ScriptMain() {
             if (g_convo_state == ConvoState::IDLE && g_input_state == InputState::IDLE && g_llm_state == InferenceState::IDLE) {
                 if (IsGameInSafeMode()) {
                     if (IsKeyJustPressed(ConfigReader::g_Settings.ActivationKey)) {
+                        Tracer::BeginSession();
+                        Tracer::Instant("ActivationKey");
+                        int64_t traceStart = Tracer::NowUs();
 
                         // 1. Find Target
                         AHandle tempTarget = 0;
@@ -760,6 +894,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                         tempTarget = AbstractGame::GetClosestPed(centre, ConfigReader::g_Settings.MaxConversationRadius, playerPed);
 
                         bool found = AbstractGame::IsEntityValid(tempTarget);
+                        Tracer::Complete("Target Acquisition", traceStart, Tracer::NowUs());
 
                         // 2. Validate Target
                         if (found && AbstractGame::IsEntityLivingEntity(tempTarget) && tempTarget != playerPed) {
@@ -776,15 +911,20 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                             }
                             else {
                                 Log("Conversation START -> AHandle " + std::to_string(tempTarget));
+                                AmbientDialogue::Abort("player conversation");
                                 g_target_ped = tempTarget;
 
                                 // --- NEW SYSTEM START ---
+                                int64_t setupStart = Tracer::NowUs();
                                 // A. Create Session via Manager (Returns unique ID)
                                 g_current_chat_ID = ConvoManager::InitiateConversation(playerPed, g_target_ped);
 
                                 // B. Cache Name for UI (Manager handles the real memory)
-                                NpcPersona p = ConfigReader::GetPersona(g_target_ped);
-                                g_current_npc_name = !p.inGameName.empty() ? p.inGameName : GenerateNpcName(p);
+                                //    A warmed-up target keeps its name, otherwise the prefilled prompt wouldn't match
+                                if (!TargetPredictor::TakeWarmName(g_target_ped, g_current_npc_name)) {
+                                    NpcPersona p = ConfigReader::GetPersona(g_target_ped);
+                                    g_current_npc_name = !p.inGameName.empty() ? p.inGameName : GenerateNpcName(p);
+                                }
 
                                 Log("Started Chat ID: " + std::to_string(g_current_chat_ID));
 
@@ -793,6 +933,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
 
                                 // D. Init Tasks (Call your Modular Helper function)
                                 StartNpcConversationTasks(g_target_ped, playerPed);
+                                Tracer::Complete("Conversation Setup", setupStart, Tracer::NowUs());
 
                                 // E. Prompt User (Input Mode)
                                 if (ConfigReader::g_Settings.StT_Enabled) {
@@ -805,6 +946,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                                     AbstractGame::OpenKeyboard("FMMC_KEY_TIP", "", ConfigReader::g_Settings.MaxInputChars);
                                     g_input_state = InputState::WAITING_FOR_INPUT;
                                     Log("Keyboard opened");
+                                    PrefillNextTurn(playerPed);
                                 }
                             }
                         }
@@ -820,12 +962,19 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 IsKeyJustPressed(ConfigReader::g_Settings.StTRB_Activation_Key))
             {
                 LogA("PTT pressed ? start recording");
-                StartAudioRecording();
-                g_input_state = InputState::RECORDING;
+                Tracer::Instant("PTT Pressed");
+                StartRecording(false);
+                PrefillNextTurn(playerPed);
                 // UI::SET_TEXT... replaced((char*)"STRING");
                 // UI::ADD_TEXT... replaced((char*)"RECORDING (release to stop)");
                 AbstractGame::ShowSubtitle("", 10000);
             }
+            else if (IsOpenMicTurn()) {
+                // Hands-free: listen right away, the VAD decides when the player starts and stops talking
+                LogA("Open mic -> listening");
+                StartRecording(true);
+                PrefillNextTurn(playerPed);
+            }
 
 
             // ----- 8. LLM RESPONSE READY (UPDATED) -----
@@ -835,6 +984,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                     g_llm_state = InferenceState::IDLE;
                     continue;
                 }
+                Tracer::Instant("Reply Ready");
 
                 // 1. Clean the text
                 std::string clean = CleanupResponse(g_llm_response);
@@ -873,14 +1023,16 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 if (ConfigReader::g_Settings.TtS_Enabled) {
                     std::string voiceId = GetOrAssignNpcVoiceId(g_target_ped);
                     if (bridge && bridge->IsConnected()) {
-                        bridge->Send(clean, voiceId);
+                        TRACE_SCOPE("VoiceBridge Send");
+                        // Sentences streamed during generation are already queued, only the rest goes out
+                        if (!SentenceStream::Finish(clean, bridge)) bridge->Send(clean, voiceId);
                     }
                 }
 
                 // --- 6. DECIDE NEXT STEP ---
                 if (endConvo) {
                     Log("LLM requested end. Closing session.");
-                    EndConversation(); // Calls ConvoManager::CloseConversation internally now
+                    EndConversation(false); // the reply just queued is the farewell, let it play
                 }
                 else {
                     // Reset input state for the next turn
@@ -891,6 +1043,7 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                     else {
                         // Re-open keyboard
                         AbstractGame::OpenKeyboard("FMMC_KEY_TIP", "", ConfigReader::g_Settings.MaxInputChars);                        g_input_state = InputState::WAITING_FOR_INPUT;
+                        PrefillNextTurn(playerPed);
                     }
                 }
 
@@ -898,6 +1051,32 @@ extern "C" __declspec(dllexport) void ScriptMain() {
                 g_llm_state = InferenceState::IDLE;
             }
 
+            // ----- 9. AMBIENT DIALOGUE (NPC-to-NPC, spare capacity only) -----
+            AmbientDialogue::Update(bridge);
+
+            // ----- 10. TARGET WARM-UP (prefill the likely next conversation) -----
+            TargetPredictor::Update();
+
+            // ----- 11. TRACE + METRICS (TTS spans/RTF from the bridge state, session export, overlay) -----
+            int audioState = (bridge && bridge->IsConnected()) ? (int)bridge->GetState() : -1;
+            if (audioState >= 0) {
+                // The audio DLL can't post itself, so playback ends are picked up here. Counters
+                // instead of the state: with queued jobs the next one may start within the same frame.
+                static uint32_t lastCompleted = 0, lastFailed = 0;
+                uint32_t completed = bridge->GetCompletedJobs(), failed = bridge->GetFailedJobs();
+                for (; lastCompleted != completed; ++lastCompleted) EventQueue::Post(EventType::TTS_DONE, 0, "", 0, (int)AudioJobState::COMPLETED);
+                for (; lastFailed != failed; ++lastFailed) EventQueue::Post(EventType::TTS_DONE, 0, "", 0, (int)AudioJobState::FAILED);
+            }
+            Tracer::Update(audioState);
+            Metrics::Update(audioState);
+            Metrics::DrawOverlay();
+
+            // ----- 12. MEMORY GOVERNOR (resize the context between turns) -----
+            MemoryGovernor::Update();
+
+            // ----- 13. CPU GOVERNOR (frame-time signal, throttles background work) -----
+            CpuGovernor::OnFrame();
+
             AbstractGame::SystemWait(0);
         }
     }
@@ -917,13 +1096,15 @@ extern "C" __declspec(dllexport) void ScriptMain() {
 bool APIENTRY DllMain(HMODULE hMod, uint32_t reason, LPVOID) {
     switch (reason) {
     case DLL_PROCESS_ATTACH:
-    { std::ofstream f(LOG_FILE_NAME, std::ios::trunc); }
+    AsyncLogger::Truncate(LogFile::MAIN);
     Log("DLL attached");
     scriptRegister(hMod, ScriptMain);
     break;
     case DLL_PROCESS_DETACH:
         Log("DLL detach  shutdown");
-        if (g_isInitialized) ShutdownLLM();
+        TaskPool::Shutdown();
+        // MemoryGovernor's failure path clears g_isInitialized with the model still loaded
+        if (g_isInitialized || g_model != nullptr) ShutdownLLM(true);
 
         // Clean up bridge
         if (bridge) {
@@ -931,6 +1112,8 @@ bool APIENTRY DllMain(HMODULE hMod, uint32_t reason, LPVOID) {
             bridge = nullptr;
         }
 
+        ResourceMonitor::Stop();
+        AsyncLogger::Shutdown();
         scriptUnregister(hMod);
         break;
     }
@@ -969,8 +1152,15 @@ std::string PerformChatSummarization(const std::string& npcName, const std::vect
     }
     prompt << "<|end|>\n<|assistant|>\n";
 
-    // 3. Run inference (Returns the string)
-    return GenerateLLMResponse(prompt.str());
+    // 3. Run inference (Returns the string). Background priority, so it never delays a reply
+    // and it survives EndConversation().
+    GenRequest req;
+    req.prompt = prompt.str();
+    req.priority = GenPriority::BACKGROUND;
+    req.abortOnConvoEnd = false;
+    std::string summary = BatchScheduler::Submit(std::move(req)).get();
+    if (summary == "LLM_NOT_INITIALIZED" || summary == "TOKENIZATION_FAILED" || summary == "CTX_FAIL") return "";
+    return summary;
 }//EOF
 
 
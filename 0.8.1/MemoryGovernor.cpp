@@ -0,0 +1,260 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <vector>
+#include "main.h"
+#include "MemoryGovernor.h"
+
+// ------------------------------------------------------------
+// MEMORY GOVERNOR
+// Ladder (duplicates removed):
+//   0: INI KV type, full n_ctx
+//   1: <= Q8_0,     full n_ctx
+//   2: <= Q8_0,     3/4 n_ctx
+//   3: <= Q4_0,     1/2 n_ctx
+//   4: <= Q4_0,     1/2 n_ctx, KV cache in system RAM
+// The VRAM cost of a step is estimated from the model shape
+// (n_ctx * n_layer * 2 rows of n_embd_kv).
+// ------------------------------------------------------------
+
+// --- STATE ---
+static const TimeMillis CHECK_INTERVAL_MS = 1000;
+static const TimeMillis PRESSURE_HOLD_MS = 10000; // free < memory_low_mb this long -> step down
+static const TimeMillis RECOVER_HOLD_MS = 60000;  // room for the bigger step this long -> step up
+static const TimeMillis COOLDOWN_MS = 30000;      // after any transition
+static const uint32_t MIN_CTX = 2048;
+
+static std::vector<MemoryStep> g_steps;
+static int g_step = 0;
+static int g_target = 0;
+static TimeMillis g_last_check = 0;
+static TimeMillis g_pressure_since = 0;
+static TimeMillis g_recover_since = 0;
+static TimeMillis g_last_transition = 0;
+
+// --- HELPERS ---
+// KV type from the INI (same rules and log lines as the old startup code)
+static ggml_type ConfiguredKVType() {
+    ggml_type kv_type = ConfigReader::g_Settings.USE_VRAM_PREFERED ? GGML_TYPE_F32 : GGML_TYPE_F16;
+    switch (ConfigReader::g_Settings.KV_Cache_Quantization_Type)
+    {
+    case 2: kv_type = GGML_TYPE_Q2_K; Log("KV Cache Quantization: Using Q2_K (~2.56 bits)"); break;
+    case 3: kv_type = GGML_TYPE_Q3_K; Log("KV Cache Quantization: Using Q3_K (~3.43 bits)"); break;
+    case 4: kv_type = GGML_TYPE_Q4_K; Log("KV Cache Quantization: Using Q4_K (~4.5 bits)"); break;
+    case 5: kv_type = GGML_TYPE_Q5_K; Log("KV Cache Quantization: Using Q5_K (~5.5 bits)"); break;
+    case 6: kv_type = GGML_TYPE_Q6_K; Log("KV Cache Quantization: Using Q6_K (~6.56 bits)"); break;
+    case 8: kv_type = GGML_TYPE_Q8_0; Log("KV Cache Quantization: Using Q8_0 (8 bits)"); break;
+    default:
+        // No explicit quantization or unknown value, keeps the default (F32/F16).
+        Log("KV Cache Quantization: Using default float type (F32/F16).");
+        break;
+    }
+    return kv_type;
+}
+
+static double BitsPerValue(ggml_type t) {
+    return 8.0 * (double)ggml_type_size(t) / (double)ggml_blck_size(t);
+}
+
+static ggml_type Narrower(ggml_type a, ggml_type b) {
+    return BitsPerValue(b) < BitsPerValue(a) ? b : a;
+}
+
+static uint32_t RoundCtx(uint32_t n_ctx, uint32_t full) {
+    n_ctx = std::max(n_ctx, std::min(MIN_CTX, full));
+    return std::max<uint32_t>(256, n_ctx / 256 * 256);
+}
+
+static void BuildLadder() {
+    const uint32_t full = ConfigReader::g_Settings.Max_Working_Input;
+    const ggml_type base = ConfiguredKVType();
+    const ggml_type q8 = Narrower(base, GGML_TYPE_Q8_0);
+    const ggml_type q4 = Narrower(base, GGML_TYPE_Q4_0);
+
+    std::vector<MemoryStep> candidates = {
+        { full, base, true },
+        { full, q8, true },
+        { RoundCtx(full * 3 / 4, full), q8, true },
+        { RoundCtx(full / 2, full), q4, true },
+        { RoundCtx(full / 2, full), q4, false },
+    };
+    g_steps.clear();
+    for (const auto& s : candidates) {
+        if (!g_steps.empty()) {
+            const auto& p = g_steps.back();
+            if (p.n_ctx == s.n_ctx && p.kvType == s.kvType && p.kvOffload == s.kvOffload) continue;
+        }
+        g_steps.push_back(s);
+    }
+}
+
+// Estimated VRAM of the KV cache in MB (0 if it lives in RAM)
+static float KvVramMB(const MemoryStep& s) {
+    if (!g_model || !s.kvOffload) return 0.0f;
+    int32_t n_layer = llama_model_n_layer(g_model);
+    int32_t n_head = std::max(1, llama_model_n_head(g_model));
+    int32_t n_embd_kv = llama_model_n_embd(g_model) * llama_model_n_head_kv(g_model) / n_head;
+    double bytes = (double)s.n_ctx * n_layer * 2.0 * (double)ggml_row_size(s.kvType, n_embd_kv);
+    return (float)(bytes / 1024.0 / 1024.0);
+}
+
+static llama_context* BuildContext(const MemoryStep& s) {
+    llama_context_params ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = s.n_ctx;
+    ctx_params.n_batch = 1024;
+    ctx_params.n_ubatch = 256;
+    // One seq_id per concurrent request, all sharing the same KV cells
+    ctx_params.n_seq_max = static_cast<uint32_t>(std::max(1, ConfigReader::g_Settings.Parallel_Sequences));
+    ctx_params.kv_unified = true;
+    ctx_params.type_k = s.kvType;
+    ctx_params.type_v = s.kvType;
+    ctx_params.offload_kqv = s.kvOffload;
+    llama_context* ctx = llama_init_from_model(g_model, ctx_params);
+    CpuGovernor::AttachThreadpool(ctx);
+    return ctx;
+}
+
+// Between turns: nothing queued or decoding, nobody typing or recording. An open mic that
+// is only listening counts as between turns, otherwise open-mic chats would never resize.
+static bool AtSafePoint() {
+    bool inputIdle = g_input_state == InputState::IDLE || IsOpenMicListening();
+    return g_llm_state == InferenceState::IDLE && inputIdle &&
+        !AmbientDialogue::IsActive() && BatchScheduler::IsIdle();
+}
+
+static void Transition(int to) {
+    const int from = g_step;
+    const float freeMB = ResourceMonitor::GetFreeVRAM_MB(-1.0f);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    int64_t traceStart = Tracer::NowUs();
+
+    BatchScheduler::Stop();
+    llama_free(g_ctx);
+    g_ctx = nullptr;
+
+    // If the target does not fit after all, keep going down; as a last resort go back
+    int step = to;
+    for (; step < (int)g_steps.size() && !g_ctx; ++step) {
+        g_ctx = BuildContext(g_steps[step]);
+        if (!g_ctx) Log("MEMGOV: Could not create context for step " + std::to_string(step) + " (" + MemoryGovernor::Describe(g_steps[step]) + ")");
+    }
+    step--;
+    if (!g_ctx) {
+        step = from;
+        g_ctx = BuildContext(g_steps[from]);
+    }
+    if (!g_ctx) {
+        Log("MEMGOV: FATAL - no context could be created. LLM disabled until API_LoadLLM.");
+        g_isInitialized = false;
+        return;
+    }
+    if (g_lora_adapter) llama_set_adapter_lora(g_ctx, g_lora_adapter, ConfigReader::g_Settings.LORA_SCALE);
+    if (!BatchScheduler::Start()) {
+        Log("MEMGOV: FATAL - BatchScheduler did not restart. LLM disabled until API_LoadLLM.");
+        g_isInitialized = false;
+        return;
+    }
+
+    g_step = step;
+    g_target = step;
+    g_last_transition = GetTimeMs();
+    g_pressure_since = 0;
+    g_recover_since = 0;
+
+    std::chrono::duration<double, std::milli> took = std::chrono::high_resolution_clock::now() - t0;
+    Tracer::Complete("Context Recreate", traceStart, Tracer::NowUs(), "step", step);
+    Log("MEMGOV: Step " + std::to_string(from) + " -> " + std::to_string(step) + " (" + MemoryGovernor::Describe(g_steps[from]) + " -> " +
+        MemoryGovernor::Describe(g_steps[step]) + "), free VRAM before " + std::to_string((int)freeMB) + " MB, recreate took " +
+        std::to_string((int)took.count()) + " ms, prefix cache dropped.");
+}
+
+// --- PUBLIC ---
+std::string MemoryGovernor::Describe(const MemoryStep& s) {
+    std::string out = "n_ctx " + std::to_string(s.n_ctx) + ", KV " + ggml_type_name(s.kvType);
+    if (!s.kvOffload) out += " in RAM";
+    char est[32];
+    snprintf(est, sizeof(est), ", ~%.0f MB VRAM", KvVramMB(s));
+    return out + est;
+}
+
+llama_context* MemoryGovernor::CreateContext() {
+    if (!g_model) return nullptr;
+    BuildLadder();
+    g_step = 0;
+
+    if (ConfigReader::g_Settings.Memory_Governor) {
+        ResourceMonitor::Refresh(); // the model was just loaded
+        float freeMB = ResourceMonitor::GetFreeVRAM_MB(-1.0f);
+        if (freeMB >= 0.0f) {
+            const float headroom = (float)ConfigReader::g_Settings.Memory_Headroom_MB;
+            g_step = (int)g_steps.size() - 1;
+            for (int i = 0; i < (int)g_steps.size(); ++i) {
+                if (KvVramMB(g_steps[i]) + headroom <= freeMB) { g_step = i; break; }
+            }
+            Log("MEMGOV: " + std::to_string((int)freeMB) + " MB VRAM free after model load, starting at step " +
+                std::to_string(g_step) + " of " + std::to_string(g_steps.size() - 1));
+        }
+    }
+
+    for (int i = g_step; i < (int)g_steps.size(); ++i) {
+        llama_context* ctx = BuildContext(g_steps[i]);
+        if (ctx) {
+            g_step = i;
+            g_target = i;
+            g_last_transition = GetTimeMs();
+            Log("MEMGOV: Context created at step " + std::to_string(i) + " (" + Describe(g_steps[i]) + ")");
+            return ctx;
+        }
+        if (!ConfigReader::g_Settings.Memory_Governor) break;
+        Log("MEMGOV: Could not create context for step " + std::to_string(i) + ", trying the next one.");
+    }
+    return nullptr;
+}
+
+void MemoryGovernor::Update() {
+    if (!ConfigReader::g_Settings.Memory_Governor || !g_isInitialized || !g_ctx || g_steps.empty()) return;
+
+    TimeMillis now = GetTimeMs();
+    if (now - g_last_check >= CHECK_INTERVAL_MS) {
+        g_last_check = now;
+        float freeMB = ResourceMonitor::GetFreeVRAM_MB(-1.0f);
+        if (freeMB < 0.0f) return;
+
+        const bool pressure = freeMB < (float)ConfigReader::g_Settings.Memory_Low_MB;
+        g_pressure_since = pressure ? (g_pressure_since ? g_pressure_since : now) : 0;
+
+        // Stepping up costs the KV difference, it has to fit with headroom to spare
+        bool roomToGrow = false;
+        if (!pressure && g_step > 0) {
+            float extra = KvVramMB(g_steps[g_step - 1]) - KvVramMB(g_steps[g_step]);
+            roomToGrow = freeMB > extra + (float)ConfigReader::g_Settings.Memory_Headroom_MB;
+        }
+        g_recover_since = roomToGrow ? (g_recover_since ? g_recover_since : now) : 0;
+        // A request that is still waiting for its safe point lapses with its reason
+        if ((g_target > g_step && !pressure) || (g_target < g_step && !roomToGrow)) g_target = g_step;
+
+        if (now - g_last_transition >= COOLDOWN_MS) {
+            if (g_pressure_since && now - g_pressure_since >= PRESSURE_HOLD_MS && g_step + 1 < (int)g_steps.size()) {
+                if (g_target <= g_step) Log("MEMGOV: Sustained VRAM pressure (" + std::to_string((int)freeMB) + " MB free), stepping down at the next safe point.");
+                g_target = g_step + 1;
+            }
+            else if (g_recover_since && now - g_recover_since >= RECOVER_HOLD_MS) {
+                if (g_target >= g_step) Log("MEMGOV: VRAM pressure eased (" + std::to_string((int)freeMB) + " MB free), stepping up at the next safe point.");
+                g_target = g_step - 1;
+            }
+        }
+    }
+
+    if (g_target != g_step && AtSafePoint()) {
+        Transition(g_target);
+        // The new context starts empty, warm the listening turn again
+        if (IsOpenMicListening()) PrefillNextTurn(GetPlayerHandle());
+    }
+}
+
+int MemoryGovernor::GetStep() {
+    return g_step;
+}
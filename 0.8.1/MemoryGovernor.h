@@ -0,0 +1,27 @@
+#pragma once
+// MemoryGovernor.h
+#include <string>
+#include <cstdint>
+#include "llama.h"
+
+// One rung of the context ladder. Step 0 is what the INI asks for, every
+// following step needs less VRAM (narrower KV type, smaller n_ctx, KV in RAM).
+struct MemoryStep {
+    uint32_t n_ctx = 0;
+    ggml_type kvType = GGML_TYPE_F16;
+    bool kvOffload = true; // false = KV cache stays in system RAM
+};
+
+// Owns the g_ctx parameters. Picks the first step from the measured free VRAM,
+// steps down under sustained pressure and back up once it eases. Context
+// recreation only happens between turns, with the decode thread stopped.
+class MemoryGovernor {
+public:
+    // Creates a context for g_model (does not touch g_ctx). Needs a loaded model.
+    // Re-picks the step from the current free VRAM (memory_governor=1), else uses step 0.
+    static llama_context* CreateContext();
+    // Called once per script tick. Cheap unless a transition is due.
+    static void Update();
+    static int GetStep();
+    static std::string Describe(const MemoryStep& step);
+};
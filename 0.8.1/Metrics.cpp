@@ -0,0 +1,227 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "main.h"
+#include "SharedData.h"
+#include "Metrics.h"
+
+// ------------------------------------------------------------
+// METRICS
+// Values are stored as fixed point (1/100 of the unit) in log-linear buckets:
+// the first 64 values are exact, above that every power of two is split into
+// 32 linear sub-buckets. Shards are owned by one thread each and handed on to
+// the next thread once their owner exits (the decode thread is started again
+// on every model reload and context resize).
+// ------------------------------------------------------------
+
+// --- STATE ---
+static const double VALUE_SCALE = 100.0;
+static const int SUB_BITS = 5;
+static const int SUB_COUNT = 1 << SUB_BITS;        // 32
+static const int MAX_MSB = 40;                      // ~1e10 units, everything above is clamped
+static const int NUM_BUCKETS = (MAX_MSB - SUB_BITS) * SUB_COUNT + 2 * SUB_COUNT;
+static const int NUM_HISTS = (int)MetricHist::COUNT;
+static const int NUM_COUNTERS = (int)MetricCounter::COUNT;
+
+struct MetricShard {
+    std::atomic<uint64_t> buckets[NUM_HISTS][NUM_BUCKETS];
+    std::atomic<uint64_t> counters[NUM_COUNTERS];
+    MetricShard() {
+        for (auto& h : buckets) for (auto& b : h) b.store(0, std::memory_order_relaxed);
+        for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    }
+};
+
+static std::mutex g_shard_mutex; // guards the two lists, not the counts
+static std::vector<std::unique_ptr<MetricShard>> g_shards;
+static std::vector<MetricShard*> g_free_shards;
+
+// Returns the shard to the free list when its thread exits
+struct ShardLease {
+    MetricShard* shard = nullptr;
+    ~ShardLease() {
+        if (!shard) return;
+        std::lock_guard<std::mutex> lock(g_shard_mutex);
+        g_free_shards.push_back(shard);
+    }
+};
+static thread_local ShardLease t_lease;
+
+// Game thread only
+static int g_last_audio_phase = 0;
+static TimeMillis g_synth_start = 0;
+static TimeMillis g_play_start = 0;
+static TimeMillis g_synth_ms = 0;
+
+static std::vector<std::string> g_overlay_lines;
+static TimeMillis g_overlay_refresh = 0;
+static const TimeMillis OVERLAY_REFRESH_MS = 500;
+
+static const char* HIST_NAMES[NUM_HISTS] = { "TTFT ms", "Prefill tok/s", "Decode tok/s", "STT ms", "TTS RTF" };
+
+// --- HELPERS ---
+static MetricShard& LocalShard() {
+    if (!t_lease.shard) {
+        std::lock_guard<std::mutex> lock(g_shard_mutex);
+        if (!g_free_shards.empty()) {
+            t_lease.shard = g_free_shards.back();
+            g_free_shards.pop_back();
+        }
+        else {
+            g_shards.push_back(std::make_unique<MetricShard>());
+            t_lease.shard = g_shards.back().get();
+        }
+    }
+    return *t_lease.shard;
+}
+
+static int BucketIndex(uint64_t v) {
+    if (v < (uint64_t)(2 * SUB_COUNT)) return (int)v;
+    int msb = 63;
+    while (!(v >> msb)) msb--;
+    if (msb > MAX_MSB) return NUM_BUCKETS - 1;
+    int shift = msb - SUB_BITS;
+    return (shift * SUB_COUNT) + (int)(v >> shift);
+}
+
+// Midpoint of the bucket, in stored units
+static double BucketValue(int idx) {
+    if (idx < 2 * SUB_COUNT) return (double)idx;
+    int shift = idx / SUB_COUNT - 1;
+    uint64_t mantissa = (uint64_t)(idx % SUB_COUNT + SUB_COUNT);
+    uint64_t low = mantissa << shift;
+    uint64_t high = ((mantissa + 1) << shift) - 1;
+    return (low + high) / 2.0;
+}
+
+static std::vector<uint64_t> Merge(MetricHist hist) {
+    std::vector<uint64_t> merged(NUM_BUCKETS, 0);
+    std::lock_guard<std::mutex> lock(g_shard_mutex);
+    for (const auto& s : g_shards) {
+        for (int i = 0; i < NUM_BUCKETS; ++i) merged[i] += s->buckets[(int)hist][i].load(std::memory_order_relaxed);
+    }
+    return merged;
+}
+
+static std::string Fmt(double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), v < 10.0 ? "%.2f" : "%.0f", v);
+    return buf;
+}
+
+// --- RECORDING ---
+void Metrics::Record(MetricHist hist, double value) {
+    if ((int)hist < 0 || (int)hist >= NUM_HISTS || !(value >= 0.0)) return;
+    uint64_t v = (uint64_t)std::llround(std::min(value * VALUE_SCALE, 1e15));
+    LocalShard().buckets[(int)hist][BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Increment(MetricCounter counter, uint64_t by) {
+    if ((int)counter < 0 || (int)counter >= NUM_COUNTERS) return;
+    LocalShard().counters[(int)counter].fetch_add(by, std::memory_order_relaxed);
+}
+
+// --- READING ---
+double Metrics::Percentile(MetricHist hist, double p) {
+    if ((int)hist < 0 || (int)hist >= NUM_HISTS) return 0.0;
+    std::vector<uint64_t> merged = Merge(hist);
+    uint64_t total = 0;
+    for (uint64_t c : merged) total += c;
+    if (total == 0) return 0.0;
+
+    p = std::max(0.0, std::min(100.0, p));
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100.0 * total));
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += merged[i];
+        if (seen >= rank) return BucketValue(i) / VALUE_SCALE;
+    }
+    return BucketValue(NUM_BUCKETS - 1) / VALUE_SCALE;
+}
+
+uint64_t Metrics::GetCount(MetricHist hist) {
+    if ((int)hist < 0 || (int)hist >= NUM_HISTS) return 0;
+    uint64_t total = 0;
+    for (uint64_t c : Merge(hist)) total += c;
+    return total;
+}
+
+uint64_t Metrics::GetCounter(MetricCounter counter) {
+    if ((int)counter < 0 || (int)counter >= NUM_COUNTERS) return 0;
+    uint64_t total = 0;
+    std::lock_guard<std::mutex> lock(g_shard_mutex);
+    for (const auto& s : g_shards) total += s->counters[(int)counter].load(std::memory_order_relaxed);
+    return total;
+}
+
+std::string Metrics::Summary() {
+    std::string out;
+    for (int h = 0; h < NUM_HISTS; ++h) {
+        MetricHist hist = (MetricHist)h;
+        out += std::string(HIST_NAMES[h]) + ": p50 " + Fmt(Percentile(hist, 50)) + " p95 " + Fmt(Percentile(hist, 95)) +
+            " p99 " + Fmt(Percentile(hist, 99)) + " (n=" + std::to_string(GetCount(hist)) + ")\n";
+    }
+    out += "Cache " + std::to_string(GetCounter(MetricCounter::CACHE_HIT)) + "/" +
+        std::to_string(GetCounter(MetricCounter::CACHE_HIT) + GetCounter(MetricCounter::CACHE_MISS)) +
+        " | Cancelled " + std::to_string(GetCounter(MetricCounter::CANCELLED)) +
+        " | Timeouts LLM " + std::to_string(GetCounter(MetricCounter::LLM_TIMEOUT)) +
+        " STT " + std::to_string(GetCounter(MetricCounter::STT_TIMEOUT)) +
+        " | No speech " + std::to_string(GetCounter(MetricCounter::VAD_REJECTED)) +
+        " | TTS " + std::to_string(GetCounter(MetricCounter::TTS_SPOKEN)) + " spoken, " +
+        std::to_string(GetCounter(MetricCounter::TTS_FAILED)) + " failed, " +
+        std::to_string(GetCounter(MetricCounter::TTS_DROPPED)) + " dropped";
+    return out;
+}
+
+// Counts recorded concurrently with a reset may survive it
+void Metrics::Reset() {
+    std::lock_guard<std::mutex> lock(g_shard_mutex);
+    for (auto& s : g_shards) {
+        for (auto& h : s->buckets) for (auto& b : h) b.store(0, std::memory_order_relaxed);
+        for (auto& c : s->counters) c.store(0, std::memory_order_relaxed);
+    }
+}
+
+// --- GAME THREAD ---
+// TTS runs in the audio DLL. The PLAYING time of a job stands in for its audio length.
+void Metrics::Update(int audioState) {
+    const int phase = AudioPhase(audioState);
+    if (phase == g_last_audio_phase) return;
+
+    TimeMillis now = GetTimeMs();
+    if (g_last_audio_phase == 1) g_synth_ms = now - g_synth_start;
+    if (g_last_audio_phase == 2 && g_synth_ms > 0) {
+        TimeMillis played = now - g_play_start;
+        if (played > 0) Record(MetricHist::TTS_RTF, (double)g_synth_ms / (double)played);
+        g_synth_ms = 0;
+    }
+    if (phase == 1) g_synth_start = now;
+    if (phase == 2) g_play_start = now;
+    if (phase == 0) g_synth_ms = 0;
+    g_last_audio_phase = phase;
+}
+
+void Metrics::DrawOverlay() {
+    if (!ConfigReader::g_Settings.Metrics_Overlay) return;
+
+    TimeMillis now = GetTimeMs();
+    if (now - g_overlay_refresh >= OVERLAY_REFRESH_MS) {
+        g_overlay_refresh = now;
+        g_overlay_lines.clear();
+        std::stringstream ss(Summary());
+        std::string line;
+        while (std::getline(ss, line)) g_overlay_lines.push_back(line);
+    }
+
+    float y = 0.02f;
+    for (const auto& line : g_overlay_lines) {
+        DrawText2D(line, 0.5f, y, 0.3f, 255, 255, 255, 220);
+        y += 0.022f;
+    }
+}
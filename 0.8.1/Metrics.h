@@ -0,0 +1,52 @@
+#pragma once
+// Metrics.h
+#include <string>
+#include <cstdint>
+
+// Always-on latency histograms. Values in the unit named by the entry.
+// The numeric values are part of the DLL API (API_Metrics_*), append only.
+enum class MetricHist : int {
+    TTFT_MS = 0,       // submit -> first token (interactive requests)
+    PREFILL_TPS = 1,   // prompt tokens per second (cached tokens excluded)
+    DECODE_TPS = 2,    // reply tokens per second after the prefill
+    STT_MS = 3,        // whisper transcription
+    TTS_RTF = 4,       // synthesis time / playback time
+    COUNT
+};
+
+enum class MetricCounter : int {
+    CACHE_HIT = 0,     // request reused a cached prefix
+    CACHE_MISS = 1,
+    CANCELLED = 2,     // queued or running requests dropped by Cancel / ambient preemption
+    LLM_TIMEOUT = 3,
+    STT_TIMEOUT = 4,
+    VAD_REJECTED = 5,  // recordings without speech, whisper skipped
+    TTS_SPOKEN = 6,    // VoiceBridge jobs played to the end
+    TTS_FAILED = 7,    // VoiceBridge jobs the audio DLL gave up on
+    TTS_DROPPED = 8,   // streamed sentences the voice queue had no room for
+    COUNT
+};
+
+// Log-linear buckets with ~3% relative error (HDR style). Every thread writes its own
+// shard without locks. Reads merge all shards, so they are meant for polling, not hot paths.
+class Metrics {
+public:
+    // --- RECORDING (thread safe) ---
+    static void Record(MetricHist hist, double value);
+    static void Increment(MetricCounter counter, uint64_t by = 1);
+
+    // --- READING (merges the shards) ---
+    // p in [0, 100]. 0 if nothing was recorded.
+    static double Percentile(MetricHist hist, double p);
+    static uint64_t GetCount(MetricHist hist);
+    static uint64_t GetCounter(MetricCounter counter);
+    // One line per histogram and one for the counters (overlay, API, log)
+    static std::string Summary();
+    static void Reset();
+
+    // --- GAME THREAD ---
+    // Called once per script tick with the VoiceBridge job state (-1 = no bridge), feeds TTS_RTF
+    static void Update(int audioState);
+    // Debug overlay (metrics_overlay=1), must run every frame
+    static void DrawOverlay();
+};
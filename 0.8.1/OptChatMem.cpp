@@ -3,8 +3,6 @@
 #include <thread>
 #include <chrono>
 #include <sstream>
-#include <dxgi1_4.h> 
-#pragma comment(lib, "dxgi.lib")
 #include "main.h"
 #include "OptChatMem.h"
 #include "ConfigReader.h" // Needed to read specific settings
@@ -12,35 +10,15 @@
 using namespace AbstractGame;
 
 // --- GLOBALS ---
-static std::future<std::string> g_optimizationFuture;
-static bool g_isOptimizing = false;
-static int g_linesBeingSummarized = 0;
+static bool g_isOptimizing = false; // until its SUMMARY_READY went through ApplySummary
 static std::map<ChatID, OptimizationProfile> g_profiles;
 
 // ---------------------------------------------------------
 // 1. VRAM CHECKER (Hardware Safety)
 // ---------------------------------------------------------
 float ChatOptimizer::GetAvailableVRAM_MB() {
-    IDXGIFactory4* pFactory = nullptr;
-    if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory4), (void**)&pFactory))) return 0.0f;
-
-    IDXGIAdapter* pAdapter = nullptr;
-    float freeVRAM = 0.0f;
-
-    if (SUCCEEDED(pFactory->EnumAdapters(0, &pAdapter))) {
-        IDXGIAdapter3* pAdapter3 = nullptr;
-        if (SUCCEEDED(pAdapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&pAdapter3))) {
-            DXGI_QUERY_VIDEO_MEMORY_INFO memInfo;
-            if (SUCCEEDED(pAdapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memInfo))) {
-                uint64_t available = memInfo.Budget - memInfo.CurrentUsage;
-                freeVRAM = (float)(available / 1024 / 1024);
-            }
-            pAdapter3->Release();
-        }
-        pAdapter->Release();
-    }
-    pFactory->Release();
-    return freeVRAM;
+    // Cached by the ResourceMonitor; 0 = unknown
+    return ResourceMonitor::GetFreeVRAM_MB(0.0f);
 }
 
 // ---------------------------------------------------------
@@ -48,6 +26,7 @@ float ChatOptimizer::GetAvailableVRAM_MB() {
 // ---------------------------------------------------------
 bool ChatOptimizer::CheckAndOptimize(ChatID chatID, std::vector<std::string>& history, const std::string& npcName, const std::string& playerName) {
     if (g_isOptimizing) return false;
+    if (CpuGovernor::ThrottleBackground()) return false; // frame time is suffering, summarize later
 
     // 1. Check Settings
     int level = ConfigReader::g_Settings.Level_Optimization_Chat_Going;
@@ -80,7 +59,7 @@ bool ChatOptimizer::CheckAndOptimize(ChatID chatID, std::vector<std::string>& hi
         chunkToSummarize.push_back(history[i]);
     }
 
-    g_linesBeingSummarized = (endIdx - startIdx);
+    int linesBeingSummarized = (endIdx - startIdx);
     g_isOptimizing = true;
 
     // 4. Dynamic Throttle (Don't hog CPU)
@@ -94,11 +73,26 @@ bool ChatOptimizer::CheckAndOptimize(ChatID chatID, std::vector<std::string>& hi
 
     int throttleInt = static_cast<int>(targetSpeed);
 
-    // 5. Launch Background Task
-    g_optimizationFuture = std::async(std::launch::async,
-        &ChatOptimizer::BackgroundSummarizerTask,
-        chunkToSummarize, npcName, playerName, throttleInt
-    );
+    // 5. Launch Background Task (the result comes back as SUMMARY_READY)
+    // ApplySummary clears g_isOptimizing. If the task is dropped (pool shutdown) or throws,
+    // the guard posts an empty result when the task is destroyed, so the flag can't stick.
+    struct SummaryGuard {
+        ChatID chatID = 0;
+        int lines = 0;
+        bool posted = false;
+        ~SummaryGuard() { if (!posted) EventQueue::Post(EventType::SUMMARY_READY, 0, "", chatID, lines); }
+    };
+    auto guard = std::make_shared<SummaryGuard>();
+    guard->chatID = chatID;
+    guard->lines = linesBeingSummarized;
+    TaskPool::Submit("Chat Optimizer", TaskPriority::LOW, Workload::BACKGROUND,
+        [chunkToSummarize, npcName, playerName, throttleInt, guard]() {
+            return ChatOptimizer::BackgroundSummarizerTask(chunkToSummarize, npcName, playerName, throttleInt);
+        },
+        [guard](const std::string& summary) {
+            guard->posted = true;
+            EventQueue::Post(EventType::SUMMARY_READY, 0, summary, guard->chatID, guard->lines);
+        });
 
     return true;
 }
@@ -131,6 +125,8 @@ std::string ChatOptimizer::BackgroundSummarizerTask(std::vector<std::string> lin
     llama_context_params ctx_params = llama_context_default_params();
     ctx_params.n_ctx = 2048; // Ensure enough space for the summarization task
     ctx_params.n_batch = 512;
+    ctx_params.n_threads = CpuGovernor::ThreadsFor(Workload::BACKGROUND);
+    ctx_params.n_threads_batch = ctx_params.n_threads;
 
     llama_context* ctx_sum = llama_init_from_model(g_model, ctx_params);
     if (!ctx_sum) return "";
@@ -199,29 +195,21 @@ std::string ChatOptimizer::BackgroundSummarizerTask(std::vector<std::string> lin
 // ---------------------------------------------------------
 // 4. APPLY RESULT (Thread Safe Injection)
 // ---------------------------------------------------------
-bool ChatOptimizer::ApplyPendingOptimizations(std::vector<std::string>& history) {
-    if (!g_isOptimizing) return false;
+bool ChatOptimizer::ApplySummary(const std::string& summary, int removeCount, std::vector<std::string>& history) {
+    g_isOptimizing = false;
 
-    // Non-blocking check
-    if (g_optimizationFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-        std::string summary = g_optimizationFuture.get();
-        g_isOptimizing = false;
-
-        if (summary.empty() || summary.length() < 5) return false;
+    if (summary.empty() || summary.length() < 5) return false;
 
+    // Safety check to ensure history hasn't changed drastically while we were working
+    if (removeCount > 0 && history.size() > (size_t)removeCount + 1) {
         Log("OPTIMIZER: Applied intermediate summary: " + summary);
-        int removeCount = g_linesBeingSummarized;
-
-        // Safety check to ensure history hasn't changed drastically while we were working
-        if (history.size() > removeCount + 1) {
-            auto startIt = history.begin() + 1;
-            auto endIt = startIt + removeCount;
-            history.erase(startIt, endIt);
+        auto startIt = history.begin() + 1;
+        auto endIt = startIt + removeCount;
+        history.erase(startIt, endIt);
 
-            // Insert the new summary block
-            history.insert(history.begin() + 1, "<|system|>\n[INTERMEDIATE SUMMARY]: " + summary);
-            return true;
-        }
+        // Insert the new summary block
+        history.insert(history.begin() + 1, "<|system|>\n[INTERMEDIATE SUMMARY]: " + summary);
+        return true;
     }
     return false;
 }
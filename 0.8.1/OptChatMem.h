@@ -26,9 +26,10 @@ public:
         const std::string& playerName
     );
 
+    // Called with the summary of a SUMMARY_READY event; removeCount = lines it replaces.
     // Returns TRUE if the history was modified (summarized).
     // ModMain must check this bool and then save the history back to ConvoManager.
-    static bool ApplyPendingOptimizations(std::vector<std::string>& history);
+    static bool ApplySummary(const std::string& summary, int removeCount, std::vector<std::string>& history);
 
     // UPDATE: Changed 'int' to 'ChatID'
     static void SetConversationProfile(ChatID chatID, int level);
@@ -0,0 +1,214 @@
+#define NOMINMAX
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+// No main.h: this file also builds on Linux for tests/ResourceMonitorTest.cpp
+#include "helperfunctions.h"
+#include "AsyncLogger.h"
+#include "ConfigReader.h"
+#include "ResourceMonitor.h"
+#include "ThreadExit.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#include <dxgi1_4.h>
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "Psapi.lib")
+#endif
+
+// ------------------------------------------------------------
+// RESOURCE MONITOR
+// The DXGI factory/adapter is created once and queried from the sampler
+// thread. Readers only load two atomics, so it is fine to call the getters
+// every frame or before every turn.
+// ------------------------------------------------------------
+
+// --- PROVIDERS ---
+#ifdef _WIN32
+class DxgiResourceProvider : public IResourceProvider {
+public:
+    ~DxgiResourceProvider() override {
+        if (m_adapter) m_adapter->Release();
+    }
+    const char* Name() const override { return "DXGI"; }
+
+    bool SampleRAM(float& ramMB) override {
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return false;
+        ramMB = static_cast<float>(pmc.WorkingSetSize) / 1024.f / 1024.f;
+        return true;
+    }
+
+    bool SampleVRAM(float& usedMB, float& budgetMB) override {
+        if (!m_adapter && !OpenAdapter()) return false;
+        DXGI_QUERY_VIDEO_MEMORY_INFO memInfo;
+        if (FAILED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memInfo))) {
+            // Device removed / driver reset: open it again next time
+            m_adapter->Release();
+            m_adapter = nullptr;
+            return false;
+        }
+        usedMB = static_cast<float>(memInfo.CurrentUsage) / 1024.f / 1024.f;
+        budgetMB = static_cast<float>(memInfo.Budget) / 1024.f / 1024.f;
+        return true;
+    }
+
+private:
+    bool OpenAdapter() {
+        IDXGIFactory4* pFactory = nullptr;
+        if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory4), (void**)&pFactory))) return false;
+        IDXGIAdapter* pAdapter = nullptr;
+        if (SUCCEEDED(pFactory->EnumAdapters(0, &pAdapter))) {
+            pAdapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&m_adapter);
+            pAdapter->Release();
+        }
+        pFactory->Release();
+        return m_adapter != nullptr;
+    }
+
+    IDXGIAdapter3* m_adapter = nullptr;
+};
+#endif
+
+// RAM from /proc/self/status. No portable VRAM source, callers get their fallback.
+class ProcResourceProvider : public IResourceProvider {
+public:
+    const char* Name() const override { return "/proc"; }
+
+    bool SampleRAM(float& ramMB) override {
+        std::ifstream f("/proc/self/status");
+        std::string line;
+        while (std::getline(f, line)) {
+            if (line.compare(0, 6, "VmRSS:") != 0) continue;
+            try { ramMB = std::stof(line.substr(6)) / 1024.f; }
+            catch (...) { return false; }
+            return true;
+        }
+        return false;
+    }
+
+    bool SampleVRAM(float&, float&) override { return false; }
+};
+
+// --- STATE ---
+
+static std::unique_ptr<IResourceProvider> g_provider;
+static std::mutex g_provider_mutex; // sampler thread vs. Refresh()
+static std::thread g_sampler;
+static std::mutex g_sampler_mutex;
+static std::condition_variable g_sampler_cv;
+static std::atomic<bool> g_sampler_running{ false };
+static std::atomic<bool> g_sampler_done{ true };
+
+// Cached sample. Used and budget share one word so readers never mix two samples.
+static std::atomic<float> g_ram_mb{ -1.0f };
+static std::atomic<uint64_t> g_vram_packed{ 0 }; // hi = used, lo = budget (float bits), 0 = none
+
+// --- HELPERS ---
+static uint64_t PackVRAM(float usedMB, float budgetMB) {
+    uint32_t u, b;
+    std::memcpy(&u, &usedMB, sizeof(u));
+    std::memcpy(&b, &budgetMB, sizeof(b));
+    return ((uint64_t)u << 32) | b;
+}
+
+static void UnpackVRAM(uint64_t packed, float& usedMB, float& budgetMB) {
+    uint32_t u = (uint32_t)(packed >> 32), b = (uint32_t)packed;
+    std::memcpy(&usedMB, &u, sizeof(u));
+    std::memcpy(&budgetMB, &b, sizeof(b));
+}
+
+static void TakeSample() {
+    std::lock_guard<std::mutex> lock(g_provider_mutex);
+    if (!g_provider) return;
+    float ram = 0.0f, used = 0.0f, budget = 0.0f;
+    if (g_provider->SampleRAM(ram)) g_ram_mb.store(ram, std::memory_order_relaxed);
+    if (g_provider->SampleVRAM(used, budget) && budget > 0.0f) g_vram_packed.store(PackVRAM(used, budget), std::memory_order_relaxed);
+}
+
+static void SamplerLoop() {
+    while (g_sampler_running) {
+        try { TakeSample(); }
+        catch (...) {}
+        int interval = std::max(100, ConfigReader::g_Settings.Telemetry_Interval_Ms);
+        std::unique_lock<std::mutex> lock(g_sampler_mutex);
+        g_sampler_cv.wait_for(lock, std::chrono::milliseconds(interval), [] { return !g_sampler_running; });
+    }
+    g_sampler_done = true;
+}
+
+// --- LIFECYCLE ---
+void ResourceMonitor::Start(std::unique_ptr<IResourceProvider> provider) {
+    if (g_sampler_running) return;
+    if (!g_sampler_done) {
+        LOG_WARN(Log, "ResourceMonitor: Previous sampler still running, not restarting.");
+        return;
+    }
+    if (provider) g_provider = std::move(provider);
+#ifdef _WIN32
+    else g_provider = std::make_unique<DxgiResourceProvider>();
+#else
+    else g_provider = std::make_unique<ProcResourceProvider>();
+#endif
+    // Readings of the previous provider don't describe this one
+    g_ram_mb = -1.0f;
+    g_vram_packed = 0;
+    TakeSample();
+
+    g_sampler_done = false;
+    g_sampler_running = true;
+    g_sampler = std::thread(SamplerLoop);
+    Log("ResourceMonitor: Sampling via " + std::string(g_provider->Name()) + " every " +
+        std::to_string(ConfigReader::g_Settings.Telemetry_Interval_Ms) + " ms.");
+}
+
+void ResourceMonitor::Stop() {
+    if (!g_sampler_running) return;
+    {
+        std::lock_guard<std::mutex> lock(g_sampler_mutex);
+        g_sampler_running = false;
+    }
+    g_sampler_cv.notify_all();
+    WaitForThreadExit([] { return g_sampler_done.load(); }); // no join, see ThreadExit.h
+    if (g_sampler.joinable()) g_sampler.detach();
+    if (g_sampler_done) g_provider.reset(); // else the thread may still be inside it
+}
+
+void ResourceMonitor::Refresh() {
+    if (!g_sampler_running) return;
+    try { TakeSample(); }
+    catch (...) {}
+}
+
+// --- CACHED VALUES ---
+ResourceSample ResourceMonitor::Latest() {
+    ResourceSample s;
+    s.ramMB = g_ram_mb.load(std::memory_order_relaxed);
+    s.ramValid = s.ramMB >= 0.0f;
+    if (!s.ramValid) s.ramMB = 0.0f;
+    uint64_t packed = g_vram_packed.load(std::memory_order_relaxed);
+    s.vramValid = packed != 0;
+    if (s.vramValid) UnpackVRAM(packed, s.vramUsedMB, s.vramBudgetMB);
+    return s;
+}
+
+float ResourceMonitor::GetRAM_MB() {
+    return std::max(0.0f, g_ram_mb.load(std::memory_order_relaxed));
+}
+
+float ResourceMonitor::GetFreeVRAM_MB(float fallback) {
+    uint64_t packed = g_vram_packed.load(std::memory_order_relaxed);
+    if (packed == 0) return fallback;
+    float used, budget;
+    UnpackVRAM(packed, used, budget);
+    return budget - used;
+}
+
+bool ResourceMonitor::HasVRAM() {
+    return g_vram_packed.load(std::memory_order_relaxed) != 0;
+}
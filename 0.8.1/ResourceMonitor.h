@@ -0,0 +1,63 @@
+#pragma once
+// ResourceMonitor.h
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// One reading of the process / GPU memory
+struct ResourceSample {
+    float ramMB = 0.0f;        // process working set
+    float vramUsedMB = 0.0f;   // local segment, whole process
+    float vramBudgetMB = 0.0f;
+    bool ramValid = false;
+    bool vramValid = false;
+};
+
+// Where the numbers come from. Sample() runs on the monitor thread only.
+class IResourceProvider {
+public:
+    virtual ~IResourceProvider() = default;
+    virtual const char* Name() const = 0;
+    virtual bool SampleRAM(float& ramMB) = 0;
+    virtual bool SampleVRAM(float& usedMB, float& budgetMB) = 0;
+};
+
+// Scripted values for tests and headless runs. Set() may be called while the sampler runs.
+// A budget of 0 means no VRAM reading.
+class MockResourceProvider : public IResourceProvider {
+public:
+    MockResourceProvider(float ramMB, float vramUsedMB, float vramBudgetMB) { Set(ramMB, vramUsedMB, vramBudgetMB); }
+    void Set(float ramMB, float vramUsedMB, float vramBudgetMB) {
+        m_ram = ramMB;
+        m_used = vramUsedMB;
+        m_budget = vramBudgetMB;
+    }
+    const char* Name() const override { return "Mock"; }
+    bool SampleRAM(float& ramMB) override { ramMB = m_ram; return true; }
+    bool SampleVRAM(float& usedMB, float& budgetMB) override { usedMB = m_used; budgetMB = m_budget; return budgetMB > 0.0f; }
+private:
+    std::atomic<float> m_ram{ 0.0f }, m_used{ 0.0f }, m_budget{ 0.0f };
+};
+
+// Samples RAM and VRAM at Telemetry_Interval_Ms on its own thread.
+// All getters read the last cached sample and never touch DXGI.
+class ResourceMonitor {
+public:
+    // --- LIFECYCLE ---
+    // Forgets the old readings, takes one sample on the calling thread, then starts the sampler.
+    // provider = nullptr picks the platform one (DXGI + psapi on Windows, /proc on Linux).
+    // 0.8.1/tests/ResourceMonitorTest.cpp drives it with a MockResourceProvider.
+    static void Start(std::unique_ptr<IResourceProvider> provider = nullptr);
+    // Safe from DllMain (no join)
+    static void Stop();
+    // Samples on the calling thread right now (e.g. right after loading a model)
+    static void Refresh();
+
+    // --- CACHED VALUES ---
+    static ResourceSample Latest();
+    static float GetRAM_MB();
+    // Budget - usage, 'fallback' if the provider has no VRAM reading (yet)
+    static float GetFreeVRAM_MB(float fallback);
+    static bool HasVRAM();
+};
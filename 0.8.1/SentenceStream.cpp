@@ -0,0 +1,209 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+#include "main.h"
+#include "SharedData.h"
+#include "Metrics.h"
+#include "SentenceStream.h"
+
+// ------------------------------------------------------------
+// SENTENCE STREAM
+// The stream mirrors what CleanupResponse does to the full reply: a short
+// "Name: " prefix is skipped and nothing after a stop marker is spoken.
+// A sentence ends at . ! ? or a line break followed by whitespace, so the
+// next piece has to arrive before one is sent ("3.5", "Mr. Smith" stay whole).
+// Short sentences are merged with the next one, TTS has a fixed cost per job.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static const size_t MIN_SENTENCE_CHARS = 12;
+static const size_t NAME_PREFIX_MAX = 15;   // same limit as CleanupResponse
+
+static uint64_t g_ticket = 0;
+static std::string g_voiceId;
+static std::vector<std::string> g_markers;  // stop strings, cut like in CleanupResponse
+static std::string g_raw;                   // streamed text of the reply so far
+static size_t g_bodyStart = std::string::npos; // reply text after a name prefix (npos = not decided yet)
+static size_t g_spokenEnd = 0;              // g_raw up to here is queued
+static std::string g_spoken;                // queued sentences, to line them up with the final reply
+static bool g_stopped = false;              // a stop marker showed up or the bridge dropped a line, the rest is left to Finish
+static int g_sentences = 0;
+
+// --- HELPERS ---
+static std::string Trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\n\r");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\n\r");
+    return s.substr(b, e - b + 1);
+}
+
+// Tags that end the conversation are for the script, not for the voice
+static std::string Speakable(std::string s) {
+    static const char* tags[] = { "[END_CONVERSATION]", "<END_CONVERSATION>", "<|endofchat|>" };
+    for (const char* tag : tags) {
+        size_t at;
+        while ((at = s.find(tag)) != std::string::npos) s.erase(at, strlen(tag));
+    }
+    return Trim(s);
+}
+
+static bool IsAbbreviation(const std::string& text, size_t dot) {
+    size_t b = dot;
+    while (b > 0 && std::isalpha((unsigned char)text[b - 1])) --b;
+    std::string word = text.substr(b, dot - b);
+    if (word.length() == 1 && std::isupper((unsigned char)word[0])) return true; // initial
+    static const char* abbrevs[] = { "Mr", "Mrs", "Ms", "Dr", "St", "Jr", "Sr", "vs", "Lt", "Sgt", "Prof" };
+    for (const char* a : abbrevs) if (word == a) return true;
+    return false;
+}
+
+// End of the first sentence in g_raw[from, limit) that is long enough, npos if none is complete
+static size_t FindSentenceEnd(size_t from, size_t limit) {
+    for (size_t i = from; i < limit; ++i) {
+        char c = g_raw[i];
+        size_t end;
+        if (c == '\n') {
+            end = i + 1;
+        }
+        else if (c == '.' || c == '!' || c == '?') {
+            end = i + 1;
+            while (end < limit && strchr(".!?\"')*", g_raw[end])) ++end; // "...", "?!", closing quotes
+            if (end >= limit || !std::isspace((unsigned char)g_raw[end])) continue;
+            if (c == '.' && end == i + 1 && IsAbbreviation(g_raw, i)) continue;
+        }
+        else {
+            continue;
+        }
+        if (Trim(g_raw.substr(from, end - from)).length() >= MIN_SENTENCE_CHARS) return end;
+    }
+    return std::string::npos;
+}
+
+// Position in 'text' right after 'prefix', ignoring whitespace differences. If they differ,
+// the start of the first word of 'text' that doesn't match ('complete' = false).
+static size_t MatchPrefix(const std::string& text, const std::string& prefix, bool& complete) {
+    size_t t = 0;
+    complete = false;
+    for (size_t p = 0; p < prefix.length(); ++p) {
+        if (std::isspace((unsigned char)prefix[p])) continue;
+        while (t < text.length() && std::isspace((unsigned char)text[t])) ++t;
+        if (t >= text.length()) return t; // the reply ends inside what was spoken
+        if (text[t] != prefix[p]) {
+            while (t > 0 && !std::isspace((unsigned char)text[t - 1])) --t;
+            return t;
+        }
+        ++t;
+    }
+    complete = true;
+    return t;
+}
+
+// Only lines the bridge took count as spoken. After a dropped one nothing more is
+// streamed, so Finish says the rest once and in order. False = dropped.
+static bool Queue(const std::string& sentence, VoiceBridge* bridge) {
+    std::string line = Speakable(sentence);
+    if (line.empty() || !bridge || !bridge->IsConnected()) return true;
+    if (g_sentences == 0) Tracer::Instant("First Sentence");
+    if (!bridge->Send(line, g_voiceId)) {
+        Log("SentenceStream: voice queue full, sentence dropped, the rest is left to the final reply");
+        Metrics::Increment(MetricCounter::TTS_DROPPED);
+        g_stopped = true;
+        return false;
+    }
+    g_spoken += line + " ";
+    g_sentences++;
+    return true;
+}
+
+static void Reset() {
+    g_ticket = 0;
+    g_raw.clear();
+    g_spoken.clear();
+    g_bodyStart = std::string::npos;
+    g_spokenEnd = 0;
+    g_stopped = false;
+    g_sentences = 0;
+}
+
+// --- PUBLIC ---
+bool SentenceStream::IsEnabled() {
+    return ConfigReader::g_Settings.TtS_Enabled && ConfigReader::g_Settings.Tts_Sentence_Streaming != 0;
+}
+
+void SentenceStream::Begin(uint64_t ticket, const std::string& voiceId) {
+    Reset();
+    g_ticket = ticket;
+    g_voiceId = voiceId;
+
+    g_markers = ConfigReader::SplitString(ConfigReader::g_Settings.StopStrings, ',');
+    g_markers.push_back("<|");
+    g_markers.push_back("[END");
+    g_markers.push_back("<END");
+    if (!g_current_npc_name.empty()) g_markers.push_back(g_current_npc_name + ":");
+    g_markers.erase(std::remove(g_markers.begin(), g_markers.end(), std::string()), g_markers.end());
+}
+
+void SentenceStream::OnTokenChunk(const CompletionEvent& ev, VoiceBridge* bridge) {
+    if (ev.ticket == 0 || ev.ticket != g_ticket || g_stopped) return;
+    g_raw += ev.text;
+
+    // Name prefix: decided at the first ": " or once the text is too long for one
+    if (g_bodyStart == std::string::npos) {
+        size_t colon = g_raw.find(": ");
+        if (colon != std::string::npos) {
+            std::string prefix = g_raw.substr(0, colon);
+            bool isName = !g_current_npc_name.empty() && (g_current_npc_name.rfind(prefix, 0) == 0 || prefix.length() < NAME_PREFIX_MAX);
+            g_bodyStart = isName ? colon + 2 : 0;
+        }
+        else if (g_raw.length() > NAME_PREFIX_MAX + 1 || g_current_npc_name.empty()) {
+            g_bodyStart = 0;
+        }
+        else {
+            return;
+        }
+        g_spokenEnd = g_bodyStart;
+    }
+
+    // Nothing after a stop marker is part of the reply
+    size_t limit = g_raw.length();
+    for (const std::string& m : g_markers) {
+        size_t at = g_raw.find(m, g_spokenEnd);
+        if (at != std::string::npos && at < limit) { limit = at; g_stopped = true; }
+    }
+
+    size_t end;
+    while ((end = FindSentenceEnd(g_spokenEnd, limit)) != std::string::npos) {
+        if (!Queue(g_raw.substr(g_spokenEnd, end - g_spokenEnd), bridge)) break;
+        g_spokenEnd = end;
+    }
+}
+
+bool SentenceStream::Finish(const std::string& cleanReply, VoiceBridge* bridge) {
+    if (g_ticket == 0) return false;
+
+    std::string rest;
+    if (g_spoken.empty()) {
+        rest = cleanReply;
+    }
+    else {
+        // Cleanup changed text that was already spoken (error reply, timeout): go on from the first word that differs
+        bool complete;
+        rest = cleanReply.substr(MatchPrefix(cleanReply, g_spoken, complete));
+        if (!complete) Log("SentenceStream: final reply differs from the streamed sentences, speaking the rest from there");
+    }
+    int streamed = g_sentences;
+    Queue(rest, bridge);
+    if (streamed > 0) Log("SentenceStream: " + std::to_string(streamed) + " sentence(s) queued during generation");
+    Reset();
+    return true;
+}
+
+void SentenceStream::Cancel() {
+    Reset();
+}
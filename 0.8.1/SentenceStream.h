@@ -0,0 +1,27 @@
+#pragma once
+// SentenceStream.h
+#include <cstdint>
+#include <string>
+
+class VoiceBridge;
+struct CompletionEvent;
+
+// Cuts the streamed tokens of the interactive reply into sentences and queues each one
+// on the VoiceBridge as soon as it is complete, so the NPC starts talking while the LLM
+// is still writing the rest. The cleaned reply decides what is left at the end.
+class SentenceStream {
+public:
+    // Speech enabled and tts_sentence_streaming=1
+    static bool IsEnabled();
+
+    // --- SCRIPT THREAD ---
+    // New reply; pieces with another ticket are ignored
+    static void Begin(uint64_t ticket, const std::string& voiceId);
+    // TOKEN_CHUNK handler
+    static void OnTokenChunk(const CompletionEvent& ev, VoiceBridge* bridge);
+    // Final cleaned reply: queues what was not spoken yet. False if no stream was
+    // running (the caller sends the whole reply as before).
+    static bool Finish(const std::string& cleanReply, VoiceBridge* bridge);
+    // The reply is abandoned; already queued sentences still play
+    static void Cancel();
+};
@@ -3,20 +3,34 @@
 #define _CRT_SECURE_NO_WARNINGS
 #define _SILENCE_ALL_CXX17_DEPRECATION_WARNINGS
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <string>
 #include <cstdint>
 
 // 1. Include AbstractCalls to access GetTimeMs
 
 // Versioning
-#define BRIDGE_VERSION "v2"
+#define BRIDGE_VERSION "v4"
 #define SHARED_MEM_NAME "Local\\EC_DATA_POOL_01_" BRIDGE_VERSION
+#define JOB_EVENT_NAME "Local\\EC_VOICE_JOB_" BRIDGE_VERSION // signalled by Send, the audio DLL waits on it
 
 // Buffer Sizes
 #define BUFFER_SIZE 8192
 #define VOICE_ID_SIZE 64
+#define VOICE_QUEUE_SLOTS 8 // power of two
 
 enum class AudioJobState : int32_t {
     IDLE = 0,
@@ -27,35 +41,115 @@ enum class AudioJobState : int32_t {
     FAILED = 5
 };
 
-#pragma pack(push, 1)
-struct SharedVoiceData {
-    // Status (4 bytes, aligned)
-    volatile AudioJobState jobState;
-
-    // Timestamp for timeout detection (8 bytes)
-    volatile ULONGLONG lastUpdateTime;
-
-    // Job Data
+// 0 = idle, 1 = queued/synthesizing, 2 = playing (Tracer spans and the TTS_RTF metric)
+inline int AudioPhase(int audioState) {
+    if (audioState == (int)AudioJobState::PENDING || audioState == (int)AudioJobState::PROCESSING) return 1;
+    if (audioState == (int)AudioJobState::PLAYING) return 2;
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Bounded queue of jobs in shared memory (Vyukov). Every slot carries a
+// sequence number: == position means free for the writer, == position + 1
+// means filled for the reader. Positions are claimed with a CAS, so the host
+// can also take a stale job off the queue when the audio DLL hangs.
+// The atomics must be lock-free, otherwise they would not work across processes.
+// ------------------------------------------------------------
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "VoiceBridge needs lock-free 32-bit atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "VoiceBridge needs lock-free 64-bit atomics");
+
+struct VoiceJobSlot {
+    std::atomic<uint32_t> sequence;
+    uint32_t jobId;
+    float speed;
     char text[BUFFER_SIZE];
     char voiceId[VOICE_ID_SIZE];
-    float speed;
+};
+
+struct SharedVoiceData {
+    alignas(64) std::atomic<uint32_t> writePos;  // next position Send fills
+    alignas(64) std::atomic<uint32_t> readPos;   // next position CheckForJob takes
+
+    // Status of the job the audio DLL is working on
+    alignas(64) std::atomic<int32_t> jobState;   // AudioJobState
+    std::atomic<uint32_t> currentJob;            // job id being synthesized/played
+    std::atomic<uint32_t> activeJobs;            // taken off the queue, not finished yet (synthesizing or waiting to play)
+    std::atomic<uint32_t> cancelBefore;          // jobs with a lower id are skipped (CancelPending)
+    std::atomic<uint32_t> completedJobs;         // counters, only ever go up
+    std::atomic<uint32_t> failedJobs;
+    std::atomic<uint32_t> droppedJobs;           // queue full
+    std::atomic<uint64_t> lastUpdateTime;        // client heartbeat for timeout detection
 
     // Error Info
     char errorMsg[256];
+
+    VoiceJobSlot slots[VOICE_QUEUE_SLOTS];
 };
-#pragma pack(pop)
 
 class VoiceBridge {
 private:
+#ifdef _WIN32
     HANDLE hMapFile;
+    HANDLE hJobEvent;
+#else
+    int shmFd;
+    sem_t* jobSem;
+#endif
     SharedVoiceData* pData;
     bool isHost;
 
     // Timeout in milliseconds
-    static const ULONGLONG TIMEOUT_MS = 10000;  // 10 seconds
+    static const uint64_t TIMEOUT_MS = 10000;  // 10 seconds
+    static const uint32_t SLOT_MASK = VOICE_QUEUE_SLOTS - 1;
 
-public:
-    VoiceBridge(bool host) : isHost(host), hMapFile(NULL), pData(NULL) {
+    static uint64_t Now() {
+        return AbstractGame::GetTimeMs();
+    }
+
+    // Takes the oldest job off the queue. False if it is empty.
+    bool PopJob(VoiceJobSlot& out) {
+        uint32_t pos = pData->readPos.load(std::memory_order_relaxed);
+        for (;;) {
+            VoiceJobSlot& slot = pData->slots[pos & SLOT_MASK];
+            uint32_t seq = slot.sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - (pos + 1));
+            if (diff == 0) {
+                if (pData->readPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out.jobId = slot.jobId;
+                    out.speed = slot.speed;
+                    memcpy(out.text, slot.text, BUFFER_SIZE);
+                    memcpy(out.voiceId, slot.voiceId, VOICE_ID_SIZE);
+                    slot.sequence.store(pos + SLOT_MASK + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // empty
+            }
+            else {
+                pos = pData->readPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // SetError also reports failures outside of a job (model load), so never below zero
+    void FinishJob() {
+        uint32_t active = pData->activeJobs.load(std::memory_order_relaxed);
+        while (active > 0 && !pData->activeJobs.compare_exchange_weak(active, active - 1, std::memory_order_acq_rel)) {}
+    }
+
+    uint32_t QueuedJobs() const {
+        uint32_t w = pData->writePos.load(std::memory_order_acquire);
+        uint32_t r = pData->readPos.load(std::memory_order_acquire);
+        return w - r;
+    }
+
+    // --- PLATFORM ---
+    // Windows: file mapping + auto-reset event. POSIX (Linux test harness):
+    // shm_open/mmap + a named semaphore that WaitJob drains, so a burst of
+    // Sends still wakes the consumer once like the event does.
+#ifdef _WIN32
+    void MapShared() {
         if (isHost) {
             // HOST: Create Shared Memory
             hMapFile = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
@@ -75,24 +169,113 @@ public:
         if (hMapFile) {
             pData = (SharedVoiceData*)MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0,
                 0, sizeof(SharedVoiceData));
-
-            // Only Host initializes at startup
-            if (isHost && pData) {
-                pData->jobState = AudioJobState::IDLE;
-                // FIXED: Added namespace AbstractGame::
-                pData->lastUpdateTime = AbstractGame::GetTimeMs();
-                pData->text[0] = '\0';
-                pData->voiceId[0] = '\0';
-                pData->speed = 1.0f;
-                pData->errorMsg[0] = '\0';
-            }
         }
     }
 
-    ~VoiceBridge() {
+    // Auto-reset: one SetEvent wakes the consumer once, however many jobs it brings.
+    // CreateEventA opens the event if the other side made it first.
+    void OpenJobEvent() { hJobEvent = CreateEventA(NULL, FALSE, FALSE, JOB_EVENT_NAME); }
+    void SignalJob() { if (hJobEvent) SetEvent(hJobEvent); }
+    bool HasJobEvent() const { return hJobEvent != NULL; }
+    void WaitJob(uint32_t timeoutMs) { WaitForSingleObject(hJobEvent, timeoutMs); }
+    static void SleepMs(uint32_t ms) { Sleep(ms); }
+
+    void CloseShared() {
+        if (hJobEvent) CloseHandle(hJobEvent);
         if (pData) UnmapViewOfFile(pData);
         if (hMapFile) CloseHandle(hMapFile);
     }
+#else
+    // "Local\\X" -> "/Local_X"; POSIX names take one leading slash and nothing else
+    static std::string PosixName(const char* name) {
+        std::string s = "/";
+        for (const char* p = name; *p; ++p) s += (*p == '\\' || *p == '/') ? '_' : *p;
+        return s;
+    }
+
+    void MapShared() {
+        std::string name = PosixName(SHARED_MEM_NAME);
+        if (isHost) {
+            // HOST: Create Shared Memory, or reopen the one a crashed host left behind
+            shmFd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+            if (shmFd >= 0 && ftruncate(shmFd, sizeof(SharedVoiceData)) != 0) {
+                close(shmFd);
+                shmFd = -1;
+            }
+        }
+        else {
+            // CLIENT: Open existing memory
+            shmFd = shm_open(name.c_str(), O_RDWR, 0600);
+        }
+
+        if (shmFd >= 0) {
+            void* p = mmap(NULL, sizeof(SharedVoiceData), PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+            pData = (p == MAP_FAILED) ? NULL : (SharedVoiceData*)p;
+        }
+    }
+
+    void OpenJobEvent() {
+        sem_t* s = sem_open(PosixName(JOB_EVENT_NAME).c_str(), O_CREAT, 0600, 0);
+        jobSem = (s == SEM_FAILED) ? NULL : s;
+    }
+    void SignalJob() { if (jobSem) sem_post(jobSem); }
+    bool HasJobEvent() const { return jobSem != NULL; }
+
+    void WaitJob(uint32_t timeoutMs) {
+        timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += timeoutMs / 1000;
+        until.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L) { until.tv_sec++; until.tv_nsec -= 1000000000L; }
+        while (sem_timedwait(jobSem, &until) != 0 && errno == EINTR) {}
+        while (sem_trywait(jobSem) == 0) {} // auto-reset: drop the posts of the same burst
+    }
+    static void SleepMs(uint32_t ms) { usleep((useconds_t)ms * 1000); }
+
+    void CloseShared() {
+        if (jobSem) sem_close(jobSem);
+        if (pData) munmap(pData, sizeof(SharedVoiceData));
+        if (shmFd >= 0) close(shmFd);
+        // The names outlive every process on POSIX; the host drops them like Windows does with the last handle
+        if (isHost) {
+            shm_unlink(PosixName(SHARED_MEM_NAME).c_str());
+            sem_unlink(PosixName(JOB_EVENT_NAME).c_str());
+        }
+    }
+#endif
+
+public:
+#ifdef _WIN32
+    VoiceBridge(bool host) : hMapFile(NULL), hJobEvent(NULL), pData(NULL), isHost(host) {
+#else
+    VoiceBridge(bool host) : shmFd(-1), jobSem(NULL), pData(NULL), isHost(host) {
+#endif
+        MapShared();
+
+        // Only Host initializes at startup
+        if (isHost && pData) {
+            for (uint32_t i = 0; i < VOICE_QUEUE_SLOTS; ++i) {
+                pData->slots[i].sequence.store(i, std::memory_order_relaxed);
+                pData->slots[i].text[0] = '\0';
+                pData->slots[i].voiceId[0] = '\0';
+            }
+            pData->writePos.store(0, std::memory_order_relaxed);
+            pData->readPos.store(0, std::memory_order_relaxed);
+            pData->currentJob.store(0, std::memory_order_relaxed);
+            pData->activeJobs.store(0, std::memory_order_relaxed);
+            pData->cancelBefore.store(0, std::memory_order_relaxed);
+            pData->completedJobs.store(0, std::memory_order_relaxed);
+            pData->failedJobs.store(0, std::memory_order_relaxed);
+            pData->droppedJobs.store(0, std::memory_order_relaxed);
+            pData->errorMsg[0] = '\0';
+            pData->lastUpdateTime.store(Now(), std::memory_order_relaxed);
+            pData->jobState.store((int32_t)AudioJobState::IDLE, std::memory_order_release);
+        }
+
+        if (pData) OpenJobEvent();
+    }
+
+    ~VoiceBridge() { CloseShared(); }
 
     bool IsConnected() const { return pData != nullptr; }
 
@@ -100,66 +283,93 @@ public:
     // HOST FUNCTIONS (Main Mod)
     // ========================================
 
+    // Queues a job. False only if the queue is full and the audio DLL is alive.
     bool Send(const std::string& text, const std::string& voiceId, float speed = 1.0f) {
         if (!pData) return false;
 
-        AudioJobState currentState = pData->jobState;
-
-        // Only IDLE or COMPLETED allow new jobs
-        if (currentState != AudioJobState::IDLE &&
-            currentState != AudioJobState::COMPLETED) {
-
-            // FIXED: Added namespace AbstractGame::
-            ULONGLONG now = AbstractGame::GetTimeMs();
-            ULONGLONG elapsed = now - pData->lastUpdateTime;
-
-            if (elapsed > TIMEOUT_MS) {
-                // Timeout! Reset and try again
-                pData->jobState = AudioJobState::IDLE;
-                pData->lastUpdateTime = now;
+        uint32_t pos = pData->writePos.load(std::memory_order_relaxed);
+        for (;;) {
+            VoiceJobSlot& slot = pData->slots[pos & SLOT_MASK];
+            uint32_t seq = slot.sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0) {
+                if (pData->writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    size_t lenText = std::min<size_t>(text.length(), BUFFER_SIZE - 1);
+                    memcpy(slot.text, text.c_str(), lenText);
+                    slot.text[lenText] = '\0';
+
+                    size_t lenVoice = std::min<size_t>(voiceId.length(), VOICE_ID_SIZE - 1);
+                    memcpy(slot.voiceId, voiceId.c_str(), lenVoice);
+                    slot.voiceId[lenVoice] = '\0';
+
+                    slot.speed = speed;
+                    slot.jobId = pos + 1; // 0 = no job
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    SignalJob();
+                    return true;
+                }
             }
-            else {
+            else if (diff < 0) {
+                // Full. If the audio DLL stopped answering, its oldest job goes.
+                uint64_t elapsed = Now() - pData->lastUpdateTime.load(std::memory_order_relaxed);
+                VoiceJobSlot stale;
+                if (elapsed > TIMEOUT_MS && PopJob(stale)) {
+                    pData->droppedJobs.fetch_add(1, std::memory_order_relaxed);
+                    pos = pData->writePos.load(std::memory_order_relaxed);
+                    continue;
+                }
+                pData->droppedJobs.fetch_add(1, std::memory_order_relaxed);
                 return false;
             }
+            else {
+                pos = pData->writePos.load(std::memory_order_relaxed);
+            }
         }
+    }
 
-        size_t lenText = std::min<size_t>(text.length(), BUFFER_SIZE - 1);
-        memcpy(pData->text, text.c_str(), lenText);
-        pData->text[lenText] = '\0';
-
-        size_t lenVoice = std::min<size_t>(voiceId.length(), VOICE_ID_SIZE - 1);
-        memcpy(pData->voiceId, voiceId.c_str(), lenVoice);
-        pData->voiceId[lenVoice] = '\0';
-
-        pData->speed = speed;
-        pData->errorMsg[0] = '\0';
-
-        // FIXED: Added namespace AbstractGame::
-        pData->lastUpdateTime = AbstractGame::GetTimeMs();
-        pData->jobState = AudioJobState::PENDING;
-
-        return true;
+    // Jobs queued so far are skipped by the audio DLL and the one playing stops
+    void CancelPending() {
+        if (!pData) return;
+        pData->cancelBefore.store(pData->writePos.load(std::memory_order_acquire) + 1, std::memory_order_release);
     }
 
+    // Nothing queued and nothing being synthesized or played
     bool IsReady() const {
         if (!pData) return false;
-        AudioJobState state = pData->jobState;
+        AudioJobState state = GetState();
         return (state == AudioJobState::IDLE || state == AudioJobState::COMPLETED);
     }
 
     bool IsTalking() const {
         if (!pData) return false;
-        AudioJobState state = pData->jobState;
+        AudioJobState state = GetState();
         return (state == AudioJobState::PROCESSING ||
             state == AudioJobState::PLAYING);
     }
 
+    // State of the current job. While one job finished and the next is still synthesizing
+    // it is PROCESSING, while the audio DLL hasn't taken the queued ones yet PENDING.
+    AudioJobState GetState() const {
+        if (!pData) return AudioJobState::IDLE;
+        AudioJobState state = (AudioJobState)pData->jobState.load(std::memory_order_acquire);
+        bool idle = (state == AudioJobState::IDLE || state == AudioJobState::COMPLETED || state == AudioJobState::FAILED);
+        if (idle && pData->activeJobs.load(std::memory_order_acquire) > 0) return AudioJobState::PROCESSING;
+        if (idle && QueuedJobs() > 0) return AudioJobState::PENDING;
+        return state;
+    }
+
+    int GetQueuedJobs() const { return pData ? (int)QueuedJobs() : 0; }
+    // Finished jobs since the host started; a change means a job ended even if the state already moved on
+    uint32_t GetCompletedJobs() const { return pData ? pData->completedJobs.load(std::memory_order_acquire) : 0; }
+    uint32_t GetFailedJobs() const { return pData ? pData->failedJobs.load(std::memory_order_acquire) : 0; }
+    uint32_t GetDroppedJobs() const { return pData ? pData->droppedJobs.load(std::memory_order_relaxed) : 0; }
+
     std::string GetStatusString() const {
         if (!pData) return "DISCONNECTED";
 
-        switch (pData->jobState) {
+        switch (GetState()) {
         case AudioJobState::IDLE:       return "IDLE";
-        case AudioJobState::PENDING:    return "PENDING";
+        case AudioJobState::PENDING:    return "PENDING (" + std::to_string(QueuedJobs()) + " queued)";
         case AudioJobState::PROCESSING: return "PROCESSING";
         case AudioJobState::PLAYING:    return "PLAYING";
         case AudioJobState::COMPLETED:  return "COMPLETED";
@@ -172,29 +382,47 @@ public:
     // CLIENT FUNCTIONS (Audio DLL)
     // ========================================
 
+    // Blocks until Send signals a job or timeoutMs passes. Queued jobs don't wait.
+    bool WaitForJob(uint32_t timeoutMs) {
+        if (!pData) return false;
+        if (QueuedJobs() > 0) return true;
+        if (!HasJobEvent()) { SleepMs(timeoutMs); return QueuedJobs() > 0; }
+        WaitJob(timeoutMs);
+        return QueuedJobs() > 0;
+    }
+
+    // Id of the job CheckForJob returned last
+    uint32_t CurrentJob() const { return pData ? pData->currentJob.load(std::memory_order_acquire) : 0; }
+    // The host cancelled that job after it was taken (its audio should stop)
+    bool IsCancelled(uint32_t jobId) const {
+        return pData && jobId < pData->cancelBefore.load(std::memory_order_acquire);
+    }
+
     bool CheckForJob(std::string& outText, std::string& outVoiceId, float& outSpeed) {
         if (!pData) return false;
 
-        if (pData->jobState != AudioJobState::PENDING) {
-            return false;
+        static VoiceJobSlot job; // 8 KB, only the audio thread gets here
+        for (;;) {
+            if (!PopJob(job)) return false;
+            if (job.jobId >= pData->cancelBefore.load(std::memory_order_acquire)) break;
         }
 
-        outText = pData->text;
-        outVoiceId = pData->voiceId;
-        outSpeed = pData->speed;
+        outText = job.text;
+        outVoiceId = job.voiceId;
+        outSpeed = job.speed;
 
-        // FIXED: Added namespace AbstractGame::
-        pData->lastUpdateTime = AbstractGame::GetTimeMs();
-        pData->jobState = AudioJobState::PROCESSING;
+        pData->currentJob.store(job.jobId, std::memory_order_relaxed);
+        pData->activeJobs.fetch_add(1, std::memory_order_acq_rel);
+        pData->lastUpdateTime.store(Now(), std::memory_order_relaxed);
+        pData->jobState.store((int32_t)AudioJobState::PROCESSING, std::memory_order_release);
 
         return true;
     }
 
     void SetState(AudioJobState newState) {
         if (!pData) return;
-        // FIXED: Added namespace AbstractGame::
-        pData->lastUpdateTime = AbstractGame::GetTimeMs();
-        pData->jobState = newState;
+        pData->lastUpdateTime.store(Now(), std::memory_order_relaxed);
+        pData->jobState.store((int32_t)newState, std::memory_order_release);
     }
 
     void SetError(const std::string& errorMsg) {
@@ -204,15 +432,16 @@ public:
         memcpy(pData->errorMsg, errorMsg.c_str(), len);
         pData->errorMsg[len] = '\0';
 
-        // FIXED: Added namespace AbstractGame::
-        pData->lastUpdateTime = AbstractGame::GetTimeMs();
-        pData->jobState = AudioJobState::FAILED;
+        pData->failedJobs.fetch_add(1, std::memory_order_relaxed);
+        FinishJob();
+        SetState(AudioJobState::FAILED);
     }
 
+    // Call once per job taken with CheckForJob (jobs may be synthesized ahead of playback)
     void CompleteJob() {
         if (!pData) return;
-        // FIXED: Added namespace AbstractGame::
-        pData->lastUpdateTime = AbstractGame::GetTimeMs();
-        pData->jobState = AudioJobState::COMPLETED;
+        pData->completedJobs.fetch_add(1, std::memory_order_relaxed);
+        FinishJob();
+        SetState(AudioJobState::COMPLETED);
     }
-};
\ No newline at end of file
+};
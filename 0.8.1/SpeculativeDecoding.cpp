@@ -0,0 +1,396 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include "main.h"
+#include "SpeculativeDecoding.h"
+
+// ------------------------------------------------------------
+// SPECULATIVE DECODING
+// Two proposal sources guess the next few tokens:
+//  - Prompt lookup: the last n tokens are searched in the prompt + reply so far and
+//    whatever followed them is copied (names, places, quoted lines repeat a lot).
+//  - Draft model: a small model with the main model's tokenizer guesses greedily.
+// The BatchScheduler appends the guess to the main model's next batch and keeps it
+// only while the main model's own samples agree.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static llama_model* g_draft_model = nullptr;
+static llama_context* g_draft_ctx = nullptr;
+static llama_batch g_draft_batch;
+static bool g_draft_batch_ready = false;
+static const int32_t DRAFT_BATCH_SIZE = 512;
+
+static int32_t g_draft_n_past = 0;     // tokens of the sequence already in the draft KV
+static int32_t g_proposal_base = 0;    // sequence length when the last proposal started
+static int32_t g_proposal_decoded = 0; // proposed tokens that were decoded into the draft KV
+static int g_draft_depth = 4;          // adapts between Draft_Min_Tokens and Draft_Max_Tokens
+static bool g_draft_active = false;    // draft prefill succeeded this turn
+
+// Prompt lookup: one map per n-gram length, hash -> most recent start position
+static std::vector<std::unordered_map<uint64_t, int32_t>> g_lookup_index;
+static int32_t g_lookup_indexed = 0;   // sequence length covered by the index
+static int g_lookup_depth = 4;         // adapts between 1 and Lookup_Max_Tokens
+static bool g_lookup_active = false;
+
+enum class ProposalSource { NONE, LOOKUP, DRAFT_MODEL };
+static ProposalSource g_last_source = ProposalSource::NONE;
+
+// --- HELPERS ---
+static llama_token ArgMaxToken(const float* logits, int32_t n_vocab) {
+    llama_token best = 0;
+    float best_val = logits[0];
+    for (int32_t i = 1; i < n_vocab; ++i) {
+        if (logits[i] > best_val) { best_val = logits[i]; best = i; }
+    }
+    return best;
+}
+
+// Decodes tokens[from, to) into draft seq 0. Only the very last token requests logits.
+static bool DecodeDraftRange(const std::vector<llama_token>& tokens, int32_t from, int32_t to) {
+    for (int32_t start = from; start < to; start += DRAFT_BATCH_SIZE) {
+        int32_t count = std::min(DRAFT_BATCH_SIZE, to - start);
+        g_draft_batch.n_tokens = count;
+        for (int32_t i = 0; i < count; i++) {
+            g_draft_batch.token[i] = tokens[start + i];
+            g_draft_batch.pos[i] = start + i;
+            g_draft_batch.n_seq_id[i] = 1;
+            g_draft_batch.seq_id[i][0] = 0;
+            g_draft_batch.logits[i] = (start + i == to - 1);
+        }
+        if (llama_decode(g_draft_ctx, g_draft_batch) != 0) return false;
+    }
+    return true;
+}
+
+static bool UsesPromptLookup() {
+    int mode = ConfigReader::g_Settings.Speculative_Mode;
+    return mode == 2 || mode == 3;
+}
+
+static bool UsesDraftModel() {
+    int mode = ConfigReader::g_Settings.Speculative_Mode;
+    return mode == 1 || mode == 3;
+}
+
+static uint64_t HashNgram(const llama_token* tokens, int n) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (int i = 0; i < n; ++i) {
+        h ^= (uint32_t)tokens[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Indexes every n-gram that has at least one token after it. The trailing n-gram of
+// the sequence is left out on purpose so a lookup can never match itself.
+static void IndexNgrams(const std::vector<llama_token>& tokens) {
+    const int32_t n_tok = (int32_t)tokens.size();
+    const int nMin = ConfigReader::g_Settings.Lookup_Ngram_Min;
+    for (size_t k = 0; k < g_lookup_index.size(); ++k) {
+        const int n = nMin + (int)k;
+        for (int32_t p = std::max(0, g_lookup_indexed - n); p + n < n_tok; ++p) {
+            g_lookup_index[k][HashNgram(&tokens[p], n)] = p;
+        }
+    }
+    g_lookup_indexed = n_tok;
+}
+
+// Longest suffix first, most recent occurrence wins
+static int ProposeFromLookup(const std::vector<llama_token>& history, int depth, std::vector<llama_token>& outDraft) {
+    const int32_t n_hist = (int32_t)history.size();
+    const int nMin = ConfigReader::g_Settings.Lookup_Ngram_Min;
+    for (int k = (int)g_lookup_index.size() - 1; k >= 0; --k) {
+        const int n = nMin + k;
+        if (n_hist <= n) continue;
+
+        const llama_token* tail = &history[n_hist - n];
+        auto it = g_lookup_index[k].find(HashNgram(tail, n));
+        if (it == g_lookup_index[k].end()) continue;
+
+        int32_t p = it->second;
+        if (!std::equal(tail, tail + n, &history[p])) continue; // hash collision
+
+        for (int32_t c = p + n; c < n_hist && (int)outDraft.size() < depth; ++c) {
+            outDraft.push_back(history[c]);
+        }
+        if (!outDraft.empty()) return (int)outDraft.size();
+    }
+    return 0;
+}
+
+static void AdaptDepth(int& depth, int minDepth, int maxDepth, int proposed, int accepted) {
+    // Grow while the guesses are right, shrink when most of them are wasted
+    if (accepted == proposed && proposed >= depth) {
+        depth = std::min(maxDepth, depth + 1);
+    }
+    else if (accepted * 2 < proposed) {
+        depth = std::max(minDepth, depth - 1);
+    }
+}
+
+static bool IsVocabCompatible(const llama_model* main_model, const llama_model* draft_model) {
+    const llama_vocab* vm = llama_model_get_vocab(main_model);
+    const llama_vocab* vd = llama_model_get_vocab(draft_model);
+    int32_t n_main = llama_vocab_n_tokens(vm);
+    int32_t n_draft = llama_vocab_n_tokens(vd);
+
+    // Padding tokens may differ a little, the real vocabulary may not
+    if (std::abs(n_main - n_draft) > 128) {
+        LogLLM("SPEC: Vocab size mismatch (main " + std::to_string(n_main) + ", draft " + std::to_string(n_draft) + ")");
+        return false;
+    }
+    if (llama_vocab_bos(vm) != llama_vocab_bos(vd) || llama_vocab_eos(vm) != llama_vocab_eos(vd)) {
+        LogLLM("SPEC: BOS/EOS tokens differ between main and draft model");
+        return false;
+    }
+    int32_t n_check = std::min(std::min(n_main, n_draft), 256);
+    for (int32_t i = 5; i < n_check; ++i) {
+        if (strcmp(llama_vocab_get_text(vm, i), llama_vocab_get_text(vd, i)) != 0) {
+            LogLLM("SPEC: Token " + std::to_string(i) + " differs between main and draft model");
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- LIFECYCLE ---
+bool SpeculativeDecoder::InitializeFromConfig(const std::string& rootPath) {
+    const auto& s = ConfigReader::g_Settings;
+    if (s.Speculative_Mode == 0) {
+        LogLLM("SPEC: Speculative decoding disabled in config.");
+        return false;
+    }
+
+    if (UsesPromptLookup()) {
+        g_lookup_depth = std::max(1, s.Lookup_Max_Tokens / 2);
+        LogLLM("SPEC: Prompt lookup on. N-gram " + std::to_string(s.Lookup_Ngram_Min) + "-" +
+            std::to_string(s.Lookup_Ngram_Max) + ", up to " + std::to_string(s.Lookup_Max_Tokens) + " tokens per guess");
+    }
+    if (!UsesDraftModel()) return UsesPromptLookup();
+
+    std::string draftPath;
+    const auto& cust = ConfigReader::g_Settings.DRAFT_MODEL_PATH;
+    const auto& alt = ConfigReader::g_Settings.DRAFT_MODEL_ALT_NAME;
+    if (!cust.empty() && DoesFileExist(cust)) draftPath = cust;
+    else if (!alt.empty() && DoesFileExist(rootPath + alt)) draftPath = rootPath + alt;
+
+    if (draftPath.empty()) {
+        LogLLM(UsesPromptLookup() ? "SPEC: No draft model found. Using prompt lookup only."
+                                  : "SPEC: No draft model found. Speculative decoding stays off.");
+        return UsesPromptLookup();
+    }
+    return InitializeDraftModel(draftPath.c_str()) || UsesPromptLookup();
+}
+
+bool SpeculativeDecoder::InitializeDraftModel(const char* model_path) {
+    if (g_draft_model != nullptr) return true;
+    if (!g_model || !g_ctx) {
+        LogLLM("SPEC: Main model/context must be loaded before the draft model.");
+        return false;
+    }
+
+    LogLLM("SPEC: Loading draft model from " + std::string(model_path));
+    llama_model_params model_params = llama_model_default_params();
+    model_params.n_gpu_layers = ConfigReader::g_Settings.DRAFT_GPU_LAYERS;
+
+    g_draft_model = llama_model_load_from_file(model_path, model_params);
+    if (g_draft_model == nullptr) {
+        LogLLM("SPEC: Failed to load draft model.");
+        return false;
+    }
+
+    if (!IsVocabCompatible(g_model, g_draft_model)) {
+        LogLLM("SPEC: Draft model is not compatible with the main model. Unloading.");
+        llama_model_free(g_draft_model);
+        g_draft_model = nullptr;
+        return false;
+    }
+
+    llama_context_params ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = llama_n_ctx(g_ctx);
+    ctx_params.n_batch = DRAFT_BATCH_SIZE;
+    ctx_params.n_ubatch = 256;
+
+    g_draft_ctx = llama_init_from_model(g_draft_model, ctx_params);
+    if (g_draft_ctx == nullptr) {
+        LogLLM("SPEC: llama_init_from_model failed for draft model.");
+        llama_model_free(g_draft_model);
+        g_draft_model = nullptr;
+        return false;
+    }
+
+    g_draft_batch = llama_batch_init(DRAFT_BATCH_SIZE, 0, 1);
+    g_draft_batch_ready = true;
+
+    g_draft_depth = (ConfigReader::g_Settings.Draft_Min_Tokens + ConfigReader::g_Settings.Draft_Max_Tokens) / 2;
+    LogLLM("SPEC: Draft model ready. Depth " + std::to_string(g_draft_depth) +
+        " (range " + std::to_string(ConfigReader::g_Settings.Draft_Min_Tokens) + "-" +
+        std::to_string(ConfigReader::g_Settings.Draft_Max_Tokens) + ")");
+    return true;
+}
+
+void SpeculativeDecoder::ShutdownDraftModel() {
+    g_draft_active = false;
+    if (g_draft_batch_ready) {
+        llama_batch_free(g_draft_batch);
+        g_draft_batch_ready = false;
+    }
+    if (g_draft_ctx) {
+        llama_free(g_draft_ctx);
+        g_draft_ctx = nullptr;
+    }
+    if (g_draft_model) {
+        llama_model_free(g_draft_model);
+        g_draft_model = nullptr;
+        LogLLM("SPEC: Draft model freed.");
+    }
+}
+
+bool SpeculativeDecoder::IsEnabled() {
+    return UsesPromptLookup() || (UsesDraftModel() && g_draft_ctx != nullptr);
+}
+
+int SpeculativeDecoder::GetDraftDepth() {
+    return g_draft_depth;
+}
+
+int SpeculativeDecoder::GetMaxProposal() {
+    const auto& s = ConfigReader::g_Settings;
+    int maxTokens = 0;
+    if (UsesDraftModel()) maxTokens = std::max(maxTokens, s.Draft_Max_Tokens);
+    if (UsesPromptLookup()) maxTokens = std::max(maxTokens, s.Lookup_Max_Tokens);
+    return maxTokens;
+}
+
+// --- PER GENERATION ---
+bool SpeculativeDecoder::BeginGeneration(const std::vector<llama_token>& promptTokens) {
+    g_lookup_active = false;
+    g_draft_active = false;
+    g_last_source = ProposalSource::NONE;
+    if (promptTokens.empty()) return false;
+
+    if (UsesPromptLookup()) {
+        const auto& s = ConfigReader::g_Settings;
+        g_lookup_index.assign(s.Lookup_Ngram_Max - s.Lookup_Ngram_Min + 1, {});
+        g_lookup_indexed = 0;
+        IndexNgrams(promptTokens);
+        g_lookup_active = true;
+    }
+
+    if (UsesDraftModel() && g_draft_ctx) {
+        llama_memory_clear(llama_get_memory(g_draft_ctx), true);
+        g_draft_n_past = 0;
+        g_proposal_base = 0;
+        g_proposal_decoded = 0;
+
+        if (DecodeDraftRange(promptTokens, 0, (int32_t)promptTokens.size())) {
+            g_draft_n_past = (int32_t)promptTokens.size();
+            g_draft_active = true;
+        }
+        else {
+            LogLLM("SPEC: Draft prefill failed. No draft model for this turn.");
+        }
+    }
+    return g_lookup_active || g_draft_active;
+}
+
+int SpeculativeDecoder::ProposeTokens(const std::vector<llama_token>& history, int maxTokens, std::vector<llama_token>& outDraft) {
+    outDraft.clear();
+    g_last_source = ProposalSource::NONE;
+    if (history.empty() || maxTokens <= 0) return 0;
+
+    // Prompt lookup first, it only costs a few hash probes
+    if (g_lookup_active) {
+        IndexNgrams(history);
+        if (ProposeFromLookup(history, std::min(g_lookup_depth, maxTokens), outDraft) > 0) {
+            g_last_source = ProposalSource::LOOKUP;
+            return (int)outDraft.size();
+        }
+    }
+    if (!g_draft_active) return 0;
+
+    int depth = std::min(g_draft_depth, maxTokens);
+    if (depth <= 0) return 0;
+
+    // 1. Catch up on everything the draft hasn't seen (accepted tokens + the pending one)
+    int32_t n_hist = (int32_t)history.size();
+    if (g_draft_n_past < n_hist) {
+        if (!DecodeDraftRange(history, g_draft_n_past, n_hist)) return 0;
+        g_draft_n_past = n_hist;
+    }
+    g_proposal_base = g_draft_n_past;
+    g_proposal_decoded = 0;
+
+    // 2. Greedy roll-out
+    const llama_vocab* vocab = llama_model_get_vocab(g_draft_model);
+    const int32_t n_vocab = llama_vocab_n_tokens(vocab);
+    const int32_t n_main_vocab = llama_vocab_n_tokens(llama_model_get_vocab(g_model));
+
+    for (int i = 0; i < depth; ++i) {
+        float* logits = llama_get_logits_ith(g_draft_ctx, -1);
+        if (!logits) break;
+
+        llama_token id = ArgMaxToken(logits, n_vocab);
+        if (id >= n_main_vocab || llama_vocab_is_eog(vocab, id)) break; // let the main model end the reply
+        outDraft.push_back(id);
+
+        if (i + 1 == depth) break; // the last guess never needs its own logits
+
+        g_draft_batch.n_tokens = 1;
+        g_draft_batch.token[0] = id;
+        g_draft_batch.pos[0] = g_proposal_base + i;
+        g_draft_batch.n_seq_id[0] = 1;
+        g_draft_batch.seq_id[0][0] = 0;
+        g_draft_batch.logits[0] = true;
+        if (llama_decode(g_draft_ctx, g_draft_batch) != 0) break;
+        g_proposal_decoded++;
+    }
+    g_draft_n_past = g_proposal_base + g_proposal_decoded;
+    if (!outDraft.empty()) g_last_source = ProposalSource::DRAFT_MODEL;
+    return (int)outDraft.size();
+}
+
+void SpeculativeDecoder::OnVerified(int proposed, int accepted, SpecTurnStats& stats) {
+    stats.proposed += proposed;
+    stats.accepted += accepted;
+    if (proposed <= 0) return;
+
+    const auto& s = ConfigReader::g_Settings;
+    if (g_last_source == ProposalSource::LOOKUP) {
+        stats.lookupProposed += proposed;
+        stats.lookupAccepted += accepted;
+        AdaptDepth(g_lookup_depth, 1, s.Lookup_Max_Tokens, proposed, accepted);
+    }
+    else if (g_last_source == ProposalSource::DRAFT_MODEL && g_draft_ctx) {
+        // Drop rejected guesses from the draft KV. Accepted-but-undecoded ones are caught up next time.
+        int32_t keep = g_proposal_base + std::min(accepted, g_proposal_decoded);
+        llama_memory_seq_rm(llama_get_memory(g_draft_ctx), 0, keep, -1);
+        g_draft_n_past = keep;
+        AdaptDepth(g_draft_depth, s.Draft_Min_Tokens, s.Draft_Max_Tokens, proposed, accepted);
+    }
+    g_last_source = ProposalSource::NONE;
+}
+
+void SpeculativeDecoder::EndGeneration(const SpecTurnStats& stats, int generated, double seconds) {
+    if (stats.targetDecodes <= 0) return;
+
+    float acceptRate = (stats.proposed > 0) ? (100.0f * stats.accepted / stats.proposed) : 0.0f;
+    float tokensPerPass = (float)generated / (float)stats.targetDecodes;
+    float turnTPS = (seconds > 0.001) ? (float)(generated / seconds) : 0.0f;
+
+    LogLLM("SPEC: Turn done. Proposed " + std::to_string(stats.proposed) +
+        ", accepted " + std::to_string(stats.accepted) + " (" + std::to_string(acceptRate) + "%)" +
+        ", lookup " + std::to_string(stats.lookupAccepted) + "/" + std::to_string(stats.lookupProposed) +
+        ", " + std::to_string(generated) + " tokens in " + std::to_string(stats.targetDecodes) + " main passes" +
+        " (speedup x" + std::to_string(tokensPerPass) + ")" +
+        ", " + std::to_string(turnTPS) + " tok/s vs avg " + std::to_string(g_current_tps) +
+        ", next depth " + std::to_string(g_draft_depth) + " draft / " + std::to_string(g_lookup_depth) + " lookup");
+}
@@ -0,0 +1,41 @@
+#pragma once
+// SpeculativeDecoding.h
+#include <string>
+#include <vector>
+#include "llama.h"
+
+// Per-turn numbers, logged once the reply is finished
+struct SpecTurnStats {
+    int proposed = 0;       // draft tokens offered to the main model (all sources)
+    int accepted = 0;       // draft tokens the main model agreed with (all sources)
+    int lookupProposed = 0; // ... of which came from the prompt n-gram lookup
+    int lookupAccepted = 0;
+    int targetDecodes = 0;  // llama_decode calls on the main model (excl. prompt)
+};
+
+class SpeculativeDecoder {
+public:
+    // --- LIFECYCLE ---
+    // SPECULATIVE_DECODING: 0=Off, 1=Draft Model, 2=Prompt Lookup, 3=Prompt Lookup + Draft Model.
+    // Resolves DRAFT_MODEL_PATH / DRAFT_MODEL_ALT_NAME like the main model. Needs g_ctx.
+    static bool InitializeFromConfig(const std::string& rootPath);
+    static bool InitializeDraftModel(const char* model_path);
+    static void ShutdownDraftModel();
+    static bool IsEnabled();
+
+    // --- PER GENERATION ---
+    // Feeds the prompt into the draft context and builds the prompt n-gram index.
+    // Returns false if speculation can't run this turn.
+    static bool BeginGeneration(const std::vector<llama_token>& promptTokens);
+
+    // Proposes up to min(depth, maxTokens) tokens that continue 'history'.
+    // Prompt lookup is tried first (free), the draft model only if no n-gram matched.
+    static int ProposeTokens(const std::vector<llama_token>& history, int maxTokens, std::vector<llama_token>& outDraft);
+
+    // Reports how many proposed tokens survived verification. Rolls back the draft KV and adapts depth.
+    static void OnVerified(int proposed, int accepted, SpecTurnStats& stats);
+
+    static void EndGeneration(const SpecTurnStats& stats, int generated, double seconds);
+    static int GetDraftDepth();
+    static int GetMaxProposal(); // upper bound for batch sizing
+};
@@ -0,0 +1,256 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include "main.h"
+#include "SttBench.h"
+
+// ------------------------------------------------------------
+// STT BENCH
+// Configuration 0 is the full window (audio_ctx 0), the rest are the
+// margins from the INI. The first clip is decoded once untimed so model
+// loading and allocations don't end up in the first measurement.
+// WER = word edit distance / reference words over the whole corpus, after
+// lower-casing and dropping punctuation.
+// ------------------------------------------------------------
+
+// --- STATE ---
+struct BenchClip {
+    std::string name;
+    std::vector<float> pcm;    // 16 kHz mono
+    std::vector<std::string> reference;
+};
+
+struct BenchConfig {
+    int marginMs = -1;         // -1 = full window
+    double totalMs = 0.0;
+    int64_t wordErrors = 0;
+    int64_t referenceWords = 0;
+    int clips = 0;
+};
+
+static std::atomic<bool> g_running{ false };
+static std::mutex g_summary_mutex;
+static std::string g_summary;
+
+// --- HELPERS ---
+template <typename T> static bool ReadPod(std::ifstream& f, T& out) {
+    return (bool)f.read(reinterpret_cast<char*>(&out), sizeof(T));
+}
+
+// PCM16 or float32 RIFF, any channel count and rate. Downmixed and linearly resampled to 16 kHz.
+static bool LoadWav(const std::string& path, std::vector<float>& out) {
+    std::ifstream f(path, std::ios::binary);
+    char riff[4], wave[4];
+    uint32_t riffSize = 0;
+    if (!f.read(riff, 4) || !ReadPod(f, riffSize) || !f.read(wave, 4)) return false;
+    if (memcmp(riff, "RIFF", 4) != 0 || memcmp(wave, "WAVE", 4) != 0) return false;
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    std::vector<char> data;
+    char id[4];
+    uint32_t size = 0;
+    while (f.read(id, 4) && ReadPod(f, size)) {
+        if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+            uint32_t byteRate = 0;
+            uint16_t blockAlign = 0;
+            ReadPod(f, format); ReadPod(f, channels); ReadPod(f, rate);
+            ReadPod(f, byteRate); ReadPod(f, blockAlign); ReadPod(f, bits);
+            if (format == 0xFFFE && size >= 26) { // WAVE_FORMAT_EXTENSIBLE: the real format opens the sub-format GUID
+                uint16_t cbSize = 0, validBits = 0;
+                uint32_t channelMask = 0;
+                ReadPod(f, cbSize); ReadPod(f, validBits); ReadPod(f, channelMask); ReadPod(f, format);
+                f.seekg(size - 26, std::ios::cur);
+            }
+            else {
+                f.seekg(size - 16, std::ios::cur);
+            }
+        }
+        else if (memcmp(id, "data", 4) == 0) {
+            data.resize(size);
+            if (!f.read(data.data(), size)) data.resize((size_t)f.gcount());
+            break;
+        }
+        else {
+            f.seekg(size, std::ios::cur);
+        }
+        if (size & 1) f.seekg(1, std::ios::cur); // chunks are word aligned
+    }
+    if (channels == 0 || rate == 0 || data.empty()) return false;
+    bool pcm16 = (format == 1 && bits == 16);
+    bool float32 = (format == 3 && bits == 32);
+    if (!pcm16 && !float32) return false;
+
+    size_t frameBytes = (size_t)channels * (bits / 8);
+    size_t frames = data.size() / frameBytes;
+    std::vector<float> mono(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const char* frame = data.data() + i * frameBytes;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            if (pcm16) { int16_t s; memcpy(&s, frame + c * 2, 2); sum += s / 32768.0f; }
+            else { float s; memcpy(&s, frame + c * 4, 4); sum += s; }
+        }
+        mono[i] = sum / channels;
+    }
+
+    if (rate == WHISPER_SAMPLE_RATE) { out.swap(mono); return true; }
+    size_t n = (size_t)((double)frames * WHISPER_SAMPLE_RATE / rate);
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        double pos = (double)i * rate / WHISPER_SAMPLE_RATE;
+        size_t a = std::min((size_t)pos, frames - 1);
+        size_t b = std::min(a + 1, frames - 1);
+        float t = (float)(pos - a);
+        out[i] = mono[a] * (1.0f - t) + mono[b] * t;
+    }
+    return true;
+}
+
+static std::vector<std::string> NormalizeWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (char ch : text) {
+        unsigned char c = (unsigned char)ch;
+        if (std::isalnum(c) || c == '\'' || c >= 0x80) word += (char)std::tolower(c);
+        else if (!word.empty()) { words.push_back(word); word.clear(); }
+    }
+    if (!word.empty()) words.push_back(word);
+    return words;
+}
+
+static int64_t WordDistance(const std::vector<std::string>& ref, const std::vector<std::string>& hyp) {
+    std::vector<int64_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) prev[j] = (int64_t)j;
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        cur[0] = (int64_t)i;
+        for (size_t j = 1; j <= hyp.size(); ++j) {
+            int64_t sub = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+            cur[j] = std::min({ sub, prev[j] + 1, cur[j - 1] + 1 });
+        }
+        prev.swap(cur);
+    }
+    return prev[hyp.size()];
+}
+
+static std::vector<BenchClip> LoadCorpus(const std::string& dir) {
+    std::vector<BenchClip> clips;
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA((dir + "*.wav").c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) return clips;
+    do {
+        std::string file = fd.cFileName;
+        std::string base = file.substr(0, file.length() - 4);
+        std::ifstream ref(dir + base + ".txt");
+        if (!ref) { LogA("SttBench: " + file + " has no " + base + ".txt, skipped."); continue; }
+        std::stringstream ss;
+        ss << ref.rdbuf();
+
+        BenchClip clip;
+        clip.name = file;
+        clip.reference = NormalizeWords(ss.str());
+        if (!LoadWav(dir + file, clip.pcm) || clip.pcm.empty()) { LogA("SttBench: " + file + " is not PCM16/float WAV, skipped."); continue; }
+        clips.push_back(std::move(clip));
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+    std::sort(clips.begin(), clips.end(), [](const BenchClip& a, const BenchClip& b) { return a.name < b.name; });
+    return clips;
+}
+
+static std::string CsvQuote(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) { if (c == '"') out += '"'; out += c; }
+    return out + "\"";
+}
+
+static void RunBench(const std::string& dir) {
+    TRACE_SCOPE("SttBench");
+    // Cleared on every way out, a throwing run must not block the next one
+    struct RunningGuard { ~RunningGuard() { g_running = false; } } runningGuard;
+
+    std::vector<BenchClip> clips = LoadCorpus(dir);
+    if (clips.empty()) {
+        LogA("SttBench: No <name>.wav + <name>.txt pairs in " + dir);
+        return;
+    }
+
+    std::vector<BenchConfig> configs(1);
+    for (const std::string& m : ConfigReader::SplitString(ConfigReader::g_Settings.StT_Bench_Margins, ',')) {
+        try { BenchConfig c; c.marginMs = std::max(0, std::stoi(m)); configs.push_back(c); }
+        catch (...) {}
+    }
+
+    std::ofstream csv(dir + "stt_bench.csv", std::ios::trunc);
+    csv << "file,seconds,margin_ms,audio_ctx,ms,word_errors,reference_words,transcript\n";
+
+    std::vector<SttSegment> segments;
+    RunWhisper(clips[0].pcm.data(), clips[0].pcm.size(), segments, 0, true); // warm-up
+    double audioSec = 0.0;
+    for (const BenchClip& clip : clips) {
+        double seconds = (double)clip.pcm.size() / WHISPER_SAMPLE_RATE;
+        audioSec += seconds;
+        for (BenchConfig& cfg : configs) {
+            int audioCtx = (cfg.marginMs < 0) ? 0 : WhisperAudioCtxFor(clip.pcm.size(), cfg.marginMs);
+            auto start = std::chrono::high_resolution_clock::now();
+            bool ok = RunWhisper(clip.pcm.data(), clip.pcm.size(), segments, audioCtx, true);
+            std::chrono::duration<double, std::milli> ms = std::chrono::high_resolution_clock::now() - start;
+
+            std::string text;
+            for (const auto& seg : segments) text += seg.text;
+            int64_t errors = ok ? WordDistance(clip.reference, NormalizeWords(text)) : (int64_t)clip.reference.size();
+            cfg.totalMs += ms.count();
+            cfg.wordErrors += errors;
+            cfg.referenceWords += (int64_t)clip.reference.size();
+            cfg.clips++;
+            csv << CsvQuote(clip.name) << "," << seconds << "," << cfg.marginMs << "," << audioCtx << "," << ms.count() << ","
+                << errors << "," << clip.reference.size() << "," << CsvQuote(text) << "\n";
+        }
+    }
+
+    const BenchConfig& full = configs[0];
+    std::ostringstream summary;
+    summary.precision(3);
+    for (const BenchConfig& cfg : configs) {
+        double wer = cfg.referenceWords ? 100.0 * cfg.wordErrors / cfg.referenceWords : 0.0;
+        double avgMs = cfg.totalMs / std::max(1, cfg.clips);
+        summary << (cfg.marginMs < 0 ? std::string("full window") : "margin " + std::to_string(cfg.marginMs) + " ms")
+            << ": WER " << wer << "%, " << avgMs << " ms/clip, x" << (cfg.totalMs > 0.0 ? full.totalMs / cfg.totalMs : 0.0)
+            << " vs full\n";
+    }
+    LogA("SttBench: " + std::to_string(clips.size()) + " clips, " + std::to_string((int)audioSec) + " s of audio\n" + summary.str());
+    {
+        std::lock_guard<std::mutex> lock(g_summary_mutex);
+        g_summary = summary.str();
+    }
+}
+
+// --- PUBLIC ---
+bool SttBench::Start(const std::string& corpusDir) {
+    if (g_whisper_ctx == nullptr || corpusDir.empty()) return false;
+    if (g_running.exchange(true)) return false;
+
+    std::string dir = corpusDir;
+    if (dir.back() != '\\' && dir.back() != '/') dir += '\\';
+    LogA("SttBench: Starting on " + dir);
+    TaskPool::Submit("SttBench", TaskPriority::LOW, Workload::STT, [dir]() { RunBench(dir); });
+    return true;
+}
+
+bool SttBench::IsRunning() {
+    return g_running;
+}
+
+std::string SttBench::GetSummary() {
+    std::lock_guard<std::mutex> lock(g_summary_mutex);
+    return g_summary;
+}
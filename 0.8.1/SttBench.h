@@ -0,0 +1,18 @@
+#pragma once
+// SttBench.h
+#include <string>
+
+// In-game accuracy/latency check for the whisper encoder window, run on a recorded corpus
+// instead of the microphone (there is no standalone build). Every <name>.wav in the
+// corpus folder that has a <name>.txt reference next to it is transcribed with the full
+// 30 s window and once per margin in stt_bench_margins_ms. Per-file rows go to
+// <corpus>stt_bench.csv, word error rate and latency per configuration to the STT log.
+class SttBench {
+public:
+    // Runs on the task pool (LOW priority) on the background whisper states, timings are only
+    // clean outside of conversations. False if whisper is not loaded or a run is already going.
+    static bool Start(const std::string& corpusDir);
+    static bool IsRunning();
+    // One line per configuration of the last finished run, empty before that
+    static std::string GetSummary();
+};
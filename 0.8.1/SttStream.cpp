@@ -0,0 +1,165 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <mutex>
+#include "main.h"
+#include "SttStream.h"
+
+// ------------------------------------------------------------
+// STT STREAM
+// Each window starts at the committed sample offset and ends at the live
+// edge. All segments but the last one that end at least STABLE_MARGIN_MS
+// before the edge are committed: whisper rarely changes its mind about
+// speech it has heard the end of. The rest is shown as a guess and decoded
+// again with the next window.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static const size_t SAMPLES_PER_MS = WHISPER_SAMPLE_RATE / 1000;
+static const int64_t STABLE_MARGIN_MS = 1000;
+static const size_t MIN_WINDOW_SAMPLES = 1000 * SAMPLES_PER_MS; // less than a second is not worth a decode
+static const size_t MIN_TAIL_SAMPLES = 100 * SAMPLES_PER_MS;
+static const int WINDOW_WAIT_MS = 10000;
+
+static std::mutex g_mutex;           // guards everything below
+static uint64_t g_generation = 0;    // per recording; results of older ones are dropped
+static uint64_t g_ticket = 0;
+static size_t g_committed_samples = 0;
+static std::string g_committed_text;
+static std::string g_tentative_text;
+static TaskHandle<void> g_window;    // window decode in flight
+static size_t g_last_window_end = 0; // live edge of the last window that was started
+
+// --- HELPERS ---
+// base: committed samples when the window was cut, offset: where the window starts (after leading silence)
+static void DecodeWindow(const std::vector<float>& window, size_t base, size_t offset, uint64_t generation) {
+    TRACE_SCOPE("Whisper Window");
+    std::vector<SttSegment> segments;
+    if (!RunWhisper(window.data(), window.size(), segments)) return;
+    const int64_t windowMs = (int64_t)(window.size() / SAMPLES_PER_MS);
+
+    std::string partial;
+    size_t committedChars = 0;
+    uint64_t ticket = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (generation != g_generation || base != g_committed_samples) return;
+
+        size_t i = 0;
+        for (; i + 1 < segments.size(); ++i) {
+            if (segments[i].t1_ms > windowMs - STABLE_MARGIN_MS) break;
+            g_committed_text += segments[i].text;
+            g_committed_samples = std::min(offset + (size_t)segments[i].t1_ms * SAMPLES_PER_MS, offset + window.size());
+        }
+        g_tentative_text.clear();
+        for (; i < segments.size(); ++i) g_tentative_text += segments[i].text;
+
+        partial = g_committed_text + g_tentative_text;
+        committedChars = g_committed_text.length();
+        ticket = g_ticket;
+    }
+    EventQueue::Post(EventType::TRANSCRIPT_PARTIAL, ticket, partial, 0, (int64_t)committedChars);
+}
+
+// --- PUBLIC ---
+bool SttStream::IsEnabled() {
+    return ConfigReader::g_Settings.StT_Streaming != 0 && g_whisper_ctx != nullptr;
+}
+
+void SttStream::Begin(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_generation++;
+    g_ticket = ticket;
+    g_committed_samples = 0;
+    g_committed_text.clear();
+    g_tentative_text.clear();
+    g_window.Cancel();
+    g_window.Reset();
+    g_last_window_end = 0;
+}
+
+void SttStream::Update(const std::vector<float>& recording) {
+    if (!IsEnabled()) return;
+    const size_t end = recording.size();
+    const size_t step = (size_t)std::max(200, ConfigReader::g_Settings.StT_Stream_Step_Ms) * SAMPLES_PER_MS;
+    if (end < g_last_window_end + step) return;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_window.Valid() && !g_window.IsReady()) return; // one window at a time
+    if (end < g_committed_samples + MIN_WINDOW_SAMPLES) return;
+
+    // Nothing to decode until the uncommitted part holds speech
+    g_last_window_end = end;
+    const size_t base = g_committed_samples;
+    size_t speechBegin = 0, speechEnd = end - base;
+    if (Vad::IsEnabled() && !Vad::FindSpeech(recording.data() + base, end - base, speechBegin, speechEnd)) return;
+
+    // Only the uncommitted part is copied; the recording keeps growing on this thread
+    const size_t offset = base + speechBegin;
+    std::vector<float> window(recording.begin() + offset, recording.end());
+    const uint64_t generation = g_generation;
+    g_window = TaskPool::Submit("Whisper Window", TaskPriority::NORMAL, Workload::STT,
+        [window = std::move(window), base, offset, generation]() { DecodeWindow(window, base, offset, generation); });
+}
+
+void SttStream::Cancel() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_generation++;
+    g_ticket = 0;
+    g_window.Cancel();
+    g_window.Reset();
+}
+
+std::string SttStream::Finish(const std::vector<float>& recording) {
+    TRACE_SCOPE("Whisper Tail");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // A queued window is dropped, a running one may still commit something
+    TaskHandle<void> window;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        window = g_window;
+    }
+    if (window.Valid() && !window.Cancel()) window.WaitFor(WINDOW_WAIT_MS);
+
+    size_t from = 0;
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_generation++; // nothing may commit behind our back now
+        from = std::min(g_committed_samples, recording.size());
+        text = g_committed_text;
+    }
+
+    // Silence at the end (or a tail without speech) never reaches whisper
+    size_t tailBegin = 0, tailEnd = recording.size() - from;
+    bool tailHasSpeech = !Vad::IsEnabled() || Vad::FindSpeech(recording.data() + from, recording.size() - from, tailBegin, tailEnd);
+    if (!tailHasSpeech && text.empty()) {
+        LogA("SttStream: No speech detected, whisper skipped.");
+        Metrics::Increment(MetricCounter::VAD_REJECTED);
+    }
+    if (tailHasSpeech && tailEnd >= tailBegin + MIN_TAIL_SAMPLES) {
+        std::vector<SttSegment> segments;
+        if (RunWhisper(recording.data() + from + tailBegin, tailEnd - tailBegin, segments)) {
+            for (const auto& seg : segments) text += seg.text;
+        }
+        else {
+            LogA("SttStream: FAILED - whisper_full failed on the tail.");
+        }
+    }
+
+    std::chrono::duration<double, std::milli> ms = std::chrono::high_resolution_clock::now() - start;
+    Metrics::Record(MetricHist::STT_MS, ms.count());
+    LogA("SttStream: " + std::to_string(from / SAMPLES_PER_MS) + " ms committed while recording, " +
+        std::to_string((recording.size() - from) / SAMPLES_PER_MS) + " ms decoded after release in " +
+        std::to_string((int)ms.count()) + " ms: " + text);
+    return text;
+}
+
+std::string SttStream::GetPartial() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_committed_text + g_tentative_text;
+}
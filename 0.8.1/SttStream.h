@@ -0,0 +1,29 @@
+#pragma once
+// SttStream.h
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Streaming transcription while push-to-talk is held. Every Stt_Stream_Step_Ms the audio
+// that is not committed yet is decoded on the task pool; segments that end well before
+// the live edge are committed and never decoded again. On release only the uncommitted
+// tail is left to decode.
+class SttStream {
+public:
+    // stt_streaming=1 and whisper is loaded
+    static bool IsEnabled();
+
+    // --- SCRIPT THREAD ---
+    // New recording; partial results are posted as TRANSCRIPT_PARTIAL with this ticket
+    static void Begin(uint64_t ticket);
+    // Every tick while recording. Starts the next window decode when one is due and none is running.
+    static void Update(const std::vector<float>& recording);
+    // The recording was thrown away. Results still running are dropped.
+    static void Cancel();
+
+    // --- ANY THREAD ---
+    // On the transcription task at release: decodes the uncommitted tail, returns the whole transcript
+    static std::string Finish(const std::vector<float>& recording);
+    // Committed text plus the current guess for the rest
+    static std::string GetPartial();
+};
@@ -0,0 +1,112 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <cmath>
+#include "main.h"
+#include "TargetPredictor.h"
+
+// ------------------------------------------------------------
+// TARGET PREDICTOR (conversation warm-up)
+// Scans a few times per second for the closest ped in front of the player
+// within MaxConversationRadius. Once the same ped stays the best guess for
+// STABLE_MS, its persona and name are resolved (the name is handed to the
+// conversation start, see TakeWarmName) and the system block from
+// AssembleSystemPrompt is submitted as a prefill-only BACKGROUND request.
+// The scheduler keeps it as a cached prefix for the real first turn.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static AHandle g_candidate = 0;        // best guess of the last scan
+static TimeMillis g_candidateSince = 0;
+static AHandle g_warmPed = 0;          // ped whose prompt is (being) prefilled
+static std::string g_warmName;
+static TimeMillis g_warmedAt = 0;
+static TimeMillis g_lastScan = 0;
+
+static const TimeMillis SCAN_INTERVAL_MS = 500;
+static const TimeMillis STABLE_MS = 1000;
+static const TimeMillis REWARM_MS = 60000; // time of day / memory may have changed
+static const float MIN_FACING = 0.3f;      // cos of the angle off the player's heading
+
+// --- HELPERS ---
+static bool IsInteractiveIdle() {
+    return g_convo_state == ConvoState::IDLE && g_input_state == InputState::IDLE && g_llm_state == InferenceState::IDLE;
+}
+
+// Same filter as the start trigger, a busy ped would be rejected there anyway
+static bool IsPedTalkable(AHandle ped, AHandle playerPed) {
+    return ped != playerPed && IsEntityValid(ped) && IsEntityLivingEntity(ped) && IsPedHuman(ped) &&
+        !IsEntityDead(ped) && !IsEntityInVehicle(ped) && !IsEntityInCombat(ped) && !IsEntityFleeing(ped);
+}
+
+// Closest talkable ped inside the view cone
+static AHandle FindLikelyTarget(AHandle playerPed) {
+    const float radius = ConfigReader::g_Settings.MaxConversationRadius;
+    AVec3 pos = GetEntityPosition(playerPed);
+    AVec3 fwd = GetEntityForwardVector(playerPed);
+
+    AHandle best = 0;
+    float bestDist = radius + 1.0f;
+    for (AHandle ped : GetNearbyPeds(pos, radius, 32)) {
+        if (!IsPedTalkable(ped, playerPed)) continue;
+        AVec3 p = GetEntityPosition(ped);
+        float dx = p.x - pos.x;
+        float dy = p.y - pos.y;
+        float dist = std::sqrt(dx * dx + dy * dy);
+        if (dist > 0.5f && (dx * fwd.x + dy * fwd.y) / dist < MIN_FACING) continue;
+        if (dist < bestDist) { bestDist = dist; best = ped; }
+    }
+    return best;
+}
+
+static void Warm(AHandle target, AHandle playerPed, TimeMillis now) {
+    if (target != g_warmPed) {
+        NpcPersona p = ConfigReader::GetPersona(target);
+        g_warmName = !p.inGameName.empty() ? p.inGameName : GenerateNpcName(p);
+        g_warmPed = target;
+    }
+    std::string prompt = AssembleSystemPrompt(target, playerPed, g_warmName);
+    if (prompt.empty()) return;
+
+    BatchScheduler::Prefill(prompt, GenPriority::BACKGROUND);
+    g_warmedAt = now;
+    LogLLM("PREDICT: Warming up " + g_warmName + " (AHandle " + std::to_string(target) + ")");
+}
+
+// --- API ---
+void TargetPredictor::Update() {
+    const auto& cfg = ConfigReader::g_Settings;
+    if (!cfg.Target_Prewarm || !cfg.Prefix_Cache) return;
+
+    TimeMillis now = GetTimeMs();
+    if (now - g_lastScan < SCAN_INTERVAL_MS) return;
+    g_lastScan = now;
+
+    if (!IsInteractiveIdle() || !IsGameInSafeMode() || !BatchScheduler::IsRunning()) {
+        g_candidate = 0;
+        return;
+    }
+
+    AHandle playerPed = GetPlayerHandle();
+    AHandle target = FindLikelyTarget(playerPed);
+    if (target != g_candidate) {
+        g_candidate = target;
+        g_candidateSince = now;
+        return;
+    }
+    if (target == 0 || now - g_candidateSince < STABLE_MS) return;
+    if (target == g_warmPed && now - g_warmedAt < REWARM_MS) return;
+    if (BatchScheduler::GetFreeSlots() < 2) return; // one slot stays free for the player
+    if (CpuGovernor::ThrottleBackground()) return;
+
+    Warm(target, playerPed, now);
+}
+
+bool TargetPredictor::TakeWarmName(AHandle ped, std::string& outName) {
+    if (ped == 0 || ped != g_warmPed || g_warmName.empty()) return false;
+    outName = g_warmName;
+    return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+// TargetPredictor.h
+#include <string>
+#include "AbstractTypes.h"
+
+// Guesses which ped the player is about to talk to (close, in front, held for a moment)
+// and prefills that ped's system prompt into a spare sequence, so the first reply
+// only has to decode the player's line.
+class TargetPredictor {
+public:
+    // Called once per script tick. Cheap when nothing is due.
+    static void Update();
+    // Name the warm prompt of 'ped' was built with. Reusing it keeps the real prompt identical.
+    static bool TakeWarmName(AHandle ped, std::string& outName);
+};
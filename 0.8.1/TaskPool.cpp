@@ -0,0 +1,239 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "main.h"
+#include "TaskPool.h"
+#include "ThreadExit.h"
+
+// ------------------------------------------------------------
+// TASK POOL
+// Every worker owns one mutex-guarded deque per priority. Submissions from
+// outside the pool are spread round robin, submissions from a task go to
+// the worker that runs it. Nothing here grows with the session: finished
+// tasks leave only their shared state, owned by whoever kept the handle.
+// With more than one worker, worker 0 only runs HIGH tasks, so a transcription
+// never waits behind a batch of long summaries.
+// ------------------------------------------------------------
+
+// --- STATE ---
+struct TaskItem {
+    std::shared_ptr<TaskControl> control;
+    Workload workload = Workload::BACKGROUND;
+    std::function<void(bool)> run;
+    std::chrono::steady_clock::time_point queuedAt;
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::deque<TaskItem> queues[(int)TaskPriority::COUNT];
+    std::thread thread;
+};
+
+static const int IDLE_WAIT_MS = 100;
+static const double SLOW_TASK_MS = 10000.0; // logged when a task took longer
+
+static std::vector<std::unique_ptr<Worker>> g_workers;
+static std::once_flag g_start_once;
+static std::mutex g_wake_mutex;
+static std::condition_variable g_wake_cv;
+static std::atomic<bool> g_running{ false };
+static std::atomic<int> g_alive{ 0 };
+static std::atomic<int> g_queued{ 0 };
+static std::atomic<int> g_queued_high{ 0 };
+static int g_reserved = -1; // worker kept free for HIGH tasks, -1 = none
+static std::atomic<int> g_busy{ 0 };
+static std::atomic<uint64_t> g_next_id{ 1 };
+static std::atomic<uint64_t> g_rr{ 0 };
+static std::atomic<uint64_t> g_completed{ 0 };
+static std::atomic<uint64_t> g_cancelled{ 0 };
+static std::atomic<uint64_t> g_failed{ 0 };
+static std::atomic<uint64_t> g_stolen{ 0 };
+static thread_local int t_worker = -1;
+
+// --- HELPERS ---
+static bool PopFrom(Worker& w, int prio, TaskItem& out) {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    auto& q = w.queues[prio];
+    if (q.empty()) return false;
+    out = std::move(q.front());
+    q.pop_front();
+    return true;
+}
+
+static int HighestPriorityFor(int self) {
+    return self == g_reserved ? (int)TaskPriority::HIGH : (int)TaskPriority::COUNT - 1;
+}
+
+// Highest priority first; within a priority the own queue before the others
+static bool FindTask(int self, TaskItem& out, int& outPrio) {
+    const int n = (int)g_workers.size();
+    for (int prio = 0; prio <= HighestPriorityFor(self); ++prio) {
+        outPrio = prio;
+        if (PopFrom(*g_workers[self], prio, out)) return true;
+        for (int k = 1; k < n; ++k) {
+            if (PopFrom(*g_workers[(self + k) % n], prio, out)) {
+                g_stolen++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void RunTask(TaskItem& item, Workload& applied) {
+    TaskControl& c = *item.control;
+    TaskStatus expected = TaskStatus::QUEUED;
+    if (!c.status.compare_exchange_strong(expected, TaskStatus::RUNNING)) {
+        item.run(false); // cancelled through its handle
+        g_cancelled++;
+        return;
+    }
+    if (item.workload != applied) {
+        CpuGovernor::ApplyToCurrentThread(item.workload);
+        applied = item.workload;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t traceStart = Tracer::NowUs();
+    g_busy++;
+    try {
+        item.run(true);
+        g_completed++;
+    }
+    catch (const std::exception& e) {
+        g_failed++;
+        Log("TASKPOOL: Task '" + std::string(c.name) + "' (" + std::to_string(c.id) + ") threw: " + e.what());
+    }
+    catch (...) {
+        g_failed++;
+        Log("TASKPOOL: Task '" + std::string(c.name) + "' (" + std::to_string(c.id) + ") threw an unknown exception.");
+    }
+    g_busy--;
+    c.status = TaskStatus::DONE;
+    Tracer::Complete(c.name, traceStart, Tracer::NowUs());
+
+    std::chrono::duration<double, std::milli> ran = std::chrono::steady_clock::now() - start;
+    std::chrono::duration<double, std::milli> waited = start - item.queuedAt;
+    if (ran.count() > SLOW_TASK_MS) {
+        LOG_WARN(Log, "TASKPOOL: Task '" + std::string(c.name) + "' ran " + std::to_string((int)ran.count()) + " ms (queued " +
+            std::to_string((int)waited.count()) + " ms).");
+    }
+}
+
+static void WorkerLoop(int self) {
+    t_worker = self;
+    Tracer::SetThreadName("Task Worker");
+    Workload applied = Workload::COUNT;
+    const bool reserved = self == g_reserved;
+    while (g_running) {
+        TaskItem item;
+        int prio = 0;
+        if (FindTask(self, item, prio)) {
+            g_queued--;
+            if (prio == (int)TaskPriority::HIGH) g_queued_high--;
+            RunTask(item, applied);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(g_wake_mutex);
+        g_wake_cv.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS), [reserved] {
+            return !g_running || (reserved ? g_queued_high > 0 : g_queued > 0);
+            });
+    }
+    g_alive--;
+}
+
+// --- LIFECYCLE ---
+void TaskPool::Start() {
+    std::call_once(g_start_once, [] {
+        int n = ConfigReader::g_Settings.Task_Pool_Threads;
+        if (n <= 0) n = 3;
+        n = std::min(n, 16);
+        for (int i = 0; i < n; ++i) g_workers.push_back(std::make_unique<Worker>());
+        g_reserved = n > 1 ? 0 : -1;
+        g_running = true;
+        g_alive = n;
+        for (int i = 0; i < n; ++i) g_workers[i]->thread = std::thread(WorkerLoop, i);
+        Log("TASKPOOL: Started " + std::to_string(n) + " workers" + (g_reserved >= 0 ? " (1 reserved for HIGH)." : "."));
+    });
+}
+
+void TaskPool::Shutdown() {
+    if (!g_running) return;
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_running = false;
+    }
+    g_wake_cv.notify_all();
+
+    // Resolve what never ran, so nobody waits on it forever
+    // Workers may still be decrementing for tasks they took, so subtract instead of zeroing
+    for (auto& w : g_workers) {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        for (int prio = 0; prio < (int)TaskPriority::COUNT; ++prio) {
+            auto& q = w->queues[prio];
+            for (auto& item : q) {
+                item.control->status = TaskStatus::CANCELLED;
+                item.run(false);
+                g_cancelled++;
+            }
+            g_queued -= (int)q.size();
+            if (prio == (int)TaskPriority::HIGH) g_queued_high -= (int)q.size();
+            q.clear();
+        }
+    }
+
+    WaitForThreadExit([] { return g_alive.load() == 0; }); // no join, see ThreadExit.h
+    if (g_alive > 0) Log("TASKPOOL: " + std::to_string(g_alive.load()) + " workers still busy at shutdown, detaching.");
+    for (auto& w : g_workers) if (w->thread.joinable()) w->thread.detach();
+}
+
+TaskPoolStats TaskPool::GetStats() {
+    TaskPoolStats s;
+    s.workers = (int)g_workers.size();
+    s.queued = g_queued;
+    s.running = g_busy;
+    s.completed = g_completed;
+    s.cancelled = g_cancelled;
+    s.failed = g_failed;
+    s.stolen = g_stolen;
+    return s;
+}
+
+// --- TASKS ---
+void TaskPool::Enqueue(std::shared_ptr<TaskControl> control, TaskPriority priority, Workload workload, std::function<void(bool)> run) {
+    Start();
+    control->id = g_next_id++;
+    if (!g_running) {
+        control->status = TaskStatus::CANCELLED;
+        run(false);
+        g_cancelled++;
+        return;
+    }
+
+    TaskItem item;
+    item.control = std::move(control);
+    item.workload = workload;
+    item.run = std::move(run);
+    item.queuedAt = std::chrono::steady_clock::now();
+
+    int target = (t_worker >= 0) ? t_worker : (int)(g_rr++ % g_workers.size());
+    {
+        // Counted before it becomes visible, a worker that takes it right away can't go below zero
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_queued++;
+        if (priority == TaskPriority::HIGH) g_queued_high++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_workers[target]->mutex);
+        g_workers[target]->queues[(int)priority].push_back(std::move(item));
+    }
+    g_wake_cv.notify_all(); // notify_one could pick the reserved worker for a LOW task
+}
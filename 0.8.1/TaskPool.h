@@ -0,0 +1,117 @@
+#pragma once
+// TaskPool.h
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "CpuGovernor.h"
+
+enum class TaskPriority : int { HIGH = 0, NORMAL = 1, LOW = 2, COUNT };
+enum class TaskStatus : int { QUEUED, RUNNING, DONE, CANCELLED };
+
+struct TaskPoolStats {
+    int workers = 0;
+    int queued = 0;
+    int running = 0;
+    uint64_t completed = 0;
+    uint64_t cancelled = 0;
+    uint64_t failed = 0;   // threw an exception
+    uint64_t stolen = 0;   // taken from another worker's queue
+};
+
+// Shared between a queued task and its handle
+struct TaskControl {
+    uint64_t id = 0;
+    const char* name = "";
+    std::atomic<TaskStatus> status{ TaskStatus::QUEUED };
+};
+
+// Result of TaskPool::Submit. Cheap to copy, empty by default.
+template <typename T>
+class TaskHandle {
+public:
+    TaskHandle() = default;
+    TaskHandle(std::shared_ptr<TaskControl> control, std::shared_future<T> future)
+        : m_control(std::move(control)), m_future(std::move(future)) {}
+
+    bool Valid() const { return m_future.valid(); }
+    bool IsReady() const { return Valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    bool WaitFor(int ms) const { return Valid() && m_future.wait_for(std::chrono::milliseconds(ms)) == std::future_status::ready; }
+    // Blocks. Rethrows what the task threw; a cancelled task yields T().
+    decltype(auto) Get() const { return m_future.get(); }
+    TaskStatus Status() const { return m_control ? m_control->status.load() : TaskStatus::DONE; }
+    uint64_t Id() const { return m_control ? m_control->id : 0; }
+    // Only succeeds while the task is still queued
+    bool Cancel() {
+        if (!m_control) return false;
+        TaskStatus expected = TaskStatus::QUEUED;
+        return m_control->status.compare_exchange_strong(expected, TaskStatus::CANCELLED);
+    }
+    void Reset() { m_control.reset(); m_future = std::shared_future<T>(); }
+
+private:
+    std::shared_ptr<TaskControl> m_control;
+    std::shared_future<T> m_future;
+};
+
+template <typename R> struct TaskCallback { using type = std::function<void(const R&)>; };
+template <> struct TaskCallback<void> { using type = std::function<void()>; };
+
+// Fixed set of worker threads with one deque per worker and priority. A worker takes
+// the highest priority task it can find, its own queue first, then steals from the others.
+// One worker (if there are several) is kept for HIGH tasks only.
+// Workers take on the CpuGovernor policy of the task's workload before running it.
+class TaskPool {
+public:
+    // --- LIFECYCLE ---
+    // Started on the first Submit with Task_Pool_Threads workers
+    static void Start();
+    // Drops queued tasks (handles resolve with T()), waits a little for running ones. Safe from DllMain.
+    static void Shutdown();
+    static TaskPoolStats GetStats();
+
+    // --- TASKS (thread safe) ---
+    // onComplete runs on the worker right after the task, not if it threw or was cancelled
+    template <typename F, typename R = std::invoke_result_t<F>>
+    static TaskHandle<R> Submit(const char* name, TaskPriority priority, Workload workload, F fn,
+        typename TaskCallback<R>::type onComplete = nullptr) {
+        auto control = std::make_shared<TaskControl>();
+        control->name = name;
+        auto promise = std::make_shared<std::promise<R>>();
+        std::shared_future<R> future = promise->get_future().share();
+
+        std::function<void(bool)> run = [promise, fn = std::move(fn), onComplete = std::move(onComplete)](bool execute) mutable {
+            if (!execute) { Cancelled(*promise); return; }
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    fn();
+                    promise->set_value();
+                    if (onComplete) onComplete();
+                }
+                else {
+                    R result = fn();
+                    promise->set_value(result);
+                    if (onComplete) onComplete(result);
+                }
+            }
+            catch (...) {
+                try { promise->set_exception(std::current_exception()); }
+                catch (...) {} // already satisfied, the callback threw
+                throw;
+            }
+        };
+        Enqueue(control, priority, workload, std::move(run));
+        return TaskHandle<R>(control, future);
+    }
+
+private:
+    static void Enqueue(std::shared_ptr<TaskControl> control, TaskPriority priority, Workload workload, std::function<void(bool)> run);
+    template <typename R> static void Cancelled(std::promise<R>& p) {
+        if constexpr (std::is_void_v<R>) p.set_value();
+        else p.set_value(R());
+    }
+};
@@ -0,0 +1,197 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
+#include <fstream>
+#include <memory>
+#include "main.h"
+#include "SharedData.h"
+#include "Tracer.h"
+
+// ------------------------------------------------------------
+// TRACER
+// Every thread appends to its own buffer (its mutex is only contended while
+// exporting). Export merges all buffers into one Chrome trace JSON file.
+// TTS runs in the audio DLL, so its synthesis and playback spans are derived
+// from the VoiceBridge state transitions seen by the game thread.
+// ------------------------------------------------------------
+
+// --- STATE ---
+struct TraceEvent {
+    const char* name;
+    char ph;          // X = complete, b/e = async begin/end, i = instant, M = metadata
+    int64_t ts;
+    int64_t dur;
+    uint64_t id;
+    const char* argName;
+    int64_t arg;
+};
+
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    uint32_t tid = 0;
+    const char* threadName = nullptr;
+};
+
+static const size_t MAX_EVENTS_PER_THREAD = 200000;
+static const TimeMillis EXPORT_TIMEOUT_MS = 20000;
+static const uint64_t AUDIO_SPAN_ID = 0xA0D10;
+
+std::atomic<bool> Tracer::g_Enabled{ false };
+
+static std::mutex g_registry_mutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+static thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+static const auto g_epoch = std::chrono::steady_clock::now();
+
+// Game thread only
+static std::string g_export_path;
+static TimeMillis g_export_requested = 0;
+static int g_last_audio_phase = 0;
+static uint64_t g_audio_job = 0;
+
+// --- HELPERS ---
+static ThreadBuffer& LocalBuffer() {
+    if (!t_buffer) {
+        t_buffer = std::make_shared<ThreadBuffer>();
+        t_buffer->tid = (uint32_t)GetCurrentThreadId();
+        t_buffer->events.reserve(1024);
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        g_buffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+}
+
+static void Push(const TraceEvent& e) {
+    ThreadBuffer& b = LocalBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    if (b.events.size() < MAX_EVENTS_PER_THREAD) b.events.push_back(e);
+}
+
+static void ClearAll() {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (auto& b : g_buffers) {
+        std::lock_guard<std::mutex> bl(b->mutex);
+        b->events.clear();
+    }
+}
+
+static bool ExportNow(const std::string& path) {
+    std::string out;
+    out.reserve(1 << 20);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    size_t count = 0;
+    char line[512];
+
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (auto& b : g_buffers) {
+        std::lock_guard<std::mutex> bl(b->mutex);
+        if (b->threadName) {
+            snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", b->tid, b->threadName);
+            out += line;
+            first = false;
+        }
+        for (const auto& e : b->events) {
+            int n = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"kkamel\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u",
+                first ? "" : ",\n", e.name, e.ph, (long long)e.ts, b->tid);
+            if (e.ph == 'X') n += snprintf(line + n, sizeof(line) - n, ",\"dur\":%lld", (long long)e.dur);
+            if (e.ph == 'b' || e.ph == 'e') n += snprintf(line + n, sizeof(line) - n, ",\"id\":\"0x%llx\"", (unsigned long long)e.id);
+            if (e.ph == 'i') n += snprintf(line + n, sizeof(line) - n, ",\"s\":\"g\"");
+            if (e.argName) n += snprintf(line + n, sizeof(line) - n, ",\"args\":{\"%s\":%lld}", e.argName, (long long)e.arg);
+            snprintf(line + n, sizeof(line) - n, "}");
+            out += line;
+            first = false;
+            count++;
+        }
+        b->events.clear();
+    }
+    out += "\n]}\n";
+
+    std::ofstream f(path, std::ios::trunc | std::ios::binary);
+    if (!f) {
+        Log("TRACE: Could not write " + path);
+        return false;
+    }
+    f << out;
+    Log("TRACE: Wrote " + std::to_string(count) + " events to " + path);
+    return true;
+}
+
+// --- EVENTS ---
+int64_t Tracer::NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void Tracer::Complete(const char* name, int64_t startUs, int64_t endUs, const char* argName, int64_t argValue) {
+    if (!IsEnabled()) return;
+    Push({ name, 'X', startUs, endUs - startUs, 0, argName, argValue });
+}
+
+void Tracer::AsyncBegin(const char* name, uint64_t id) {
+    if (!IsEnabled()) return;
+    Push({ name, 'b', NowUs(), 0, id, nullptr, 0 });
+}
+
+void Tracer::AsyncEnd(const char* name, uint64_t id) {
+    if (!IsEnabled()) return;
+    Push({ name, 'e', NowUs(), 0, id, nullptr, 0 });
+}
+
+void Tracer::Instant(const char* name) {
+    if (!IsEnabled()) return;
+    Push({ name, 'i', NowUs(), 0, 0, nullptr, 0 });
+}
+
+void Tracer::SetThreadName(const char* name) {
+    ThreadBuffer& b = LocalBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.threadName = name;
+}
+
+// --- SESSION ---
+void Tracer::BeginSession() {
+    g_Enabled = ConfigReader::g_Settings.Trace_Enabled != 0;
+    if (!g_export_path.empty()) {
+        ExportNow(g_export_path);
+        g_export_path.clear();
+    }
+    ClearAll();
+}
+
+void Tracer::EndSession(const std::string& path) {
+    if (!IsEnabled()) return;
+    g_export_path = path;
+    g_export_requested = GetTimeMs();
+}
+
+void Tracer::Update(int audioState) {
+    if (!IsEnabled()) return;
+
+    // 0 = idle, 1 = queued/synthesizing, 2 = playing
+    const int phase = AudioPhase(audioState);
+    if (phase != g_last_audio_phase) {
+        if (g_last_audio_phase == 1) AsyncEnd("TTS Synthesis", AUDIO_SPAN_ID + g_audio_job);
+        if (g_last_audio_phase == 2) AsyncEnd("TTS Playback", AUDIO_SPAN_ID + g_audio_job);
+        if (phase == 1) {
+            g_audio_job++;
+            AsyncBegin("TTS Synthesis", AUDIO_SPAN_ID + g_audio_job);
+        }
+        else if (phase == 2) {
+            Instant("Playback Start");
+            AsyncBegin("TTS Playback", AUDIO_SPAN_ID + g_audio_job);
+        }
+        g_last_audio_phase = phase;
+    }
+
+    if (!g_export_path.empty()) {
+        if (phase == 0 || GetTimeMs() - g_export_requested > EXPORT_TIMEOUT_MS) {
+            ExportNow(g_export_path);
+            g_export_path.clear();
+        }
+    }
+}
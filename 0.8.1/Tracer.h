@@ -0,0 +1,49 @@
+#pragma once
+// Tracer.h
+#include <string>
+#include <cstdint>
+#include <atomic>
+
+// Pipeline spans in Chrome trace format (chrome://tracing, ui.perfetto.dev).
+// Off unless trace_pipeline=1. Each player conversation is one session and one file.
+class Tracer {
+public:
+    static bool IsEnabled() { return g_Enabled.load(std::memory_order_relaxed); }
+    static int64_t NowUs();
+
+    // --- EVENTS (thread safe, no-ops while disabled) ---
+    // name must be a string literal
+    static void Complete(const char* name, int64_t startUs, int64_t endUs, const char* argName = nullptr, int64_t argValue = 0);
+    // Spans that start and end on different threads or frames. id pairs begin and end.
+    static void AsyncBegin(const char* name, uint64_t id);
+    static void AsyncEnd(const char* name, uint64_t id);
+    static void Instant(const char* name);
+    static void SetThreadName(const char* name);
+
+    // --- SESSION (game thread) ---
+    // Drops old events (exports a pending session first)
+    static void BeginSession();
+    // Exports once TTS playback of the last line is over (or after a timeout)
+    static void EndSession(const std::string& path);
+    // Called once per script tick with the VoiceBridge job state (AudioJobState as int, -1 = no bridge).
+    // Turns its transitions into TTS synthesis / playback spans and runs pending exports.
+    static void Update(int audioState);
+
+    static std::atomic<bool> g_Enabled;
+};
+
+// Complete event for the enclosing scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : m_name(name), m_start(Tracer::IsEnabled() ? Tracer::NowUs() : -1) {}
+    ~TraceScope() { if (m_start >= 0) Tracer::Complete(m_name, m_start, Tracer::NowUs()); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+#define KK_TRACE_CAT2(a, b) a##b
+#define KK_TRACE_CAT(a, b) KK_TRACE_CAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope KK_TRACE_CAT(_traceScope, __LINE__)(name)
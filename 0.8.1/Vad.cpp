@@ -0,0 +1,176 @@
+#include "AbstractCalls.h"
+using namespace AbstractGame;
+using namespace AbstractTypes;
+
+#define NOMINMAX
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "main.h"
+#include "Vad.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VAD_SSE2 1
+#endif
+
+// ------------------------------------------------------------
+// VAD
+// Per frame: level in dBFS and zero-crossing rate, four samples at a time.
+// Clips use a floor from their own quietest frames (capped, so a clip that
+// is speech from start to end still passes). The open-mic stream tracks the
+// floor continuously: it follows the level down at once and creeps up slowly.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static const int FRAME = WHISPER_SAMPLE_RATE / 50; // 20 ms
+static const int FRAME_MS = 20;
+static const float FLOOR_CAP_DB = -45.0f;   // a floor above this is speech, not noise
+static const float FLOOR_RISE_DB = 0.02f;   // per frame (1 dB/s)
+static const float HISS_ZCR = 0.35f;        // hiss and fans cross zero on nearly every other sample
+static const float LOUD_MARGIN_DB = 6.0f;   // this far above threshold the ZCR is not checked
+static const int START_FRAMES = 3;          // speech frames in a row that open a turn
+
+struct FrameStats {
+    float db;
+    float zcr;
+};
+
+static float g_floor_db = -60.0f;
+static bool g_in_speech = false;
+static int g_speech_run = 0;
+static int g_silence_ms = 0;
+static float g_carry[FRAME];
+static int g_carry_n = 0;
+
+// --- HELPERS ---
+static FrameStats Measure(const float* x, int n) {
+    float energy = 0.0f;
+    int crossings = 0;
+    int i = 0;
+#ifdef VAD_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 < n; i += 4) {
+        __m128 a = _mm_loadu_ps(x + i);
+        __m128 b = _mm_loadu_ps(x + i + 1);
+        acc = _mm_add_ps(acc, _mm_mul_ps(a, a));
+        int signs = _mm_movemask_ps(_mm_xor_ps(a, b)); // sign bit differs = crossing
+        crossings += (signs & 1) + ((signs >> 1) & 1) + ((signs >> 2) & 1) + ((signs >> 3) & 1);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    energy = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; ++i) {
+        energy += x[i] * x[i];
+        if (i + 1 < n && ((x[i] < 0.0f) != (x[i + 1] < 0.0f))) crossings++;
+    }
+    FrameStats s;
+    s.db = 10.0f * std::log10(energy / (float)std::max(1, n) + 1e-10f);
+    s.zcr = (float)crossings / (float)std::max(1, n - 1);
+    return s;
+}
+
+static bool IsSpeech(const FrameStats& f, float floorDb) {
+    const float threshold = floorDb + (float)ConfigReader::g_Settings.Vad_Threshold_Db;
+    if (f.db < threshold) return false;
+    return f.zcr < HISS_ZCR || f.db > threshold + LOUD_MARGIN_DB;
+}
+
+// Feeds one full frame to the stream detector
+static VadEvent StreamFrame(const float* frame) {
+    FrameStats f = Measure(frame, FRAME);
+    bool speech = IsSpeech(f, g_floor_db);
+    if (!speech) {
+        g_floor_db = (f.db < g_floor_db) ? f.db : g_floor_db + FLOOR_RISE_DB;
+        g_floor_db = std::min(g_floor_db, FLOOR_CAP_DB);
+    }
+
+    if (!g_in_speech) {
+        g_speech_run = speech ? g_speech_run + 1 : 0;
+        if (g_speech_run >= START_FRAMES) {
+            g_in_speech = true;
+            g_silence_ms = 0;
+            return VadEvent::SPEECH_START;
+        }
+        return VadEvent::NONE;
+    }
+
+    g_silence_ms = speech ? 0 : g_silence_ms + FRAME_MS;
+    if (g_silence_ms >= ConfigReader::g_Settings.Vad_Hangover_Ms) {
+        g_in_speech = false;
+        g_speech_run = 0;
+        return VadEvent::SPEECH_END;
+    }
+    return VadEvent::NONE;
+}
+
+// --- PUBLIC ---
+bool Vad::IsEnabled() {
+    return ConfigReader::g_Settings.Vad_Enabled != 0;
+}
+
+bool Vad::FindSpeech(const float* pcm, size_t count, size_t& begin, size_t& end) {
+    begin = 0;
+    end = count;
+    const size_t frames = count / FRAME;
+    if (!pcm || frames == 0) return false;
+
+    std::vector<FrameStats> stats(frames);
+    std::vector<float> levels(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        stats[i] = Measure(pcm + i * FRAME, FRAME);
+        levels[i] = stats[i].db;
+    }
+    std::nth_element(levels.begin(), levels.begin() + frames / 10, levels.end());
+    const float floorDb = std::min(levels[frames / 10], FLOOR_CAP_DB);
+
+    size_t first = frames, last = 0, speechFrames = 0;
+    for (size_t i = 0; i < frames; ++i) {
+        if (!IsSpeech(stats[i], floorDb)) continue;
+        first = std::min(first, i);
+        last = i;
+        speechFrames++;
+    }
+    if (speechFrames * FRAME_MS < (size_t)std::max(0, ConfigReader::g_Settings.Vad_Min_Speech_Ms)) return false;
+
+    const size_t pad = (size_t)std::max(0, ConfigReader::g_Settings.Vad_Pad_Ms) * (WHISPER_SAMPLE_RATE / 1000);
+    begin = (first * FRAME > pad) ? first * FRAME - pad : 0;
+    end = std::min(count, (last + 1) * FRAME + pad);
+    return true;
+}
+
+void Vad::ResetStream() {
+    g_floor_db = -60.0f;
+    g_in_speech = false;
+    g_speech_run = 0;
+    g_silence_ms = 0;
+    g_carry_n = 0;
+}
+
+VadEvent Vad::Feed(const float* pcm, size_t count) {
+    VadEvent result = VadEvent::NONE;
+    size_t i = 0;
+    // Complete the frame left over from the last call
+    if (g_carry_n > 0) {
+        size_t take = std::min(count, (size_t)(FRAME - g_carry_n));
+        std::copy(pcm, pcm + take, g_carry + g_carry_n);
+        g_carry_n += (int)take;
+        i = take;
+        if (g_carry_n < FRAME) return result;
+        g_carry_n = 0;
+        VadEvent ev = StreamFrame(g_carry);
+        if (ev != VadEvent::NONE) result = ev;
+    }
+    for (; i + FRAME <= count; i += FRAME) {
+        VadEvent ev = StreamFrame(pcm + i);
+        if (ev != VadEvent::NONE) result = ev;
+    }
+    std::copy(pcm + i, pcm + count, g_carry);
+    g_carry_n = (int)(count - i);
+    return result;
+}
+
+bool Vad::InSpeech() {
+    return g_in_speech;
+}
@@ -0,0 +1,24 @@
+#pragma once
+// Vad.h
+#include <cstddef>
+
+enum class VadEvent { NONE, SPEECH_START, SPEECH_END };
+
+// Voice activity detection on 16 kHz mono float audio in 20 ms frames. A frame is speech
+// when its level is Vad_Threshold_Db above the noise floor; quiet frames also need a
+// zero-crossing rate below that of broadband hiss.
+class Vad {
+public:
+    // vad_enabled=1
+    static bool IsEnabled();
+
+    // Finished clip: speech range [begin, end) with Vad_Pad_Ms on either side.
+    // False if the clip holds less than Vad_Min_Speech_Ms of speech.
+    static bool FindSpeech(const float* pcm, size_t count, size_t& begin, size_t& end);
+
+    // --- OPEN MIC (script thread) ---
+    static void ResetStream();
+    // Feeds newly captured samples. SPEECH_END follows Vad_Hangover_Ms of silence.
+    static VadEvent Feed(const float* pcm, size_t count);
+    static bool InSpeech();
+};
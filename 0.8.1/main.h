@@ -39,9 +39,25 @@
 // ------------------------------------------------------------
 #include "ConfigReader.h"       
 #include "AbstractCalls.h"      
+#include "AsyncLogger.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "ResourceMonitor.h"
+#include "MemoryGovernor.h"
+#include "CpuGovernor.h"
+#include "TaskPool.h"
+#include "EventQueue.h"
+#include "SttStream.h"
+#include "Vad.h"
+#include "SttBench.h"
+#include "SentenceStream.h"
 #include "EntityRegistry.h"    
 #include "ConversationSystem.h" 
 #include "LLM_Inference.h"      
+#include "SpeculativeDecoding.h"
+#include "BatchScheduler.h"
+#include "AmbientDialogue.h"
+#include "TargetPredictor.h"
 #include "ModHelpers.h"
 #include "helperfunctions.h"
 #include "OptChatMem.h"
@@ -95,7 +111,7 @@ extern std::string LOG_FILE_NAME3;
 // LLM
 extern llama_model* g_model;
 extern llama_context* g_ctx;
-extern std::future<std::string> g_llm_future;
+extern uint64_t g_llm_ticket; // REPLY_READY of the running interactive request (0 = none)
 extern std::string g_llm_response;
 extern std::chrono::high_resolution_clock::time_point g_response_start_time;
 extern std::chrono::high_resolution_clock::time_point g_llm_start_time;
@@ -107,8 +123,8 @@ extern float g_current_tps;
 extern struct whisper_context* g_whisper_ctx;
 extern std::vector<float> g_audio_buffer;
 extern ma_device g_capture_device;
-extern bool g_is_recording;
-extern std::future<std::string> g_stt_future;
+extern std::atomic<bool> g_is_recording;
+extern TaskHandle<std::string> g_stt_future;
 
 // ------------------------------------------------------------
 // 6. FUNCTION PROTOTYPES (Exports for ModMain)
@@ -123,11 +139,19 @@ void LogSystemMetrics(const std::string& ctx);
 // Lifecycle
 extern "C" __declspec(dllexport) void ScriptMain();
 void TERMINATE();
-void EndConversation();
+// stopVoice: cut the NPC's queued and playing lines (false keeps a farewell playing)
+void EndConversation(bool stopVoice = true);
+// Queues the NPC's reply to 'prompt'; the result arrives as REPLY_READY
+void SubmitReply(const std::string& prompt);
+// Loads system block + history of the current chat into the KV ahead of the next request
+void PrefillNextTurn(AHandle playerPed);
+// The open mic is recording but hasn't heard speech yet (nothing decodes, nothing to transcribe)
+bool IsOpenMicListening();
 bool IsGameInSafeMode();
 std::string GetModRootPath();
 bool DoesFileExist(const std::string& p);
 bool IsKeyJustPressed(int vk);
+std::string GetOrAssignNpcVoiceId(AHandle targetPed);
 extern ChatID g_current_chat_ID;
 
 #endif
\ No newline at end of file
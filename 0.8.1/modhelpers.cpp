@@ -19,13 +19,7 @@ using namespace AbstractTypes;
  * @brief Schreibt eine Nachricht in die Log-Datei mit Zeitstempel.
  */
 void LogHelpers(const std::string& message) {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::ofstream log("kkamel.log", std::ios_base::app);
-    if (log.is_open()) {
-        log << "[" << std::put_time(std::localtime(&now_c), "%Y-%m-%d %H:%M:%S") << "] [ModHelpers] " << message << "\n";
-        log.flush();
-    }
+    AsyncLogger::Write(LogFile::MAIN, "ModHelpers", message);
 }
 
 /**
@@ -0,0 +1,116 @@
+// CpuGovernorTest.cpp
+// ------------------------------------------------------------
+// Checks the CpuGovernor policies on fixed topologies (hybrid P/E cores,
+// Cpu_Game_Cores clamping, no topology) and what ApplyToCurrentThread asks
+// the platform for, through a MockCpuPlatform on Linux without the game.
+//
+// Linux:  g++ -std=c++17 -O2 -I.. CpuGovernorTest.cpp ../CpuGovernor.cpp -o cpu_test -pthread
+//         ./cpu_test               (exit code 0 = pass)
+// ------------------------------------------------------------
+
+#include "../CpuGovernor.h"
+#include "../ConfigReader.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// What the mod's HelperFunctions/ConfigReader provide in the game
+ModSettings ConfigReader::g_Settings;
+void Log(const std::string& msg) { fprintf(stderr, "  log: %s\n", msg.c_str()); }
+
+static int g_failures = 0;
+
+static void Check(bool ok, const std::string& what) {
+    fprintf(stderr, "[%s] %s\n", ok ? " ok " : "FAIL", what.c_str());
+    if (!ok) g_failures++;
+}
+
+static std::vector<int> Range(int first, int last) {
+    std::vector<int> out;
+    for (int i = first; i <= last; ++i) out.push_back(i);
+    return out;
+}
+
+// 6 P-cores with two logical processors each (0..11), 8 E-cores (12..19).
+// The E-cores come first, as some firmwares number them.
+static CpuTopology Hybrid() {
+    CpuTopology t;
+    for (int i = 0; i < 8; ++i) t.cores.push_back({ { 12 + i }, 0 });
+    for (int i = 0; i < 6; ++i) t.cores.push_back({ { 2 * i, 2 * i + 1 }, 1 });
+    return t;
+}
+
+// 4 equal cores, no SMT
+static CpuTopology Uniform() {
+    CpuTopology t;
+    for (int i = 0; i < 4; ++i) t.cores.push_back({ { i }, 0 });
+    return t;
+}
+
+int main() {
+    // --- 1. HYBRID: GAME ON THE FIRST P-CORES, LLM ON THE REST, BACKGROUND ON E-CORES ---
+    auto p = CpuGovernor::BuildPolicies(Hybrid(), 2);
+    const auto& llm = p[(int)Workload::LLM];
+    const auto& stt = p[(int)Workload::STT];
+    const auto& tts = p[(int)Workload::TTS];
+    const auto& bg = p[(int)Workload::BACKGROUND];
+    Check(llm.threads == 4 && llm.cpus == Range(4, 11), "LLM gets the 4 P-cores after the game's 2");
+    Check(stt.threads == 2 && stt.cpus == llm.cpus, "STT shares the LLM cores with half the threads");
+    Check(tts.threads == 2 && tts.cpus == Range(12, 19), "TTS on the E-cores");
+    Check(bg.threads == 4 && bg.cpus == Range(12, 19) && bg.priority == WorkPriority::LOW, "background on the E-cores, low priority");
+
+    p = CpuGovernor::BuildPolicies(Hybrid(), -1);
+    Check(p[(int)Workload::LLM].cpus == Range(6, 11), "auto: half of the 6 P-cores stay with the game");
+
+    // --- 2. GAME CORES ARE CLAMPED ---
+    p = CpuGovernor::BuildPolicies(Uniform(), 10);
+    Check(p[(int)Workload::LLM].threads == 1 && p[(int)Workload::LLM].cpus == Range(3, 3), "10 game cores on 4 -> one core left for us");
+    Check(p[(int)Workload::BACKGROUND].cpus == Range(3, 3), "no slow cores -> background on the LLM core");
+    p = CpuGovernor::BuildPolicies(Uniform(), 0);
+    Check(p[(int)Workload::LLM].threads == 4 && p[(int)Workload::LLM].cpus == Range(0, 3), "0 game cores -> all 4");
+    p = CpuGovernor::BuildPolicies(Hybrid(), 6);
+    Check(p[(int)Workload::LLM].cpus == Range(12, 19), "all P-cores to the game -> LLM falls back to the E-cores");
+
+    // --- 3. EMPTY TOPOLOGY: LEGACY THREAD COUNTS, NO AFFINITY ---
+    p = CpuGovernor::BuildPolicies(CpuTopology(), 2);
+    bool legacy = true;
+    for (const auto& w : p) legacy = legacy && w.threads == 4 && w.cpus.empty();
+    Check(legacy, "no topology -> 4 threads everywhere, no affinity");
+    Check(p[(int)Workload::BACKGROUND].priority == WorkPriority::LOW, "background still low priority");
+
+    // --- 4. APPLY TO THE CALLING THREAD ---
+    ConfigReader::g_Settings.Cpu_Governor = 1;
+    ConfigReader::g_Settings.Cpu_Game_Cores = 2;
+    auto owned = std::make_unique<MockCpuPlatform>(Hybrid());
+    MockCpuPlatform* mock = owned.get(); // owned by the governor until the next Initialize
+    CpuGovernor::Initialize(std::move(owned));
+    Check(CpuGovernor::IsEnabled(), "governor on with a topology");
+    CpuGovernor::ApplyToCurrentThread(Workload::BACKGROUND);
+    Check(mock->lastPriority == WorkPriority::LOW && mock->lastAffinity == Range(12, 19), "background thread: low priority on the E-cores");
+    CpuGovernor::ApplyToCurrentThread(Workload::LLM);
+    Check(mock->lastPriority == WorkPriority::NORMAL && mock->lastAffinity == Range(4, 11), "LLM thread: normal priority on its P-cores");
+    {
+        ScopedWorkload whisper(Workload::STT);
+        Check(CpuGovernor::ThreadsFor(Workload::LLM) == 2, "a running transcription takes its threads from the LLM");
+    }
+    Check(CpuGovernor::ThreadsFor(Workload::LLM) == 4, "... and gives them back");
+
+    // --- 5. NO TOPOLOGY OR GOVERNOR OFF: THREADS ARE LEFT ALONE ---
+    owned = std::make_unique<MockCpuPlatform>(CpuTopology());
+    mock = owned.get();
+    CpuGovernor::Initialize(std::move(owned));
+    CpuGovernor::ApplyToCurrentThread(Workload::BACKGROUND);
+    Check(!CpuGovernor::IsEnabled() && mock->lastAffinity.empty() && mock->lastPriority == WorkPriority::NORMAL, "empty topology -> governor off, nothing applied");
+    Check(CpuGovernor::ThreadsFor(Workload::LLM) == 4, "empty topology -> legacy LLM threads");
+
+    ConfigReader::g_Settings.Cpu_Governor = 0;
+    owned = std::make_unique<MockCpuPlatform>(Hybrid());
+    mock = owned.get();
+    CpuGovernor::Initialize(std::move(owned));
+    CpuGovernor::ApplyToCurrentThread(Workload::LLM);
+    Check(!CpuGovernor::IsEnabled() && mock->lastAffinity.empty(), "Cpu_Governor=0 -> nothing applied");
+
+    fprintf(stderr, g_failures ? "%d check(s) failed\n" : "PASS\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// ResourceMonitorTest.cpp
+// ------------------------------------------------------------
+// Drives the ResourceMonitor sampler with a MockResourceProvider through the
+// VRAM levels the MemoryGovernor reacts to (free < memory_low_mb = pressure,
+// free > headroom = room to grow), on Linux without the game.
+//
+// Linux:  g++ -std=c++17 -O2 -I.. ResourceMonitorTest.cpp ../ResourceMonitor.cpp -o resource_test -pthread
+//         ./resource_test          (exit code 0 = pass)
+// ------------------------------------------------------------
+
+#include "../ResourceMonitor.h"
+#include "../AsyncLogger.h"
+#include "../ConfigReader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// What the mod's HelperFunctions/AsyncLogger/ConfigReader provide in the game
+ModSettings ConfigReader::g_Settings;
+std::atomic<int> AsyncLogger::g_Level{ (int)LogLevel::INFO };
+void Log(const std::string& msg) { fprintf(stderr, "  log: %s\n", msg.c_str()); }
+
+static int g_failures = 0;
+
+static void Check(bool ok, const std::string& what) {
+    fprintf(stderr, "[%s] %s\n", ok ? " ok " : "FAIL", what.c_str());
+    if (!ok) g_failures++;
+}
+
+// Same test as MemoryGovernor::Update
+static bool UnderPressure() {
+    float freeMB = ResourceMonitor::GetFreeVRAM_MB(-1.0f);
+    return freeMB >= 0.0f && freeMB < (float)ConfigReader::g_Settings.Memory_Low_MB;
+}
+
+// The sampler picks up a change within one interval; wait for up to three
+static bool WaitFor(bool (*cond)()) {
+    for (int i = 0; i < 30; ++i) {
+        if (cond()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ConfigReader::g_Settings.Telemetry_Interval_Ms / 10));
+    }
+    return cond();
+}
+
+int main() {
+    ConfigReader::g_Settings.Telemetry_Interval_Ms = 100;
+    ConfigReader::g_Settings.Memory_Low_MB = 1024;
+
+    // --- 1. FIRST SAMPLE ON START ---
+    auto owned = std::make_unique<MockResourceProvider>(900.0f, 2000.0f, 6000.0f);
+    MockResourceProvider* mock = owned.get(); // valid until Stop
+    ResourceMonitor::Start(std::move(owned));
+    ResourceSample s = ResourceMonitor::Latest();
+    Check(s.ramValid && s.ramMB == 900.0f, "RAM sampled by Start");
+    Check(s.vramValid && ResourceMonitor::GetFreeVRAM_MB(-1.0f) == 4000.0f, "free VRAM = budget - used");
+    Check(!UnderPressure(), "4000 MB free is no pressure");
+
+    // --- 2. PRESSURE FROM THE SAMPLER THREAD ---
+    mock->Set(950.0f, 5600.0f, 6000.0f);
+    Check(WaitFor(UnderPressure), "400 MB free is pressure (sampler thread)");
+    Check(ResourceMonitor::GetRAM_MB() == 950.0f, "RAM follows");
+
+    // --- 3. REFRESH SAMPLES RIGHT AWAY ---
+    mock->Set(950.0f, 5000.0f, 6000.0f);
+    ResourceMonitor::Refresh();
+    Check(ResourceMonitor::GetFreeVRAM_MB(-1.0f) == 1000.0f, "Refresh samples on the calling thread");
+    Check(UnderPressure(), "1000 MB free is still below 1024");
+
+    // --- 4. PRESSURE EASES ---
+    mock->Set(950.0f, 1000.0f, 6000.0f);
+    Check(WaitFor([] { return !UnderPressure(); }), "5000 MB free, pressure gone");
+
+    // --- 5. A FAILED VRAM READING KEEPS THE LAST ONE ---
+    mock->Set(950.0f, 5900.0f, 0.0f);
+    ResourceMonitor::Refresh();
+    Check(ResourceMonitor::HasVRAM() && ResourceMonitor::GetFreeVRAM_MB(-1.0f) == 5000.0f, "no budget -> last reading stays");
+
+    // --- 6. RESTART WITHOUT VRAM: FALLBACK ---
+    ResourceMonitor::Stop();
+    ResourceMonitor::Start(std::make_unique<MockResourceProvider>(500.0f, 0.0f, 0.0f));
+    Check(!ResourceMonitor::HasVRAM() && ResourceMonitor::GetFreeVRAM_MB(-1.0f) == -1.0f, "new provider without VRAM -> fallback");
+    Check(!UnderPressure(), "no reading is never pressure");
+    Check(ResourceMonitor::GetRAM_MB() == 500.0f, "RAM of the new provider");
+    ResourceMonitor::Stop();
+
+    fprintf(stderr, g_failures ? "%d check(s) failed\n" : "PASS\n", g_failures);
+    return g_failures ? 1 : 0;
+}
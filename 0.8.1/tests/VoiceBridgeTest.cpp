@@ -0,0 +1,157 @@
+// VoiceBridgeTest.cpp
+// ------------------------------------------------------------
+// Host/client test of the VoiceBridge queue across two processes, on the
+// POSIX stand-in of SharedData.h (shm_open + named semaphore). The host is
+// the main mod side, the client the audio DLL side; the client is started as
+// a separate process (fork + exec) and only shares the named mapping.
+//
+// Linux:  g++ -std=c++17 -O2 -I.. VoiceBridgeTest.cpp -o bridge_test -pthread
+//         ./bridge_test            (exit code 0 = pass)
+//
+// 1. Order: 20000 jobs arrive in order with the right voice, while the queue
+//    (8 slots) is full most of the time.
+// 2. Wake-up: the client sleeps in WaitForJob; a wait that runs into its
+//    timeout and then finds a job means Send's signal was lost.
+// 3. Cancel: CancelPending marks the job being "played" as cancelled and the
+//    queued ones are skipped by CheckForJob.
+// ------------------------------------------------------------
+
+#include "../AbstractTypes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// SharedData.h reads the game clock on the host side
+namespace AbstractGame {
+    AbstractTypes::TimeMillis GetTimeMs() {
+        using namespace std::chrono;
+        return (AbstractTypes::TimeMillis)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+#include "../SharedData.h"
+
+static const int ORDER_JOBS = 20000;
+static const uint32_t WAIT_MS = 200;
+static const int CANCELLED_JOBS = 5;
+
+static uint64_t NowMs() { return AbstractGame::GetTimeMs(); }
+
+static int Fail(const char* side, const std::string& what) {
+    fprintf(stderr, "[%s] FAIL: %s\n", side, what.c_str());
+    return 1;
+}
+
+// ------------------------------------------------------------
+// CLIENT (audio DLL side)
+// ------------------------------------------------------------
+static int RunClient() {
+    VoiceBridge bridge(false);
+    if (!bridge.IsConnected()) return Fail("client", "could not open the shared memory");
+    bridge.SetState(AudioJobState::IDLE);
+
+    std::string text, voice;
+    float speed = 0.0f;
+    int next = 0, idle = 0, lostWakeups = 0;
+
+    // --- 1 + 2: ORDER AND WAKE-UP ---
+    while (next < ORDER_JOBS) {
+        uint64_t start = NowMs();
+        bool got = bridge.WaitForJob(WAIT_MS);
+        // A Send landing right at the timeout looks the same, so allow a few
+        if (got && NowMs() - start >= WAIT_MS - 10 && ++lostWakeups > 3)
+            return Fail("client", "lost wake-ups at " + std::to_string(next));
+        if (!got) {
+            if (++idle > 25) return Fail("client", "no job for 5 s at " + std::to_string(next));
+            continue;
+        }
+        idle = 0;
+
+        while (bridge.CheckForJob(text, voice, speed)) {
+            if (text != std::to_string(next)) return Fail("client", "got " + text + ", expected " + std::to_string(next));
+            if (voice != "v" + std::to_string(next % 7)) return Fail("client", "wrong voice " + voice);
+            if (next % 997 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2)); // let the queue fill up
+            bridge.CompleteJob();
+            next++;
+        }
+    }
+
+    // --- 3: CANCEL ---
+    if (!bridge.WaitForJob(5000) || !bridge.CheckForJob(text, voice, speed) || text != "hold")
+        return Fail("client", "no hold job");
+    uint32_t holdJob = bridge.CurrentJob();
+    bridge.SetState(AudioJobState::PLAYING);
+
+    // The host queues more jobs and cancels them while this one "plays"
+    for (int i = 0; i < 100 && !bridge.IsCancelled(holdJob); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (!bridge.IsCancelled(holdJob)) return Fail("client", "playing job was not cancelled");
+    bridge.CompleteJob();
+
+    if (!bridge.WaitForJob(5000) || !bridge.CheckForJob(text, voice, speed))
+        return Fail("client", "no job after the cancel");
+    if (text != "after") return Fail("client", "cancelled job delivered: " + text);
+    if (bridge.IsCancelled(bridge.CurrentJob())) return Fail("client", "job after the cancel is cancelled");
+    bridge.CompleteJob();
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// HOST (main mod side)
+// ------------------------------------------------------------
+static int RunHost(const char* self) {
+    VoiceBridge bridge(true);
+    if (!bridge.IsConnected()) return Fail("host", "could not create the shared memory");
+
+    pid_t pid = fork();
+    if (pid < 0) return Fail("host", "fork failed");
+    if (pid == 0) {
+        execl(self, self, "client", (char*)NULL);
+        _exit(127);
+    }
+
+    // --- 1 + 2: ORDER AND WAKE-UP ---
+    int sent = 0, full = 0;
+    while (sent < ORDER_JOBS) {
+        // Pauses now and then so the client goes back to sleep in WaitForJob
+        if (sent % 1000 == 999) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (bridge.Send(std::to_string(sent), "v" + std::to_string(sent % 7))) sent++;
+        else { full++; std::this_thread::sleep_for(std::chrono::microseconds(100)); }
+    }
+    for (int i = 0; i < 500 && bridge.GetCompletedJobs() < (uint32_t)ORDER_JOBS; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // --- 3: CANCEL ---
+    bridge.Send("hold", "v0");
+    for (int i = 0; i < 500 && bridge.GetState() != AudioJobState::PLAYING; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (int i = 0; i < CANCELLED_JOBS; ++i) bridge.Send("cancelled " + std::to_string(i), "v0");
+    bridge.CancelPending();
+    bridge.Send("after", "v0");
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    int code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+
+    fprintf(stderr, "[host] sent %d (queue full %d times), completed %u, dropped %u, queued %d, state %s\n",
+        sent, full, bridge.GetCompletedJobs(), bridge.GetDroppedJobs(), bridge.GetQueuedJobs(),
+        bridge.GetStatusString().c_str());
+
+    if (code != 0) return Fail("host", "client exited with " + std::to_string(code));
+    if (bridge.GetCompletedJobs() != (uint32_t)ORDER_JOBS + 2) return Fail("host", "completed count");
+    if (bridge.GetQueuedJobs() != 0) return Fail("host", "jobs left in the queue");
+
+    fprintf(stderr, "[host] PASS\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "client") return RunClient();
+    return RunHost(argv[0]);
+}
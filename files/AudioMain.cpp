@@ -2,14 +2,53 @@
 #include "main.h" // For logging, etc.
 #include "SharedData.h"
 #include <memory> // For std::unique_ptr
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 // Include your new engine
 #include "TTS_Interface.h"
 #include "VITS_Engine.h"
+#include "AudioPlayer.h"
+#include "TtsCache.h"
+#include "ThreadExit.h"
 
 // --- GLOBALS ---
 VoiceBridge* bridge = nullptr;
 std::unique_ptr<ITTSEngine> g_tts_engine; // The smart pointer to our engine
+std::string g_tts_engine_name;            // part of the TtsCache key, clips of another engine or model never match
+
+// --- TTS CACHE ---
+#define TTS_CACHE_FOLDER "tts_cache"
+#define TTS_CACHE_MEMORY_BYTES (32u * 1024 * 1024)
+#define TTS_CACHE_DISK_BYTES (256ull * 1024 * 1024)
+
+// --- PLAYBACK QUEUE ---
+// ScriptMain synthesizes, a second thread feeds the AudioPlayer. While sentence N
+// plays, sentence N+1 is already being synthesized.
+#define TTS_SAMPLE_RATE 22050 // output rate of the VITS/Piper voices
+struct PlayClip {
+    uint32_t jobId;
+    std::vector<float> samples;
+};
+std::deque<PlayClip> g_play_queue;
+std::mutex g_play_mutex;
+std::condition_variable g_play_cv;
+std::thread g_play_thread;
+std::atomic<bool> g_play_running{ false };
+std::atomic<bool> g_play_stopped{ false }; // the thread was joined or detached already
+std::atomic<bool> g_play_done{ true };     // PlaybackLoop's last step
+
+// --- SCRIPT EXIT ---
+// DllMain asks ScriptMain to leave its loop, ScriptMain joins playback and closes the
+// device (neither may run under the loader lock) and reports back through g_script_done.
+// Until then the bridge, the engine and the AudioPlayer ring are still in use.
+#define SCRIPT_EXIT_WAIT_MS 2000 // one sentence being synthesized + WaitForJob's poll
+#define JOB_POLL_MS 250
+std::atomic<bool> g_script_exit{ false };
+std::atomic<bool> g_script_done{ true };   // ScriptMain's last step, on every path
 
 // --- The factory that creates the correct engine ---
 void InitInferenceEngine() {
@@ -21,6 +60,7 @@ void InitInferenceEngine() {
     // TODO: Get these paths from your INI file instead of hardcoding
     std::string modelPath = "vctk-vits-onnx/model.onnx";
     std::string configPath = "vctk-vits-onnx/config.yaml";
+    g_tts_engine_name = TtsCache::EngineKey("vits", modelPath);
 
     if (!g_tts_engine->LoadModel(modelPath, configPath)) {
         LogAudio("FATAL: Engine failed to load.");
@@ -32,54 +72,136 @@ void InitInferenceEngine() {
     }
 }
 
-// --- Your Generate and Play function is now much simpler ---
-bool GenerateAndPlayAudio(const std::string& text, const std::string& voiceId, float speed) {
+// Feeds the synthesized jobs into the AudioPlayer ring back to back and reports each
+// one to the bridge once its last sample has been played
+void PlaybackLoop() {
+    std::deque<uint64_t> jobEnds; // ring positions where the jobs still playing end
+    while (true) {
+        PlayClip clip{ 0, {} };
+        {
+            std::unique_lock<std::mutex> lock(g_play_mutex);
+            g_play_cv.wait_for(lock, std::chrono::milliseconds(20), [] { return !g_play_queue.empty() || !g_play_running; });
+            if (!g_play_running) break;
+            if (!g_play_queue.empty()) {
+                clip = std::move(g_play_queue.front());
+                g_play_queue.pop_front();
+            }
+        }
+
+        uint64_t played = AudioPlayer::PlayedSamples();
+        while (!jobEnds.empty() && jobEnds.front() <= played) {
+            jobEnds.pop_front();
+            bridge->CompleteJob();
+        }
+        if (clip.samples.empty()) continue;
+        const std::vector<float>& audio_samples = clip.samples;
+
+        // The host cancelled: cut the sentence playing and skip the synthesized ones
+        if (bridge->IsCancelled(clip.jobId)) {
+            AudioPlayer::Stop();
+            jobEnds.push_back(AudioPlayer::WrittenSamples());
+            continue;
+        }
+
+        bridge->SetState(AudioJobState::PLAYING);
+        size_t offset = 0;
+        while (offset < audio_samples.size() && g_play_running && !bridge->IsCancelled(clip.jobId)) {
+            offset += AudioPlayer::Write(audio_samples.data() + offset, audio_samples.size() - offset);
+            if (offset < audio_samples.size()) Sleep(10); // ring full, the device catches up
+        }
+        if (offset < audio_samples.size()) AudioPlayer::Stop();
+        jobEnds.push_back(AudioPlayer::WrittenSamples());
+    }
+    g_play_done = true;
+}
+
+// Ends the playback thread once, from ScriptMain's exit or DllMain, whichever comes first.
+// Under the loader lock the thread is only detached.
+void StopPlayback(bool inDllMain) {
+    {
+        std::lock_guard<std::mutex> lock(g_play_mutex);
+        g_play_running = false;
+        g_play_queue.clear();
+    }
+    g_play_cv.notify_all();
+    AudioPlayer::Stop(); // silent from the next device period
+    if (g_play_stopped.exchange(true) || !g_play_thread.joinable()) return;
+    if (inDllMain) g_play_thread.detach();
+    else g_play_thread.join();
+}
+
+// Synthesizes one job and hands it to the playback thread (returns before it is heard)
+bool GenerateAudio(const std::string& text, const std::string& voiceId, float speed) {
     if (!g_tts_engine) return false;
     LogAudio("Processing: " + text);
 
-    // 1. Synthesize
-    std::vector<float> audio_samples = g_tts_engine->Synthesize(text, voiceId);
-    if (audio_samples.empty()) {
-        LogAudio("Synthesis returned no audio.");
-        return false;
+    // Greetings, goodbyes and barks repeat a lot, a hit skips the phonemizer and ONNX Runtime
+    std::vector<float> audio_samples;
+    if (!TtsCache::Lookup(g_tts_engine_name, voiceId, text, speed, audio_samples)) {
+        audio_samples = g_tts_engine->Synthesize(text, voiceId);
+        if (audio_samples.empty()) {
+            LogAudio("Synthesis returned no audio.");
+            return false;
+        }
+        TtsCache::Store(g_tts_engine_name, voiceId, text, speed, audio_samples);
     }
 
-    // 2. Play
-    // Your existing code to save the vector<float> to a temp WAV and play it.
-    std::string filename = "temp_tts.wav";
-    WriteWavFile(filename, audio_samples.data(), audio_samples.size(), 22050); // Use correct sample rate
-
-    bridge->SetState(AudioJobState::PLAYING);
-    BOOL playResult = PlaySoundA(filename.c_str(), NULL, SND_FILENAME | SND_SYNC);
+    {
+        std::lock_guard<std::mutex> lock(g_play_mutex);
+        g_play_queue.push_back({ bridge->CurrentJob(), std::move(audio_samples) });
+    }
+    g_play_cv.notify_one();
+    return true;
+}
 
-    return playResult != 0;
+// Last step of ScriptMain, DllMain frees what it used only after this
+static void ScriptFinished() {
+    LogAudio("ScriptMain finished");
+    g_script_done = true;
 }
 
 // --- Your ScriptMain is mostly unchanged, just calls the new Init ---
 void ScriptMain() {
     LogAudio("ScriptMain started");
+    g_script_done = false;
     bridge = new VoiceBridge(false);
-    if (!bridge->IsConnected()) { /* ... */ return; }
+    if (!bridge->IsConnected()) { /* ... */ ScriptFinished(); return; }
 
     InitInferenceEngine(); // Call the new initialization function
 
-    if (!g_tts_engine) { /* ... handle error ... */ return; }
+    if (!g_tts_engine) { /* ... handle error ... */ ScriptFinished(); return; }
+    TtsCache::Initialize(TTS_CACHE_FOLDER, TTS_CACHE_MEMORY_BYTES, TTS_CACHE_DISK_BYTES);
+
+    if (!AudioPlayer::Initialize(TTS_SAMPLE_RATE)) {
+        bridge->SetError("Audio Device Fail");
+        ScriptFinished();
+        return;
+    }
 
     bridge->SetState(AudioJobState::IDLE);
+    g_play_running = true;
+    g_play_done = false;
+    g_play_thread = std::thread(PlaybackLoop);
+
+    // Runs until DllMain asks it to exit; WaitForJob returns at least every JOB_POLL_MS
+    while (!g_script_exit) {
+        // Send signals the job event, a reply starts right away instead of on the next poll
+        if (!bridge->WaitForJob(JOB_POLL_MS)) continue;
 
-    while (true) {
         std::string text, voice;
         float speed;
-        if (bridge->CheckForJob(text, voice, speed)) {
-            if (GenerateAndPlayAudio(text, voice, speed)) {
-                bridge->CompleteJob();
-            }
-            else {
+        while (!g_script_exit && bridge->CheckForJob(text, voice, speed)) {
+            // CompleteJob comes from the playback thread
+            if (!GenerateAudio(text, voice, speed)) {
                 bridge->SetError("Gen Failed");
             }
         }
-        Sleep(50);
     }
+
+    // The device is closed here, ma_device_uninit must not run under the loader lock
+    StopPlayback(false);
+    AudioPlayer::Shutdown();
+    ScriptFinished();
 }
 
 // DllMain remains the same, but cleans up the smart pointer
@@ -88,11 +210,24 @@ BOOL APIENTRY DllMain(HMODULE hInstance, DWORD reason, LPVOID lpReserved) {
     case DLL_PROCESS_ATTACH:
         scriptRegister(hInstance, ScriptMain);
         break;
-    case DLL_PROCESS_DETACH:
+    case DLL_PROCESS_DETACH: {
+        // ScriptMain does the teardown, here nothing is joined and no device is closed
+        g_script_exit = true;
+        bool scriptDone = WaitForThreadExit([] { return g_script_done.load(); }, SCRIPT_EXIT_WAIT_MS);
         scriptUnregister(hInstance);
+        StopPlayback(true); // only detaches, if ScriptMain didn't get to it
+        bool playDone = WaitForThreadExit([] { return g_play_done.load(); });
+        if (!scriptDone || !playDone) {
+            // Still using them: the bridge, the engine and the AudioPlayer ring are left to the process exit
+            LogAudio(std::string("DllMain: ") + (scriptDone ? "Playback" : "ScriptMain") + " still running, audio state not freed");
+            break;
+        }
         g_tts_engine.reset(); // Smart pointer handles cleanup
-        if (bridge) delete bridge;
+        TtsCache::Shutdown();
+        delete bridge;
+        bridge = nullptr;
         break;
     }
+    }
     return TRUE;
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#define MINIAUDIO_IMPLEMENTATION // the audio DLL's only miniaudio translation unit
+#include "miniaudio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "main.h"
+#include "AudioPlayer.h"
+
+// ------------------------------------------------------------
+// AUDIO PLAYER
+// The writer only moves m_write, the device callback only moves m_read.
+// Stop() can't touch m_read itself, so it leaves the write position it
+// wants to skip to and the callback jumps there on its next run.
+// ------------------------------------------------------------
+
+// --- STATE ---
+static ma_device g_device;
+static bool g_initialized = false;
+static uint32_t g_sample_rate = 0;
+// Never destroyed: if ScriptMain didn't get to Shutdown the device callback still reads it
+// during the process exit. Shutdown gives the memory back.
+static std::vector<float>& g_ring = *new std::vector<float>();
+static size_t g_mask = 0;
+alignas(64) static std::atomic<uint64_t> g_write{ 0 }; // total samples written
+alignas(64) static std::atomic<uint64_t> g_read{ 0 };  // total samples played
+static std::atomic<uint64_t> g_flush_to{ 0 }; // everything before this is dropped unplayed
+
+// --- DEVICE CALLBACK (real-time: no locks, no allocation) ---
+static void PlaybackCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount) {
+    float* out = (float*)pOutput;
+    // g_flush_to first: it never passes the g_write loaded after it, so r can't run past w
+    uint64_t flushTo = g_flush_to.load(std::memory_order_acquire);
+    uint64_t w = g_write.load(std::memory_order_acquire);
+    uint64_t r = g_read.load(std::memory_order_relaxed);
+    r = std::min(std::max(r, flushTo), w);
+
+    size_t n = (size_t)std::min<uint64_t>(frameCount, w - r);
+    size_t start = (size_t)(r & g_mask);
+    size_t first = std::min(n, g_ring.size() - start);
+    memcpy(out, g_ring.data() + start, first * sizeof(float));
+    memcpy(out + first, g_ring.data(), (n - first) * sizeof(float));
+    memset(out + n, 0, (frameCount - n) * sizeof(float)); // underrun / idle: silence
+
+    g_read.store(r + n, std::memory_order_release);
+}
+
+// --- PUBLIC ---
+bool AudioPlayer::Initialize(uint32_t sampleRate, uint32_t ringSeconds) {
+    if (g_initialized) return true;
+
+    size_t capacity = 1;
+    while (capacity < (size_t)sampleRate * ringSeconds) capacity <<= 1;
+    g_ring.assign(capacity, 0.0f);
+    g_mask = capacity - 1;
+    g_write = 0;
+    g_read = 0;
+    g_flush_to = 0;
+
+    ma_device_config config = ma_device_config_init(ma_device_type_playback);
+    config.playback.format = ma_format_f32;
+    config.playback.channels = 1;
+    config.sampleRate = sampleRate; // miniaudio converts to the device rate
+    config.dataCallback = PlaybackCallback;
+    config.pUserData = NULL;
+
+    if (ma_device_init(NULL, &config, &g_device) != MA_SUCCESS) {
+        LogAudio("AudioPlayer: Failed to open the playback device.");
+        return false;
+    }
+    if (ma_device_start(&g_device) != MA_SUCCESS) {
+        LogAudio("AudioPlayer: Failed to start the playback device.");
+        ma_device_uninit(&g_device);
+        return false;
+    }
+    g_sample_rate = sampleRate;
+    g_initialized = true;
+    LogAudio("AudioPlayer: Playback device started (" + std::to_string(sampleRate) + " Hz, ring " + std::to_string(capacity) + " samples).");
+    return true;
+}
+
+void AudioPlayer::Shutdown() {
+    if (!g_initialized) return;
+    ma_device_uninit(&g_device);
+    g_initialized = false;
+    std::vector<float>().swap(g_ring);
+}
+
+bool AudioPlayer::IsInitialized() {
+    return g_initialized;
+}
+
+size_t AudioPlayer::Write(const float* samples, size_t count) {
+    if (!g_initialized || count == 0) return 0;
+    uint64_t w = g_write.load(std::memory_order_relaxed);
+    uint64_t r = g_read.load(std::memory_order_acquire);
+    size_t n = std::min(count, g_ring.size() - (size_t)(w - r));
+    if (n == 0) return 0;
+
+    size_t start = (size_t)(w & g_mask);
+    size_t first = std::min(n, g_ring.size() - start);
+    memcpy(g_ring.data() + start, samples, first * sizeof(float));
+    memcpy(g_ring.data(), samples + first, (n - first) * sizeof(float));
+    g_write.store(w + n, std::memory_order_release);
+    return n;
+}
+
+void AudioPlayer::Stop() {
+    g_flush_to.store(g_write.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+uint64_t AudioPlayer::WrittenSamples() {
+    return g_write.load(std::memory_order_acquire);
+}
+
+uint64_t AudioPlayer::PlayedSamples() {
+    return g_read.load(std::memory_order_acquire);
+}
+
+uint32_t AudioPlayer::SampleRate() {
+    return g_sample_rate;
+}
@@ -0,0 +1,29 @@
+#pragma once
+// AudioPlayer.h
+#include <cstddef>
+#include <cstdint>
+
+// Continuous miniaudio output (mono float) fed through a lock-free ring buffer.
+// Clips written one after another play back to back without a gap; when the ring
+// runs dry the device plays silence until the next clip arrives.
+class AudioPlayer {
+public:
+    // Opens and starts the default playback device. ringSeconds bounds how far the
+    // writer can run ahead of the speaker.
+    static bool Initialize(uint32_t sampleRate, uint32_t ringSeconds = 4);
+    static void Shutdown();
+    static bool IsInitialized();
+
+    // --- WRITER (one thread) ---
+    // Copies what fits into the ring, returns the samples taken. Never blocks.
+    static size_t Write(const float* samples, size_t count);
+    // Drops everything written so far and not played yet; the device is silent from its
+    // next period on. Samples written after the call still play.
+    static void Stop();
+
+    // Sample positions since Initialize. A clip that ended at WrittenSamples() has been
+    // heard completely once PlayedSamples() reaches that value.
+    static uint64_t WrittenSamples();
+    static uint64_t PlayedSamples();
+    static uint32_t SampleRate();
+};
@@ -0,0 +1,275 @@
+#include "main.h"
+#include "PhonemeCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// ------------------------------------------------------------
+// PHONEME CACHE
+// File layout (little endian):
+//   u32 magic, u32 version, u32 count, then per word, most recent first:
+//   u8 wordLen, word, u8 phonemeCount, per phoneme u8 len + bytes
+// Words or phonemes longer than 255 bytes are simply not cached.
+// ------------------------------------------------------------
+
+#define PHONEME_CACHE_MAGIC 0x4D454850u // "PHEM"
+#define PHONEME_CACHE_VERSION 1u
+#define PHONEME_CACHE_SAVE_EVERY 64 // new words between two saves, a crash loses at most these
+
+// --- STATE ---
+struct LexiconEntry {
+    std::string word;
+    std::vector<std::string> phonemes;
+};
+
+static std::mutex g_lex_mutex;
+static bool g_lex_ready = false;
+static std::string g_lex_path;
+static size_t g_lex_max = 0;
+static std::list<LexiconEntry> g_lex_lru; // front = most recently used
+static std::unordered_map<std::string, std::list<LexiconEntry>::iterator> g_lex_index;
+static int g_lex_unsaved = 0;
+
+static uint64_t g_lex_hits = 0;
+static uint64_t g_lex_misses = 0;
+static int g_lex_checked = 0;    // sentences compared with g2p(text) this session
+static int g_lex_different = 0;
+
+// --- TOKENIZER ---
+static bool IsWordChar(unsigned char c) {
+    return std::isalnum(c) || c == '\'' || c >= 0x80; // UTF-8 letters stay inside the word
+}
+
+static bool IsPunctuation(unsigned char c) {
+    return c == '.' || c == ',' || c == '!' || c == '?' || c == ';' || c == ':';
+}
+
+struct TextToken {
+    std::string text; // lowercased word or a single punctuation char
+    bool word;
+};
+
+static std::vector<TextToken> Tokenize(const std::string& text) {
+    std::vector<TextToken> tokens;
+    std::string word;
+    for (unsigned char c : text) {
+        if (IsWordChar(c)) {
+            word += (char)std::tolower(c);
+            continue;
+        }
+        if (!word.empty()) {
+            tokens.push_back({ word, true });
+            word.clear();
+        }
+        if (IsPunctuation(c)) tokens.push_back({ std::string(1, (char)c), false });
+        // everything else (spaces, quotes, dashes) only separates words
+    }
+    if (!word.empty()) tokens.push_back({ word, true });
+    return tokens;
+}
+
+static std::string JoinPhonemes(const std::vector<std::string>& phonemes) {
+    std::string s;
+    for (const auto& p : phonemes) s += p;
+    return s;
+}
+
+// --- LEXICON (g_lex_mutex held) ---
+static void InsertWord(const std::string& word, const std::vector<std::string>& phonemes) {
+    if (word.size() > 255 || phonemes.empty() || phonemes.size() > 255) return;
+    for (const auto& p : phonemes) if (p.size() > 255) return;
+
+    auto it = g_lex_index.find(word);
+    if (it != g_lex_index.end()) g_lex_lru.erase(it->second);
+    g_lex_lru.push_front({ word, phonemes });
+    g_lex_index[word] = g_lex_lru.begin();
+
+    while (g_lex_lru.size() > g_lex_max) {
+        g_lex_index.erase(g_lex_lru.back().word);
+        g_lex_lru.pop_back();
+    }
+}
+
+static bool LoadLexicon() {
+    std::ifstream in(g_lex_path, std::ios::binary);
+    if (!in) return false;
+
+    uint32_t header[3] = {};
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != PHONEME_CACHE_MAGIC || header[1] != PHONEME_CACHE_VERSION) {
+        LogAudio("PhonemeCache: Ignoring " + g_lex_path + " (unknown format).");
+        return false;
+    }
+
+    auto readShort = [&in](std::string& out) {
+        uint8_t len = 0;
+        in.read((char*)&len, 1);
+        out.resize(len);
+        if (len) in.read(&out[0], len);
+        return (bool)in;
+    };
+
+    for (uint32_t i = 0; i < header[2] && g_lex_lru.size() < g_lex_max; ++i) {
+        LexiconEntry entry;
+        uint8_t count = 0;
+        if (!readShort(entry.word)) break;
+        in.read((char*)&count, 1);
+        entry.phonemes.resize(count);
+        bool ok = (bool)in;
+        for (auto& p : entry.phonemes) ok = ok && readShort(p);
+        if (!ok) break; // truncated file, keep what was read
+
+        if (g_lex_index.count(entry.word)) continue;
+        g_lex_lru.push_back(std::move(entry)); // file is most recent first
+        g_lex_index[g_lex_lru.back().word] = std::prev(g_lex_lru.end());
+    }
+    return true;
+}
+
+static void SaveLexicon() {
+    std::string tmp = g_lex_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        uint32_t header[3] = { PHONEME_CACHE_MAGIC, PHONEME_CACHE_VERSION, (uint32_t)g_lex_lru.size() };
+        out.write((const char*)header, sizeof(header));
+        for (const auto& entry : g_lex_lru) {
+            uint8_t len = (uint8_t)entry.word.size();
+            uint8_t count = (uint8_t)entry.phonemes.size();
+            out.write((const char*)&len, 1);
+            out.write(entry.word.data(), len);
+            out.write((const char*)&count, 1);
+            for (const auto& p : entry.phonemes) {
+                len = (uint8_t)p.size();
+                out.write((const char*)&len, 1);
+                out.write(p.data(), len);
+            }
+        }
+        if (!out) return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, g_lex_path, ec);
+    if (ec) LogAudio("PhonemeCache: Could not save " + g_lex_path + " (" + ec.message() + ").");
+    else g_lex_unsaved = 0;
+}
+
+// --- PUBLIC ---
+bool PhonemeCache::Initialize(const std::string& path, size_t maxWords) {
+    std::lock_guard<std::mutex> lock(g_lex_mutex);
+    if (g_lex_ready) return true;
+
+    g_lex_path = path;
+    g_lex_max = maxWords > 0 ? maxWords : 1;
+    g_lex_unsaved = 0;
+    g_lex_checked = 0;
+    g_lex_different = 0;
+    LoadLexicon();
+    g_lex_ready = true;
+    LogAudio("PhonemeCache: " + std::to_string(g_lex_lru.size()) + " words loaded from " + path);
+    return true;
+}
+
+void PhonemeCache::Shutdown() {
+    std::lock_guard<std::mutex> lock(g_lex_mutex);
+    if (!g_lex_ready) return;
+    if (g_lex_unsaved > 0) SaveLexicon();
+    LogAudio("PhonemeCache: " + GetStats());
+    g_lex_lru.clear();
+    g_lex_index.clear();
+    g_lex_ready = false;
+}
+
+std::vector<std::string> PhonemeCache::Phonemize(const std::string& text, const G2PFn& g2p) {
+    std::vector<TextToken> tokens = Tokenize(text);
+
+    // Pass 1: collect the words the lexicon doesn't know yet
+    std::vector<std::string> unseen;
+    {
+        std::lock_guard<std::mutex> lock(g_lex_mutex);
+        if (!g_lex_ready) return g2p(text);
+        for (const auto& t : tokens) {
+            if (!t.word) continue;
+            if (g_lex_index.count(t.text)) { g_lex_hits++; continue; }
+            g_lex_misses++;
+            if (std::find(unseen.begin(), unseen.end(), t.text) == unseen.end()) unseen.push_back(t.text);
+        }
+    }
+
+    // Pass 2: run the model for those only, outside the lock (g2p is the slow part).
+    // One call per word: the result of a multi-word call can't be split back reliably.
+    std::vector<std::pair<std::string, std::vector<std::string>>> fresh;
+    for (const auto& word : unseen) fresh.push_back({ word, g2p(word) });
+
+    // Pass 3: assemble the sentence
+    std::vector<std::string> out;
+    std::string missing; // a word g2p had nothing for
+    bool verify = false;
+    {
+        std::lock_guard<std::mutex> lock(g_lex_mutex);
+        for (const auto& f : fresh) {
+            if (f.second.empty()) continue;
+            InsertWord(f.first, f.second);
+            g_lex_unsaved++;
+        }
+
+        for (const auto& t : tokens) {
+            if (!t.word) {
+                out.push_back(t.text); // punctuation sticks to the word before it
+                continue;
+            }
+            if (!out.empty()) out.push_back(" ");
+
+            auto it = g_lex_index.find(t.text);
+            if (it != g_lex_index.end()) {
+                g_lex_lru.splice(g_lex_lru.begin(), g_lex_lru, it->second);
+                out.insert(out.end(), it->second->phonemes.begin(), it->second->phonemes.end());
+                continue;
+            }
+            // Not cacheable (too long, or pushed out again by this very sentence)
+            auto f = std::find_if(fresh.begin(), fresh.end(), [&t](const auto& x) { return x.first == t.text; });
+            if (f != fresh.end() && !f->second.empty()) out.insert(out.end(), f->second.begin(), f->second.end());
+            else if (missing.empty()) missing = t.text;
+        }
+
+        if (g_lex_unsaved >= PHONEME_CACHE_SAVE_EVERY) SaveLexicon();
+        verify = missing.empty() && g_lex_checked < PHONEME_CACHE_VERIFY_LINES;
+        if (verify) g_lex_checked++;
+    }
+
+    // Dropping the word would change what is said, the model gets the whole sentence instead
+    if (!missing.empty()) {
+        LogAudio("PhonemeCache: No phonemes for \"" + missing + "\", phonemizing the whole sentence.");
+        return g2p(text);
+    }
+
+    // The word-by-word assembly must give the model the same input as g2p(text) did
+    if (verify) {
+        std::vector<std::string> whole = g2p(text);
+        if (whole != out) {
+            {
+                std::lock_guard<std::mutex> lock(g_lex_mutex);
+                g_lex_different++;
+            }
+            LogAudio("PhonemeCache: Differs from g2p for \"" + text + "\": cached [" + JoinPhonemes(out) + "] g2p [" + JoinPhonemes(whole) + "]");
+            return whole;
+        }
+    }
+    return out;
+}
+
+std::string PhonemeCache::GetStats() {
+    // Called with and without g_lex_mutex, only reads counters
+    uint64_t total = g_lex_hits + g_lex_misses;
+    int pct = total ? (int)(g_lex_hits * 100 / total) : 0;
+    char buf[160];
+    snprintf(buf, sizeof(buf), "words %zu, hits %llu, misses %llu (%d%% hit), %d/%d checked lines differ",
+        g_lex_lru.size(), (unsigned long long)g_lex_hits, (unsigned long long)g_lex_misses, pct,
+        g_lex_different, g_lex_checked);
+    return buf;
+}
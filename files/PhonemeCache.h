@@ -0,0 +1,35 @@
+#pragma once
+// PhonemeCache.h
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define PHONEME_CACHE_PATH "models/base/phoneme_cache.bin" // next to deep_phonemizer.onnx
+#define PHONEME_CACHE_MAX_WORDS 20000                      // everyday dialogue, roughly 300 bytes per word in memory
+#define PHONEME_CACHE_VERIFY_LINES 20                      // sentences per session also run through g2p(text) and compared
+
+// Word -> phonemes memo in front of the DeepPhonemizer g2p call. Only words not seen
+// before reach the model; the lexicon is kept in a compact binary file between sessions.
+class PhonemeCache {
+public:
+    using G2PFn = std::function<std::vector<std::string>(const std::string&)>;
+
+    // --- LIFECYCLE ---
+    // Loads 'path' if it exists. maxWords bounds the lexicon (least recently used go first).
+    static bool Initialize(const std::string& path, size_t maxWords);
+    // Saves the lexicon if it changed. Safe to call more than once.
+    static void Shutdown();
+
+    // --- PHONEMIZE ---
+    // Splits 'text' into words and punctuation and assembles the sentence from the
+    // cached words, calling g2p once per unseen word. " " separates the words, punctuation
+    // follows its word as a phoneme of its own.
+    // Falls back to g2p(text) when Initialize wasn't called, or when g2p returned nothing
+    // for a word. The first PHONEME_CACHE_VERIFY_LINES sentences are compared with
+    // g2p(text); a difference is logged and the g2p(text) result is used.
+    static std::vector<std::string> Phonemize(const std::string& text, const G2PFn& g2p);
+
+    // "words 812, hits 4410, misses 96 (98% hit), 1/20 checked lines differ"
+    static std::string GetStats();
+};
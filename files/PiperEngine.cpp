@@ -12,6 +12,7 @@ PiperEngine::PiperEngine() {
         const char* phonemizer_path = "models/base/deep_phonemizer.onnx";
         phonemizer_ = std::make_unique<DeepPhonemizer::Session>(phonemizer_path);
         LogAudio("Phonemizer loaded successfully.");
+        PhonemeCache::Initialize(PHONEME_CACHE_PATH, PHONEME_CACHE_MAX_WORDS);
     }
     catch (const std::exception& e) {
         LogAudio("FATAL: PiperEngine failed to load phonemizer: " + std::string(e.what()));
@@ -19,7 +20,9 @@ PiperEngine::PiperEngine() {
     }
 }
 
-PiperEngine::~PiperEngine() {} // std::unique_ptr handles all cleanup automatically
+PiperEngine::~PiperEngine() {
+    PhonemeCache::Shutdown(); // writes the words learned this session, std::unique_ptr handles the rest
+}
 
 // This function is not really needed for this engine type, since voices are loaded on-demand.
 // We implement it to satisfy the contract.
@@ -48,7 +51,8 @@ std::vector<float> PiperEngine::Synthesize(const std::string& text, const std::s
         }
 
         // --- Step 2: Use the Phonemizer (Machine #1) ---
-        std::vector<std::string> phonemes = phonemizer_->g2p(text);
+        // Known words come from the PhonemeCache, only new ones run through the model
+        std::vector<std::string> phonemes = PhonemeCache::Phonemize(text, [this](const std::string& word) { return phonemizer_->g2p(word); });
         if (phonemes.empty()) {
             throw std::runtime_error("G2P returned no phonemes for text: " + text);
         }
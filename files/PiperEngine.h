@@ -4,6 +4,7 @@
 #include <memory> // for std::unique_ptr
 #include <map>
 #include "babylon.h" // The main header from the babylon.lib you built
+#include "PhonemeCache.h"
 
 class PiperEngine : public ITTSEngine {
 public:
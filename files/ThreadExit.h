@@ -0,0 +1,20 @@
+#pragma once
+// ThreadExit.h
+#include <chrono>
+#include <thread>
+
+// Background threads are stopped from DllMain(PROCESS_DETACH), where the loader lock is
+// held. A thread can't finish exiting without that lock, so join() would hang the game.
+// Instead the owner signals its thread, waits here for a flag/counter the thread sets as
+// the very last thing it does, and then detaches the std::thread.
+static const int THREAD_EXIT_WAIT_MS = 500;
+
+// Polls 'exited' every 5 ms for up to timeoutMs. False if it never became true.
+template <typename Pred>
+inline bool WaitForThreadExit(Pred exited, int timeoutMs = THREAD_EXIT_WAIT_MS) {
+    for (int waited = 0; !exited(); waited += 5) {
+        if (waited >= timeoutMs) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
@@ -0,0 +1,307 @@
+#include "main.h"
+#include "TtsCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// ------------------------------------------------------------
+// TTS CACHE
+// Both tiers are addressed by the FNV-1a hash of the normalized key.
+// The full key is stored next to the samples and compared on every
+// hit, so a hash collision is a miss and never the wrong line.
+// Files are written under g_disk_mutex only, after g_cache_mutex is
+// released, so a lookup never waits for a write or a folder scan.
+// ------------------------------------------------------------
+
+#define TTS_CACHE_MAGIC 0x43535445u // "ETSC"
+#define TTS_CACHE_VERSION 1u
+#define TTS_CACHE_STATS_EVERY 50    // lookups between two stats lines in the log
+#define TTS_CACHE_SEEN_MAX 4096     // lines synthesized once and remembered for the second time
+
+// --- STATE ---
+struct CachedClip {
+    uint64_t hash;
+    std::string key;
+    std::vector<float> samples;
+    bool onDisk;
+};
+
+static std::mutex g_cache_mutex;
+static std::mutex g_disk_mutex; // g_disk_bytes, g_disk_files, the files; never taken before g_cache_mutex
+static bool g_cache_ready = false;
+static std::filesystem::path g_cache_dir;
+static size_t g_mem_budget = 0;
+static size_t g_mem_bytes = 0;
+static uint64_t g_disk_budget = 0;
+static uint64_t g_disk_bytes = 0;
+static size_t g_disk_files = 0;
+static std::list<CachedClip> g_lru; // front = most recently used
+static std::unordered_map<uint64_t, std::list<CachedClip>::iterator> g_lru_index;
+static std::unordered_set<uint64_t> g_seen; // synthesized once, no file yet
+
+static uint64_t g_hits_mem = 0;
+static uint64_t g_hits_disk = 0;
+static uint64_t g_misses = 0;
+
+// --- KEY ---
+// Trims and collapses whitespace; case is kept since it can change the prosody
+static std::string NormalizeText(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    bool space = false;
+    for (unsigned char c : text) {
+        if (std::isspace(c)) { space = !out.empty(); continue; }
+        if (space) { out += ' '; space = false; }
+        out += (char)c;
+    }
+    return out;
+}
+
+static std::string MakeKey(const std::string& engine, const std::string& voiceId, const std::string& text, float speed) {
+    int speedPct = (int)(speed * 100.0f + 0.5f); // 1.0 and 1.0001 are the same line
+    return engine + '\x1f' + voiceId + '\x1f' + std::to_string(speedPct) + '\x1f' + NormalizeText(text);
+}
+
+static uint64_t HashKey(const std::string& key) {
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static std::filesystem::path ClipPath(uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tts", (unsigned long long)hash);
+    return g_cache_dir / name;
+}
+
+static size_t ClipBytes(const CachedClip& clip) {
+    return clip.samples.size() * sizeof(float) + clip.key.size() + sizeof(CachedClip);
+}
+
+// --- MEMORY TIER (g_cache_mutex held) ---
+static void EvictToBudget() {
+    while (g_mem_bytes > g_mem_budget && !g_lru.empty()) {
+        g_mem_bytes -= ClipBytes(g_lru.back());
+        g_lru_index.erase(g_lru.back().hash);
+        g_lru.pop_back();
+    }
+}
+
+static void InsertMemory(uint64_t hash, const std::string& key, const std::vector<float>& samples, bool onDisk) {
+    auto it = g_lru_index.find(hash);
+    if (it != g_lru_index.end()) {
+        g_mem_bytes -= ClipBytes(*it->second);
+        g_lru.erase(it->second);
+        g_lru_index.erase(it);
+    }
+    CachedClip clip{ hash, key, samples, onDisk };
+    size_t bytes = ClipBytes(clip);
+    if (bytes > g_mem_budget / 4) return; // one long monologue must not flush every greeting
+
+    g_lru.push_front(std::move(clip));
+    g_lru_index[hash] = g_lru.begin();
+    g_mem_bytes += bytes;
+    EvictToBudget();
+}
+
+// --- DISK TIER ---
+static bool ReadClip(const std::filesystem::path& path, const std::string& key, std::vector<float>& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    uint32_t magic = 0, version = 0, keyLen = 0, count = 0;
+    in.read((char*)&magic, 4);
+    in.read((char*)&version, 4);
+    in.read((char*)&keyLen, 4);
+    if (!in || magic != TTS_CACHE_MAGIC || version != TTS_CACHE_VERSION || keyLen != key.size()) return false;
+
+    std::string storedKey(keyLen, '\0');
+    in.read(&storedKey[0], keyLen);
+    in.read((char*)&count, 4);
+    if (!in || storedKey != key || count == 0) return false;
+
+    out.resize(count);
+    in.read((char*)out.data(), (std::streamsize)count * sizeof(float));
+    return (bool)in;
+}
+
+static uint64_t WriteClip(const std::filesystem::path& path, const std::string& key, const std::vector<float>& samples) {
+    // Written next to the target and renamed, a crash never leaves a half clip behind
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return 0;
+        uint32_t header[3] = { TTS_CACHE_MAGIC, TTS_CACHE_VERSION, (uint32_t)key.size() };
+        uint32_t count = (uint32_t)samples.size();
+        out.write((const char*)header, sizeof(header));
+        out.write(key.data(), key.size());
+        out.write((const char*)&count, 4);
+        out.write((const char*)samples.data(), (std::streamsize)samples.size() * sizeof(float));
+        if (!out) return 0;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return 0;
+    }
+    return sizeof(uint32_t) * 4 + key.size() + samples.size() * sizeof(float);
+}
+
+// Deletes the oldest clips until the folder fits into g_disk_budget (g_disk_mutex held)
+static void TrimDisk() {
+    std::error_code ec;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+    g_disk_bytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(g_cache_dir, ec)) {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != ".tts") continue;
+        g_disk_bytes += entry.file_size(ec);
+        files.push_back({ entry.last_write_time(ec), entry.path() });
+    }
+    g_disk_files = files.size();
+    if (g_disk_bytes <= g_disk_budget) return;
+
+    std::sort(files.begin(), files.end());
+    for (const auto& f : files) {
+        if (g_disk_bytes <= g_disk_budget * 3 / 4) break; // some headroom so this doesn't run on every store
+        uint64_t size = std::filesystem::file_size(f.second, ec);
+        if (std::filesystem::remove(f.second, ec)) {
+            g_disk_bytes -= size;
+            g_disk_files--;
+        }
+    }
+}
+
+// Second time the line is needed: worth a file
+static void PersistClip(uint64_t hash, const std::string& key, const std::vector<float>& samples) {
+    std::lock_guard<std::mutex> lock(g_disk_mutex);
+    std::filesystem::path path = ClipPath(hash);
+    std::error_code ec;
+    bool existed = std::filesystem::exists(path, ec);
+    uint64_t oldSize = existed ? std::filesystem::file_size(path, ec) : 0;
+    uint64_t written = WriteClip(path, key, samples);
+    if (written == 0) return;
+
+    g_disk_bytes += written - oldSize;
+    if (!existed) g_disk_files++;
+    if (g_disk_bytes > g_disk_budget) TrimDisk();
+}
+
+static void MaybeLogStats(uint64_t lookups) {
+    if (lookups % TTS_CACHE_STATS_EVERY == 0) LogAudio("TtsCache: " + TtsCache::GetStats());
+}
+
+// --- PUBLIC ---
+bool TtsCache::Initialize(const std::string& folder, size_t memoryBytes, uint64_t diskBytes) {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    g_cache_dir = folder;
+    g_mem_budget = memoryBytes;
+    g_disk_budget = diskBytes;
+
+    std::error_code ec;
+    std::filesystem::create_directories(g_cache_dir, ec);
+    if (ec) {
+        LogAudio("TtsCache: Could not create " + folder + " (" + ec.message() + "), memory tier only.");
+        g_disk_budget = 0;
+    }
+    else {
+        std::lock_guard<std::mutex> diskLock(g_disk_mutex);
+        TrimDisk();
+    }
+    g_cache_ready = true;
+    LogAudio("TtsCache: Ready, " + std::to_string(g_disk_files) + " clips on disk (" + std::to_string(g_disk_bytes / 1024) + " KB).");
+    return true;
+}
+
+void TtsCache::Shutdown() {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (!g_cache_ready) return;
+    LogAudio("TtsCache: " + GetStats());
+    g_lru.clear();
+    g_lru_index.clear();
+    g_seen.clear();
+    g_mem_bytes = 0;
+    g_cache_ready = false;
+}
+
+std::string TtsCache::EngineKey(const std::string& engine, const std::string& modelPath) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(modelPath, ec);
+    if (ec) size = 0;
+    long long mtime = (long long)std::filesystem::last_write_time(modelPath, ec).time_since_epoch().count();
+    if (ec) mtime = 0;
+    return engine + "|" + modelPath + "|" + std::to_string(size) + "|" + std::to_string(mtime);
+}
+
+bool TtsCache::Lookup(const std::string& engine, const std::string& voiceId, const std::string& text, float speed, std::vector<float>& outSamples) {
+    std::string key = MakeKey(engine, voiceId, text, speed);
+    uint64_t hash = HashKey(key);
+    bool persist = false;
+    {
+        std::lock_guard<std::mutex> lock(g_cache_mutex);
+        if (!g_cache_ready) return false;
+
+        auto it = g_lru_index.find(hash);
+        if (it != g_lru_index.end() && it->second->key == key) {
+            g_lru.splice(g_lru.begin(), g_lru, it->second);
+            outSamples = it->second->samples;
+            persist = g_disk_budget > 0 && !it->second->onDisk;
+            it->second->onDisk = true;
+            g_seen.erase(hash);
+            MaybeLogStats(++g_hits_mem + g_hits_disk + g_misses);
+        }
+        else if (g_disk_budget > 0 && ReadClip(ClipPath(hash), key, outSamples)) {
+            InsertMemory(hash, key, outSamples, true);
+            MaybeLogStats(g_hits_mem + ++g_hits_disk + g_misses);
+            return true;
+        }
+        else {
+            MaybeLogStats(g_hits_mem + g_hits_disk + ++g_misses);
+            return false;
+        }
+    }
+    if (persist) PersistClip(hash, key, outSamples);
+    return true;
+}
+
+void TtsCache::Store(const std::string& engine, const std::string& voiceId, const std::string& text, float speed, const std::vector<float>& samples) {
+    if (samples.empty()) return;
+    std::string key = MakeKey(engine, voiceId, text, speed);
+    uint64_t hash = HashKey(key);
+    {
+        std::lock_guard<std::mutex> lock(g_cache_mutex);
+        if (!g_cache_ready) return;
+
+        // Synthesized before and dropped from memory since: now it gets a file
+        bool again = g_seen.erase(hash) > 0;
+        InsertMemory(hash, key, samples, again);
+        if (g_disk_budget == 0) return;
+        if (!again) {
+            if (g_seen.size() >= TTS_CACHE_SEEN_MAX) g_seen.clear();
+            g_seen.insert(hash);
+            return;
+        }
+    }
+    PersistClip(hash, key, samples);
+}
+
+std::string TtsCache::GetStats() {
+    // Called with and without g_cache_mutex, only reads counters
+    uint64_t total = g_hits_mem + g_hits_disk + g_misses;
+    int pct = total ? (int)((g_hits_mem + g_hits_disk) * 100 / total) : 0;
+    char buf[192];
+    snprintf(buf, sizeof(buf), "mem %llu / disk %llu / miss %llu (%d%% hit), %.1f MB in memory, %zu files",
+        (unsigned long long)g_hits_mem, (unsigned long long)g_hits_disk, (unsigned long long)g_misses, pct,
+        g_mem_bytes / (1024.0 * 1024.0), g_disk_files);
+    return buf;
+}
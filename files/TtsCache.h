@@ -0,0 +1,30 @@
+#pragma once
+// TtsCache.h
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthesized audio keyed by (engine, voiceId, normalized text, speed).
+// Tier 1 is an in-memory LRU bounded in bytes, tier 2 a content-addressed folder
+// (<fnv64 of the key>.tts) that survives restarts. A hit never touches the engine.
+// Most LLM lines are said once, so a clip only gets a file the second time it is
+// needed (a repeated hit, or synthesized again after it left memory).
+class TtsCache {
+public:
+    // --- LIFECYCLE ---
+    // 'folder' is created if missing. Files beyond diskBytes are removed oldest first.
+    static bool Initialize(const std::string& folder, size_t memoryBytes, uint64_t diskBytes);
+    static void Shutdown();
+    // "vits|<model path>|<size>|<mtime>": the engine part of the key, clips of a swapped model never match
+    static std::string EngineKey(const std::string& engine, const std::string& modelPath);
+
+    // --- LOOKUP ---
+    // Memory first, then disk (a disk hit is promoted into memory)
+    static bool Lookup(const std::string& engine, const std::string& voiceId, const std::string& text, float speed, std::vector<float>& outSamples);
+    // Stores into memory, on disk only if the line was synthesized before. Empty clips are ignored.
+    static void Store(const std::string& engine, const std::string& voiceId, const std::string& text, float speed, const std::vector<float>& samples);
+
+    // "mem 12 / disk 3 / miss 20 (43% hit), 1.8 MB in memory, 42 files"
+    static std::string GetStats();
+};
@@ -8,6 +8,7 @@
 #include "VctkEngine.h"
 #include "TTS_Interface.h"
 #include "PiperEngine.h"
+#include "PhonemeCache.h"
 
 class VctkEngine : public ITTSEngine {
 public:
@@ -32,6 +33,7 @@ VctkEngine::VctkEngine() {
     try {
         phonemizer_ = std::make_unique<DeepPhonemizer::Session>("models/base/deep_phonemizer.onnx");
         LogAudio("Phonemizer loaded successfully.");
+        PhonemeCache::Initialize(PHONEME_CACHE_PATH, PHONEME_CACHE_MAX_WORDS);
     }
     catch (const std::exception& e) {
         LogAudio("FATAL: VctkEngine failed to load phonemizer: " + std::string(e.what()));
@@ -39,7 +41,9 @@ VctkEngine::VctkEngine() {
     }
 }
 
-VctkEngine::~VctkEngine() {}
+VctkEngine::~VctkEngine() {
+    PhonemeCache::Shutdown();
+}
 
 // For this engine, LoadModel is very important. It loads the one and only model.
 bool VctkEngine::LoadModel(const std::string& modelPath, const std::string& configPath) {
@@ -69,7 +73,7 @@ std::vector<float> VctkEngine::Synthesize(const std::string& text, const std::st
 
     try {
         // --- Step 1: Phonemize ---
-        std::vector<std::string> phonemes = phonemizer_->g2p(text);
+        std::vector<std::string> phonemes = PhonemeCache::Phonemize(text, [this](const std::string& word) { return phonemizer_->g2p(word); });
         if (phonemes.empty()) {
             throw std::runtime_error("G2P returned no phonemes.");
         }